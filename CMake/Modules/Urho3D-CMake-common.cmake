@@ -89,7 +89,7 @@ if (MINGW AND NOT DEFINED URHO3D_SSE)
 else ()
     set (URHO3D_DEFAULT_SSE TRUE)
 endif ()
-cmake_dependent_option (URHO3D_SSE "Enable SSE instruction set" ${URHO3D_DEFAULT_SSE} "NOT EMSCRIPTEN" FALSE)
+cmake_dependent_option (URHO3D_SSE "Enable SSE2 instruction set (x86 only)" ${URHO3D_DEFAULT_SSE} "NOT EMSCRIPTEN AND NOT ANDROID AND NOT RPI AND NOT IOS" FALSE)
 if (CMAKE_PROJECT_NAME STREQUAL Urho3D)
     cmake_dependent_option (URHO3D_LUAJIT_AMALG "Enable LuaJIT amalgamated build (LuaJIT only)" FALSE "URHO3D_LUAJIT" FALSE)
     cmake_dependent_option (URHO3D_SAFE_LUA "Enable Lua C++ wrapper safety checks (Lua/LuaJIT only)" FALSE "URHO3D_LUA OR URHO3D_LUAJIT" FALSE)
@@ -118,6 +118,7 @@ endif ()
 option (URHO3D_PACKAGING "Enable resources packaging support, on Emscripten default to 1, on other platforms default to 0" ${EMSCRIPTEN})
 option (URHO3D_PROFILING "Enable profiling support" TRUE)
 option (URHO3D_LOGGING "Enable logging support" TRUE)
+option (URHO3D_HASH_DEBUG "Enable StringHash reverse lookup and collision detection (slows down hashing, for debugging)" FALSE)
 option (URHO3D_TESTING "Enable testing support")
 if (URHO3D_TESTING)
     if (EMSCRIPTEN)
@@ -245,7 +246,7 @@ if (URHO3D_TESTING)
     add_definitions (-DURHO3D_TESTING)
 endif ()
 
-# Enable SSE instruction set. Requires Pentium III or Athlon XP processor at minimum.
+# Enable SSE2 instruction set. Requires Pentium 4 or Athlon 64 processor at minimum.
 if (URHO3D_SSE)
     add_definitions (-DURHO3D_SSE)
 endif ()
@@ -288,6 +289,11 @@ if (URHO3D_LOGGING)
     add_definitions (-DURHO3D_LOGGING)
 endif ()
 
+# Disable compile-time string hashing and record all hashed strings for reverse lookup and collision detection
+if (URHO3D_HASH_DEBUG)
+    add_definitions (-DURHO3D_HASH_DEBUG)
+endif ()
+
 # If not on Windows platform, enable Unix mode for kNet library
 if (NOT WIN32)
     add_definitions (-DKNET_UNIX)
@@ -426,8 +432,8 @@ if (MSVC)
     set (CMAKE_CXX_FLAGS_RELEASE ${CMAKE_CXX_FLAGS_RELWITHDEBINFO})
     # SSE flag is redundant if already compiling as 64bit
     if (URHO3D_SSE AND NOT URHO3D_64BIT)
-        set (CMAKE_C_FLAGS "${CMAKE_C_FLAGS} /arch:SSE")
-        set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} /arch:SSE")
+        set (CMAKE_C_FLAGS "${CMAKE_C_FLAGS} /arch:SSE2")
+        set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} /arch:SSE2")
     endif ()
     set (CMAKE_EXE_LINKER_FLAGS_RELWITHDEBINFO "${CMAKE_EXE_LINKER_FLAGS_RELEASE} /OPT:REF /OPT:ICF /DEBUG")
     set (CMAKE_EXE_LINKER_FLAGS_RELEASE "${CMAKE_EXE_LINKER_FLAGS_RELEASE} /OPT:REF /OPT:ICF")
@@ -464,8 +470,8 @@ else ()
             else ()
                 set (DASH_MBIT -m32)
                 if (URHO3D_SSE)
-                    set (CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -msse")
-                    set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -msse")
+                    set (CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -msse -msse2")
+                    set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -msse -msse2")
                 endif ()
             endif ()
             set (CMAKE_C_FLAGS "${CMAKE_C_FLAGS} ${DASH_MBIT}")
@@ -122,6 +122,7 @@ bool noOverwriteMaterial_ = false;
 bool noOverwriteTexture_ = false;
 bool noOverwriteNewerTexture_ = false;
 bool checkUniqueModel_ = true;
+bool compressAnimations_ = false;
 unsigned maxBones_ = 64;
 Vector<String> nonSkinningBoneIncludes_;
 Vector<String> nonSkinningBoneExcludes_;
@@ -248,6 +249,7 @@ void Run(const Vector<String>& arguments)
             "-ct         Check and do not overwrite if texture exists\n"
             "-ctn        Check and do not overwrite if texture has newer timestamp\n"
             "-am         Export all meshes even if identical (scene mode only)\n"
+            "-ca         Compress animations to per-channel keys with 16-bit rotations\n"
         );
     }
     
@@ -389,6 +391,8 @@ void Run(const Vector<String>& arguments)
                 noOverwriteNewerTexture_ = true;
             else if (argument == "am")
                 checkUniqueModel_ = false;
+            else if (argument == "ca")
+                compressAnimations_ = true;
         }
     }
     
@@ -1197,6 +1201,8 @@ void BuildAndSaveAnimations(OutModel* model)
         }
         
         outAnim->SetTracks(tracks);
+        if (compressAnimations_)
+            outAnim->Compress();
         
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
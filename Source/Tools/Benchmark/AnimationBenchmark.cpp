@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Urho3D.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Math/Random.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const unsigned NUM_BONES = 64;
+static const unsigned NUM_KEYFRAMES = 300;
+static const float KEYFRAME_INTERVAL = 1.0f / 30.0f;
+static const unsigned NUM_SAMPLES = 256;
+
+static void SampleTracks(const Animation* animation, PODVector<unsigned>& keyIndices, PODVector<Vector3>& positions,
+    PODVector<Quaternion>& rotations, PODVector<Vector3>& scales, unsigned iterations)
+{
+    float length = animation->GetLength();
+    for (unsigned i = 0; i < keyIndices.Size(); ++i)
+        keyIndices[i] = 0;
+    
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        // Advance the time like an animation state would, wrapping around at the end
+        for (unsigned j = 0; j < NUM_SAMPLES; ++j)
+        {
+            float time = fmodf((float)(i * NUM_SAMPLES + j) * 0.01f, length);
+            for (unsigned k = 0; k < NUM_BONES; ++k)
+                animation->GetTrack(k)->Sample(time, length, true, keyIndices[k * 3], keyIndices[k * 3 + 1], keyIndices[k * 3 + 2],
+                    positions[k], rotations[k], scales[k]);
+        }
+    }
+}
+
+static unsigned GetKeyDataSize(const Animation* animation)
+{
+    unsigned size = 0;
+    for (unsigned i = 0; i < animation->GetNumTracks(); ++i)
+    {
+        const AnimationTrack* track = animation->GetTrack(i);
+        size += track->keyFrames_.Size() * sizeof(AnimationKeyFrame);
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            const AnimationChannel& channel = track->channels_[j];
+            size += channel.times_.Size() * sizeof(float) + channel.vectors_.Size() * sizeof(Vector3) +
+                channel.rotations_.Size() * sizeof(short);
+        }
+    }
+    
+    return size;
+}
+
+void RunAnimationBenchmark(Context* context, unsigned iterations)
+{
+    PrintLine("Operation                            Keyframes    Compressed  Speedup");
+    
+    SetRandomSeed(1);
+    
+    // Build a clip of smoothly moving bones, some of which only rotate and some of which are static
+    Vector<AnimationTrack> tracks(NUM_BONES);
+    for (unsigned i = 0; i < NUM_BONES; ++i)
+    {
+        AnimationTrack& track = tracks[i];
+        track.name_ = "Bone" + String(i);
+        track.nameHash_ = track.name_;
+        track.channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION | CHANNEL_SCALE;
+        
+        Vector3 axis(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+        float speed = i % 4 ? Random(10.0f, 90.0f) : 0.0f;
+        Vector3 offset(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+        
+        for (unsigned j = 0; j < NUM_KEYFRAMES; ++j)
+        {
+            AnimationKeyFrame keyFrame;
+            keyFrame.time_ = j * KEYFRAME_INTERVAL;
+            keyFrame.position_ = i ? offset : offset + Vector3(0.0f, Sin(keyFrame.time_ * 360.0f) * 0.1f, keyFrame.time_);
+            keyFrame.rotation_ = Quaternion(Sin(keyFrame.time_ * speed * 4.0f) * speed, axis.Normalized());
+            keyFrame.scale_ = Vector3::ONE;
+            track.keyFrames_.Push(keyFrame);
+        }
+    }
+    
+    SharedPtr<Animation> keyFrameAnimation(new Animation(context));
+    keyFrameAnimation->SetLength(NUM_KEYFRAMES * KEYFRAME_INTERVAL);
+    keyFrameAnimation->SetTracks(tracks);
+    SharedPtr<Animation> compressedAnimation(new Animation(context));
+    compressedAnimation->SetLength(NUM_KEYFRAMES * KEYFRAME_INTERVAL);
+    compressedAnimation->SetTracks(tracks);
+    compressedAnimation->Compress();
+    
+    PrintLine("Key data " + String(GetKeyDataSize(keyFrameAnimation)) + " bytes, compressed " +
+        String(GetKeyDataSize(compressedAnimation)) + " bytes");
+    
+    PODVector<unsigned> keyIndices(NUM_BONES * 3);
+    PODVector<Vector3> positions(NUM_BONES);
+    PODVector<Quaternion> rotations(NUM_BONES);
+    PODVector<Vector3> scales(NUM_BONES);
+    PODVector<Vector3> compressedPositions(NUM_BONES);
+    PODVector<Quaternion> compressedRotations(NUM_BONES);
+    PODVector<Vector3> compressedScales(NUM_BONES);
+    
+    HiresTimer timer;
+    long long referenceTime, libraryTime;
+    
+    timer.Reset();
+    SampleTracks(keyFrameAnimation, keyIndices, positions, rotations, scales, iterations);
+    referenceTime = timer.GetUSec(true);
+    SampleTracks(compressedAnimation, keyIndices, compressedPositions, compressedRotations, compressedScales, iterations);
+    libraryTime = timer.GetUSec(false);
+    
+    // Report the largest position or rotation component difference of the last sampled pose as the error
+    float maxError = 0.0f;
+    for (unsigned i = 0; i < NUM_BONES; ++i)
+    {
+        Quaternion rotation = rotations[i].DotProduct(compressedRotations[i]) < 0.0f ? -compressedRotations[i] : compressedRotations[i];
+        for (unsigned j = 0; j < 4; ++j)
+            maxError = Max(maxError, Abs(rotations[i].Data()[j] - rotation.Data()[j]));
+        for (unsigned j = 0; j < 3; ++j)
+            maxError = Max(maxError, Abs(positions[i].Data()[j] - compressedPositions[i].Data()[j]));
+    }
+    
+    PrintResult("AnimationTrack::Sample", referenceTime, libraryTime, maxError);
+}
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Urho3D.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <cstdio>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    String suite = arguments.Size() ? arguments[0].ToLower() : String("all");
+    unsigned iterations = arguments.Size() > 1 ? ToUInt(arguments[1]) : 1000;
+    if (!iterations)
+        ErrorExit("Usage: Benchmark [suite] [iterations]\n"
+            "\n"
+            "Suites: all, math, animation, container, string\n"
+            "Iterations default to 1000\n");
+    
+    // Construct the Time subsystem to initialize the high-resolution timer
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    
+    #ifdef URHO3D_SSE
+    PrintLine("SSE enabled\n");
+    #else
+    PrintLine("SSE disabled\n");
+    #endif
+    
+    bool found = false;
+    if (suite == "all" || suite == "math")
+    {
+        RunMathBenchmark(iterations);
+        found = true;
+    }
+    if (suite == "all" || suite == "animation")
+    {
+        if (found)
+            PrintLine("");
+        RunAnimationBenchmark(context, iterations);
+        found = true;
+    }
+    if (suite == "all" || suite == "container")
+    {
+        if (found)
+            PrintLine("");
+        RunContainerBenchmark(iterations);
+        found = true;
+    }
+    if (suite == "all" || suite == "string")
+    {
+        if (found)
+            PrintLine("");
+        RunStringBenchmark(context, iterations);
+        found = true;
+    }
+    
+    if (!found)
+        ErrorExit("Unknown benchmark suite " + suite);
+}
+
+void PrintResult(const char* name, long long referenceUSec, long long libraryUSec, float maxError)
+{
+    char line[256];
+    sprintf(line, "%-32s %10.3f ms %10.3f ms %7.2fx   max error %g", name, referenceUSec / 1000.0f, libraryUSec / 1000.0f,
+        libraryUSec ? (float)referenceUSec / (float)libraryUSec : 0.0f, maxError);
+    PrintLine(line);
+}
@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+namespace Urho3D
+{
+
+class Context;
+
+}
+
+/// Print the timings of a reference and the library implementation of an operation, and the largest difference between their results.
+void PrintResult(const char* name, long long referenceUSec, long long libraryUSec, float maxError);
+
+/// Run the math benchmarks.
+void RunMathBenchmark(unsigned iterations);
+/// Run the animation benchmarks.
+void RunAnimationBenchmark(Urho3D::Context* context, unsigned iterations);
+/// Run the container benchmarks.
+void RunContainerBenchmark(unsigned iterations);
+/// Run the string benchmarks.
+void RunStringBenchmark(Urho3D::Context* context, unsigned iterations);
@@ -0,0 +1,193 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Urho3D.h>
+
+#include <Urho3D/Container/FlatHashMap.h>
+#include <Urho3D/Container/FlatHashSet.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/StringHash.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const unsigned NUM_KEYS = 1024;
+
+/// Stand-in for a heap object used as a pointer key, such as an event receiver.
+struct BenchmarkObject
+{
+    /// Object data.
+    unsigned char data_[64];
+};
+
+// The same operations are run on the chained HashMap / HashSet as the reference and on the flat variants as the library
+// implementation. Each returns a checksum, whose difference between the containers is reported as the error
+
+template <class Map> static unsigned InsertKeys(const PODVector<StringHash>& keys, unsigned iterations)
+{
+    unsigned checksum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        Map map;
+        for (unsigned j = 0; j < keys.Size(); ++j)
+            map[keys[j]] = j;
+        checksum += map.Size();
+    }
+    return checksum;
+}
+
+template <class Map> static unsigned FindKeys(const Map& map, const PODVector<StringHash>& keys, unsigned iterations)
+{
+    unsigned checksum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < keys.Size(); ++j)
+        {
+            typename Map::ConstIterator k = map.Find(keys[j]);
+            if (k != map.End())
+                checksum += k->second_;
+        }
+    }
+    return checksum;
+}
+
+template <class Map> static unsigned EraseKeys(const Map& map, const PODVector<StringHash>& keys, unsigned iterations)
+{
+    unsigned checksum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        Map copy(map);
+        for (unsigned j = 0; j < keys.Size(); j += 2)
+            copy.Erase(keys[j]);
+        checksum += copy.Size();
+    }
+    return checksum;
+}
+
+template <class Map> static unsigned IterateMap(const Map& map, unsigned iterations)
+{
+    unsigned checksum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (typename Map::ConstIterator j = map.Begin(); j != map.End(); ++j)
+            checksum += j->second_;
+    }
+    return checksum;
+}
+
+template <class Set> static unsigned InsertAndFindPointers(const PODVector<BenchmarkObject*>& pointers, unsigned iterations)
+{
+    unsigned checksum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        Set set;
+        for (unsigned j = 0; j < pointers.Size(); j += 2)
+            set.Insert(pointers[j]);
+        for (unsigned j = 0; j < pointers.Size(); ++j)
+            checksum += set.Contains(pointers[j]) ? 1 : 0;
+    }
+    return checksum;
+}
+
+static void PrintChecksums(const char* name, long long referenceUSec, long long libraryUSec, unsigned reference, unsigned library)
+{
+    PrintResult(name, referenceUSec, libraryUSec, reference > library ? (float)(reference - library) : (float)(library - reference));
+}
+
+void RunContainerBenchmark(unsigned iterations)
+{
+    PrintLine("Operation                              HashMap   FlatHashMap  Speedup");
+    
+    PODVector<StringHash> keys(NUM_KEYS);
+    PODVector<StringHash> missingKeys(NUM_KEYS);
+    for (unsigned i = 0; i < NUM_KEYS; ++i)
+    {
+        keys[i] = StringHash("Key" + String(i));
+        missingKeys[i] = StringHash("Missing" + String(i));
+    }
+    
+    Vector<BenchmarkObject> objects(NUM_KEYS);
+    PODVector<BenchmarkObject*> pointers(NUM_KEYS);
+    for (unsigned i = 0; i < NUM_KEYS; ++i)
+        pointers[i] = &objects[i];
+    
+    HashMap<StringHash, unsigned> hashMap;
+    FlatHashMap<StringHash, unsigned> flatHashMap;
+    for (unsigned i = 0; i < NUM_KEYS; ++i)
+    {
+        hashMap[keys[i]] = i;
+        flatHashMap[keys[i]] = i;
+    }
+    
+    HiresTimer timer;
+    long long referenceTime, libraryTime;
+    unsigned reference, library;
+    
+    timer.Reset();
+    reference = InsertKeys<HashMap<StringHash, unsigned> >(keys, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = InsertKeys<FlatHashMap<StringHash, unsigned> >(keys, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Insert", referenceTime, libraryTime, reference, library);
+    
+    timer.Reset();
+    reference = FindKeys(hashMap, keys, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = FindKeys(flatHashMap, keys, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Find existing", referenceTime, libraryTime, reference, library);
+    
+    timer.Reset();
+    reference = FindKeys(hashMap, missingKeys, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = FindKeys(flatHashMap, missingKeys, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Find missing", referenceTime, libraryTime, reference, library);
+    
+    timer.Reset();
+    reference = EraseKeys(hashMap, keys, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = EraseKeys(flatHashMap, keys, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Copy and erase half", referenceTime, libraryTime, reference, library);
+    
+    timer.Reset();
+    reference = IterateMap(hashMap, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = IterateMap(flatHashMap, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Iterate", referenceTime, libraryTime, reference, library);
+    
+    timer.Reset();
+    reference = InsertAndFindPointers<HashSet<BenchmarkObject*> >(pointers, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = InsertAndFindPointers<FlatHashSet<BenchmarkObject*> >(pointers, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Pointer set insert and find", referenceTime, libraryTime, reference, library);
+}
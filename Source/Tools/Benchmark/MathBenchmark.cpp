@@ -0,0 +1,354 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Urho3D.h>
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/Frustum.h>
+#include <Urho3D/Math/Random.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const unsigned NUM_ELEMENTS = 1024;
+
+// Scalar reference implementations of the operations, which the library versions are compared against
+
+static Matrix3x4 Multiply(const Matrix3x4& lhs, const Matrix3x4& rhs)
+{
+    return Matrix3x4(
+        lhs.m00_ * rhs.m00_ + lhs.m01_ * rhs.m10_ + lhs.m02_ * rhs.m20_,
+        lhs.m00_ * rhs.m01_ + lhs.m01_ * rhs.m11_ + lhs.m02_ * rhs.m21_,
+        lhs.m00_ * rhs.m02_ + lhs.m01_ * rhs.m12_ + lhs.m02_ * rhs.m22_,
+        lhs.m00_ * rhs.m03_ + lhs.m01_ * rhs.m13_ + lhs.m02_ * rhs.m23_ + lhs.m03_,
+        lhs.m10_ * rhs.m00_ + lhs.m11_ * rhs.m10_ + lhs.m12_ * rhs.m20_,
+        lhs.m10_ * rhs.m01_ + lhs.m11_ * rhs.m11_ + lhs.m12_ * rhs.m21_,
+        lhs.m10_ * rhs.m02_ + lhs.m11_ * rhs.m12_ + lhs.m12_ * rhs.m22_,
+        lhs.m10_ * rhs.m03_ + lhs.m11_ * rhs.m13_ + lhs.m12_ * rhs.m23_ + lhs.m13_,
+        lhs.m20_ * rhs.m00_ + lhs.m21_ * rhs.m10_ + lhs.m22_ * rhs.m20_,
+        lhs.m20_ * rhs.m01_ + lhs.m21_ * rhs.m11_ + lhs.m22_ * rhs.m21_,
+        lhs.m20_ * rhs.m02_ + lhs.m21_ * rhs.m12_ + lhs.m22_ * rhs.m22_,
+        lhs.m20_ * rhs.m03_ + lhs.m21_ * rhs.m13_ + lhs.m22_ * rhs.m23_ + lhs.m23_
+    );
+}
+
+static Vector3 Multiply(const Matrix3x4& lhs, const Vector3& rhs)
+{
+    return Vector3(
+        (lhs.m00_ * rhs.x_ + lhs.m01_ * rhs.y_ + lhs.m02_ * rhs.z_ + lhs.m03_),
+        (lhs.m10_ * rhs.x_ + lhs.m11_ * rhs.y_ + lhs.m12_ * rhs.z_ + lhs.m13_),
+        (lhs.m20_ * rhs.x_ + lhs.m21_ * rhs.y_ + lhs.m22_ * rhs.z_ + lhs.m23_)
+    );
+}
+
+static Matrix4 Multiply(const Matrix4& lhs, const Matrix4& rhs)
+{
+    const float* l = lhs.Data();
+    const float* r = rhs.Data();
+    float out[16];
+    
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        for (unsigned j = 0; j < 4; ++j)
+            out[i * 4 + j] = l[i * 4] * r[j] + l[i * 4 + 1] * r[4 + j] + l[i * 4 + 2] * r[8 + j] + l[i * 4 + 3] * r[12 + j];
+    }
+    
+    return Matrix4(out);
+}
+
+static Vector4 Multiply(const Matrix4& lhs, const Vector4& rhs)
+{
+    return Vector4(
+        lhs.m00_ * rhs.x_ + lhs.m01_ * rhs.y_ + lhs.m02_ * rhs.z_ + lhs.m03_ * rhs.w_,
+        lhs.m10_ * rhs.x_ + lhs.m11_ * rhs.y_ + lhs.m12_ * rhs.z_ + lhs.m13_ * rhs.w_,
+        lhs.m20_ * rhs.x_ + lhs.m21_ * rhs.y_ + lhs.m22_ * rhs.z_ + lhs.m23_ * rhs.w_,
+        lhs.m30_ * rhs.x_ + lhs.m31_ * rhs.y_ + lhs.m32_ * rhs.z_ + lhs.m33_ * rhs.w_
+    );
+}
+
+static Quaternion Multiply(const Quaternion& lhs, const Quaternion& rhs)
+{
+    return Quaternion(
+        lhs.w_ * rhs.w_ - lhs.x_ * rhs.x_ - lhs.y_ * rhs.y_ - lhs.z_ * rhs.z_,
+        lhs.w_ * rhs.x_ + lhs.x_ * rhs.w_ + lhs.y_ * rhs.z_ - lhs.z_ * rhs.y_,
+        lhs.w_ * rhs.y_ + lhs.y_ * rhs.w_ + lhs.z_ * rhs.x_ - lhs.x_ * rhs.z_,
+        lhs.w_ * rhs.z_ + lhs.z_ * rhs.w_ + lhs.x_ * rhs.y_ - lhs.y_ * rhs.x_
+    );
+}
+
+static BoundingBox Transformed(const BoundingBox& box, const Matrix3x4& transform)
+{
+    Vector3 newCenter = Multiply(transform, box.Center());
+    Vector3 oldEdge = box.Size() * 0.5f;
+    Vector3 newEdge = Vector3(
+        Abs(transform.m00_) * oldEdge.x_ + Abs(transform.m01_) * oldEdge.y_ + Abs(transform.m02_) * oldEdge.z_,
+        Abs(transform.m10_) * oldEdge.x_ + Abs(transform.m11_) * oldEdge.y_ + Abs(transform.m12_) * oldEdge.z_,
+        Abs(transform.m20_) * oldEdge.x_ + Abs(transform.m21_) * oldEdge.y_ + Abs(transform.m22_) * oldEdge.z_
+    );
+    
+    return BoundingBox(newCenter - newEdge, newCenter + newEdge);
+}
+
+static Intersection IsInside(const Frustum& frustum, const BoundingBox& box)
+{
+    Vector3 center = box.Center();
+    Vector3 edge = center - box.min_;
+    bool allInside = true;
+    
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = frustum.planes_[i];
+        float dist = plane.normal_.DotProduct(center) + plane.d_;
+        float absDist = plane.absNormal_.DotProduct(edge);
+        
+        if (dist < -absDist)
+            return OUTSIDE;
+        else if (dist < absDist)
+            allInside = false;
+    }
+    
+    return allInside ? INSIDE : INTERSECTS;
+}
+
+static float MaxError(const float* a, const float* b, unsigned count)
+{
+    float maxError = 0.0f;
+    for (unsigned i = 0; i < count; ++i)
+        maxError = Max(maxError, Abs(a[i] - b[i]));
+    return maxError;
+}
+
+static Vector3 RandomVector3()
+{
+    return Vector3(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f));
+}
+
+static Quaternion RandomRotation()
+{
+    return Quaternion(Random(360.0f), Random(360.0f), Random(360.0f));
+}
+
+static Matrix3x4 RandomTransform()
+{
+    return Matrix3x4(RandomVector3(), RandomRotation(), Vector3(Random(0.5f, 2.0f), Random(0.5f, 2.0f), Random(0.5f, 2.0f)));
+}
+
+void RunMathBenchmark(unsigned iterations)
+{
+    PrintLine("Operation                            Scalar        Library  Speedup");
+    
+    SetRandomSeed(1);
+    
+    PODVector<Matrix3x4> transforms(NUM_ELEMENTS);
+    PODVector<Matrix4> projections(NUM_ELEMENTS);
+    PODVector<Quaternion> rotations(NUM_ELEMENTS);
+    PODVector<Vector3> points(NUM_ELEMENTS);
+    PODVector<Vector4> vectors(NUM_ELEMENTS);
+    PODVector<BoundingBox> boxes(NUM_ELEMENTS);
+    
+    for (unsigned i = 0; i < NUM_ELEMENTS; ++i)
+    {
+        transforms[i] = RandomTransform();
+        projections[i] = RandomTransform().ToMatrix4() * RandomTransform();
+        projections[i].m30_ = Random(-0.1f, 0.1f);
+        projections[i].m31_ = Random(-0.1f, 0.1f);
+        projections[i].m32_ = Random(1.0f, 2.0f);
+        rotations[i] = RandomRotation();
+        points[i] = RandomVector3();
+        vectors[i] = Vector4(RandomVector3(), 1.0f);
+        Vector3 center = RandomVector3();
+        Vector3 halfSize(Random(0.1f, 10.0f), Random(0.1f, 10.0f), Random(0.1f, 10.0f));
+        boxes[i] = BoundingBox(center - halfSize, center + halfSize);
+    }
+    
+    Frustum frustum;
+    frustum.Define(60.0f, 1.0f, 1.0f, 0.1f, 100.0f, Matrix3x4(Vector3(0.0f, 0.0f, -50.0f), Quaternion::IDENTITY, 1.0f));
+    
+    HiresTimer timer;
+    long long referenceTime, libraryTime;
+    
+    // Scene node world transform and skinning matrix products
+    {
+        PODVector<Matrix3x4> reference(NUM_ELEMENTS);
+        PODVector<Matrix3x4> library(NUM_ELEMENTS);
+        
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                reference[j] = Multiply(transforms[j], transforms[(j + i) & (NUM_ELEMENTS - 1)]);
+        }
+        referenceTime = timer.GetUSec(true);
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                library[j] = transforms[j] * transforms[(j + i) & (NUM_ELEMENTS - 1)];
+        }
+        libraryTime = timer.GetUSec(false);
+        
+        PrintResult("Matrix3x4 * Matrix3x4", referenceTime, libraryTime, MaxError(reference[0].Data(), library[0].Data(),
+            NUM_ELEMENTS * 12));
+    }
+    
+    {
+        PODVector<Vector3> reference(NUM_ELEMENTS);
+        PODVector<Vector3> library(NUM_ELEMENTS);
+        
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                reference[j] = Multiply(transforms[(j + i) & (NUM_ELEMENTS - 1)], points[j]);
+        }
+        referenceTime = timer.GetUSec(true);
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                library[j] = transforms[(j + i) & (NUM_ELEMENTS - 1)] * points[j];
+        }
+        libraryTime = timer.GetUSec(false);
+        
+        PrintResult("Matrix3x4 * Vector3", referenceTime, libraryTime, MaxError(reference[0].Data(), library[0].Data(),
+            NUM_ELEMENTS * 3));
+    }
+    
+    {
+        PODVector<Matrix4> reference(NUM_ELEMENTS);
+        PODVector<Matrix4> library(NUM_ELEMENTS);
+        
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                reference[j] = Multiply(projections[j], projections[(j + i) & (NUM_ELEMENTS - 1)]);
+        }
+        referenceTime = timer.GetUSec(true);
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                library[j] = projections[j] * projections[(j + i) & (NUM_ELEMENTS - 1)];
+        }
+        libraryTime = timer.GetUSec(false);
+        
+        PrintResult("Matrix4 * Matrix4", referenceTime, libraryTime, MaxError(reference[0].Data(), library[0].Data(),
+            NUM_ELEMENTS * 16));
+    }
+    
+    {
+        PODVector<Vector4> reference(NUM_ELEMENTS);
+        PODVector<Vector4> library(NUM_ELEMENTS);
+        
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                reference[j] = Multiply(projections[(j + i) & (NUM_ELEMENTS - 1)], vectors[j]);
+        }
+        referenceTime = timer.GetUSec(true);
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                library[j] = projections[(j + i) & (NUM_ELEMENTS - 1)] * vectors[j];
+        }
+        libraryTime = timer.GetUSec(false);
+        
+        PrintResult("Matrix4 * Vector4", referenceTime, libraryTime, MaxError(reference[0].Data(), library[0].Data(),
+            NUM_ELEMENTS * 4));
+    }
+    
+    {
+        PODVector<Quaternion> reference(NUM_ELEMENTS);
+        PODVector<Quaternion> library(NUM_ELEMENTS);
+        
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                reference[j] = Multiply(rotations[j], rotations[(j + i) & (NUM_ELEMENTS - 1)]);
+        }
+        referenceTime = timer.GetUSec(true);
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                library[j] = rotations[j] * rotations[(j + i) & (NUM_ELEMENTS - 1)];
+        }
+        libraryTime = timer.GetUSec(false);
+        
+        PrintResult("Quaternion * Quaternion", referenceTime, libraryTime, MaxError(&reference[0].w_, &library[0].w_,
+            NUM_ELEMENTS * 4));
+    }
+    
+    {
+        PODVector<BoundingBox> reference(NUM_ELEMENTS);
+        PODVector<BoundingBox> library(NUM_ELEMENTS);
+        
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                reference[j] = Transformed(boxes[j], transforms[(j + i) & (NUM_ELEMENTS - 1)]);
+        }
+        referenceTime = timer.GetUSec(true);
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                library[j] = boxes[j].Transformed(transforms[(j + i) & (NUM_ELEMENTS - 1)]);
+        }
+        libraryTime = timer.GetUSec(false);
+        
+        float maxError = 0.0f;
+        for (unsigned i = 0; i < NUM_ELEMENTS; ++i)
+        {
+            maxError = Max(maxError, MaxError(reference[i].min_.Data(), library[i].min_.Data(), 3));
+            maxError = Max(maxError, MaxError(reference[i].max_.Data(), library[i].max_.Data(), 3));
+        }
+        PrintResult("BoundingBox::Transformed", referenceTime, libraryTime, maxError);
+    }
+    
+    {
+        unsigned reference[3] = { 0, 0, 0 };
+        unsigned library[3] = { 0, 0, 0 };
+        
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                ++reference[IsInside(frustum, boxes[j])];
+        }
+        referenceTime = timer.GetUSec(true);
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            for (unsigned j = 0; j < NUM_ELEMENTS; ++j)
+                ++library[frustum.IsInside(boxes[j])];
+        }
+        libraryTime = timer.GetUSec(false);
+        
+        // Report the number of differing results as the error
+        float mismatches = (float)(Abs((int)reference[0] - (int)library[0]) + Abs((int)reference[1] - (int)library[1]) +
+            Abs((int)reference[2] - (int)library[2]));
+        PrintResult("Frustum::IsInside(BoundingBox)", referenceTime, libraryTime, mismatches);
+    }
+}
@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Urho3D.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const unsigned NUM_STRINGS = 1024;
+static const unsigned NUM_NODES = 500;
+static const unsigned NUM_NODE_VARS = 4;
+
+/// Reference string which always allocates its characters from the heap, like String did before short strings were stored inline.
+class HeapString
+{
+public:
+    /// Construct empty.
+    HeapString() :
+        length_(0),
+        capacity_(1),
+        buffer_(new char[1])
+    {
+        buffer_[0] = 0;
+    }
+    
+    /// Construct from a C string.
+    HeapString(const char* str) :
+        length_((unsigned)strlen(str)),
+        capacity_(length_ + 1),
+        buffer_(new char[capacity_])
+    {
+        memcpy(buffer_, str, length_ + 1);
+    }
+    
+    /// Construct from another string.
+    HeapString(const HeapString& str) :
+        length_(str.length_),
+        capacity_(length_ + 1),
+        buffer_(new char[capacity_])
+    {
+        memcpy(buffer_, str.buffer_, length_ + 1);
+    }
+    
+    /// Destruct.
+    ~HeapString()
+    {
+        delete[] buffer_;
+    }
+    
+    /// Assign a string.
+    HeapString& operator = (const HeapString& rhs)
+    {
+        if (&rhs == this)
+            return *this;
+        
+        if (capacity_ < rhs.length_ + 1)
+        {
+            delete[] buffer_;
+            capacity_ = rhs.length_ + 1;
+            buffer_ = new char[capacity_];
+        }
+        length_ = rhs.length_;
+        memcpy(buffer_, rhs.buffer_, length_ + 1);
+        return *this;
+    }
+    
+    /// Return the C string.
+    const char* CString() const { return buffer_; }
+    /// Return length.
+    unsigned Length() const { return length_; }
+    
+private:
+    /// String length.
+    unsigned length_;
+    /// Buffer capacity.
+    unsigned capacity_;
+    /// String buffer.
+    char* buffer_;
+};
+
+// The same operations are run on the heap-allocating reference string and on String. Each returns a checksum, whose
+// difference between the string types is reported as the error
+
+template <class T> static unsigned ConstructStrings(const PODVector<const char*>& sources, unsigned iterations)
+{
+    unsigned checksum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < sources.Size(); ++j)
+        {
+            T str(sources[j]);
+            checksum += str.Length();
+        }
+    }
+    return checksum;
+}
+
+template <class T> static unsigned CopyStrings(const Vector<T>& strings, unsigned iterations)
+{
+    unsigned checksum = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        Vector<T> copy(strings);
+        checksum += copy.Back().Length();
+    }
+    return checksum;
+}
+
+static void PrintChecksums(const char* name, long long referenceUSec, long long libraryUSec, unsigned reference, unsigned library)
+{
+    PrintResult(name, referenceUSec, libraryUSec, reference > library ? (float)(reference - library) : (float)(library - reference));
+}
+
+static void PrintTime(const char* name, long long usec, unsigned count)
+{
+    char line[256];
+    sprintf(line, "%-32s %10.3f ms   %u operations", name, usec / 1000.0f, count);
+    PrintLine(line);
+}
+
+static void CreateBenchmarkScene(Scene* scene)
+{
+    for (unsigned i = 0; i < NUM_NODES; ++i)
+    {
+        Node* node = scene->CreateChild("Node" + String(i));
+        node->SetPosition(Vector3((float)i, 0.0f, 0.0f));
+        for (unsigned j = 0; j < NUM_NODE_VARS; ++j)
+            node->SetVar(StringHash("Var" + String(j)), "Value" + String(i * NUM_NODE_VARS + j));
+    }
+}
+
+void RunStringBenchmark(Context* context, unsigned iterations)
+{
+    PrintLine("Operation                           HeapString        String  Speedup");
+    
+    // Mix of short names like those in scene and attribute data, and some longer ones which do not fit inline
+    Vector<String> sourceStrings(NUM_STRINGS);
+    PODVector<const char*> sources(NUM_STRINGS);
+    for (unsigned i = 0; i < NUM_STRINGS; ++i)
+    {
+        if (i % 8)
+            sourceStrings[i] = "Node" + String(i);
+        else
+            sourceStrings[i] = "Models/LongResourceName" + String(i) + ".mdl";
+        sources[i] = sourceStrings[i].CString();
+    }
+    
+    Vector<HeapString> heapStrings;
+    Vector<String> strings;
+    for (unsigned i = 0; i < NUM_STRINGS; ++i)
+    {
+        heapStrings.Push(HeapString(sources[i]));
+        strings.Push(String(sources[i]));
+    }
+    
+    HiresTimer timer;
+    long long referenceTime, libraryTime;
+    unsigned reference, library;
+    
+    timer.Reset();
+    reference = ConstructStrings<HeapString>(sources, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = ConstructStrings<String>(sources, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Construct", referenceTime, libraryTime, reference, library);
+    
+    timer.Reset();
+    reference = CopyStrings(heapStrings, iterations);
+    referenceTime = timer.GetUSec(true);
+    library = CopyStrings(strings, iterations);
+    libraryTime = timer.GetUSec(false);
+    PrintChecksums("Copy vector", referenceTime, libraryTime, reference, library);
+    
+    // Scene operations have no reference implementation: compare their timings against a build of an earlier engine version
+    PrintLine("");
+    PrintLine("Scene operation                           Time");
+    
+    RegisterSceneLibrary(context);
+    SharedPtr<Scene> scene(new Scene(context));
+    CreateBenchmarkScene(scene);
+    VectorBuffer sceneData;
+    scene->SaveXML(sceneData);
+    
+    unsigned numLoads = Max((int)iterations / 100, 1);
+    timer.Reset();
+    for (unsigned i = 0; i < numLoads; ++i)
+    {
+        sceneData.Seek(0);
+        scene->LoadXML(sceneData);
+    }
+    PrintTime("Scene XML load", timer.GetUSec(false), numLoads);
+    
+    const Vector<SharedPtr<Node> >& children = scene->GetChildren();
+    unsigned length = 0;
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (unsigned j = 0; j < children.Size(); ++j)
+        {
+            Node* node = children[j];
+            length += node->GetAttribute("Name").GetString().Length();
+            length += node->GetAttribute("Is Enabled").GetBool() ? 1 : 0;
+        }
+    }
+    PrintTime("Attribute access by name", timer.GetUSec(false), iterations * children.Size() * 2);
+}
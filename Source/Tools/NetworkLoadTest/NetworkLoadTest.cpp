@@ -0,0 +1,463 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Urho3D.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <cstdio>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+static const unsigned short SERVER_PORT = 2345;
+static const float FRAME_TIME = 1.0f / 60.0f;
+static const unsigned CONNECT_TIMEOUT = 10000;
+static const float WARMUP_TIME = 1.0f;
+static const float OBJECT_SPACING = 4.0f;
+static const float MOVE_RADIUS = 1.5f;
+
+/// Server side of the load test. Owns the scene with the moving objects.
+class LoadTestServer : public Object
+{
+    OBJECT(LoadTestServer);
+    
+public:
+    /// Construct and create the scene.
+    LoadTestServer(Context* context, unsigned numObjects);
+    
+    /// Move the objects and update the replicated clock.
+    void Update(float time, float clockMSec);
+    /// Reset the update time statistics.
+    void ResetStatistics();
+    
+    /// Return total time spent in network updates in microseconds.
+    long long GetUpdateUSec() const { return updateUSec_; }
+    /// Return longest network update in microseconds.
+    long long GetMaxUpdateUSec() const { return maxUpdateUSec_; }
+    /// Return number of network updates.
+    unsigned GetNumUpdates() const { return numUpdates_; }
+    
+private:
+    /// Handle a client connecting.
+    void HandleClientConnected(StringHash eventType, VariantMap& eventData);
+    /// Handle the start of a network update.
+    void HandleNetworkUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle the end of a network update.
+    void HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData);
+    
+    /// Replicated scene.
+    SharedPtr<Scene> scene_;
+    /// Moving objects.
+    PODVector<Node*> objects_;
+    /// Node whose X position is the server clock in milliseconds.
+    Node* clockNode_;
+    /// Network update timer.
+    HiresTimer updateTimer_;
+    /// Total network update time.
+    long long updateUSec_;
+    /// Longest network update time.
+    long long maxUpdateUSec_;
+    /// Number of network updates.
+    unsigned numUpdates_;
+};
+
+/// Client side of the load test, with its own context and scene replica.
+class LoadTestClient : public Object
+{
+    OBJECT(LoadTestClient);
+    
+public:
+    /// Construct.
+    LoadTestClient(Context* context);
+    
+    /// Connect to the server.
+    bool Connect(unsigned short port);
+    /// Sample the age of the replicated clock.
+    void SampleLag(float clockMSec);
+    /// Reset the lag statistics.
+    void ResetStatistics();
+    
+    /// Return whether the scene has been loaded from the server.
+    bool IsSceneLoaded() const;
+    /// Return total sampled lag in milliseconds.
+    double GetLagMSec() const { return lagMSec_; }
+    /// Return longest sampled lag in milliseconds.
+    float GetMaxLagMSec() const { return maxLagMSec_; }
+    /// Return number of lag samples.
+    unsigned GetNumLagSamples() const { return numLagSamples_; }
+    
+private:
+    /// Scene replica.
+    SharedPtr<Scene> scene_;
+    /// Replicated clock node.
+    WeakPtr<Node> clockNode_;
+    /// Total sampled lag.
+    double lagMSec_;
+    /// Longest sampled lag.
+    float maxLagMSec_;
+    /// Number of lag samples.
+    unsigned numLagSamples_;
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+SharedPtr<Context> CreateContext(unsigned numThreads, int latency, float packetLoss);
+void RunFrame(Context* context);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+SharedPtr<Context> CreateContext(unsigned numThreads, int latency, float packetLoss)
+{
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Network(context));
+    RegisterSceneLibrary(context);
+    RegisterNetworkLibrary(context);
+    
+    if (numThreads)
+        context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+    
+    Network* network = context->GetSubsystem<Network>();
+    network->SetSimulatedLatency(latency);
+    network->SetSimulatedPacketLoss(packetLoss);
+    
+    return context;
+}
+
+void RunFrame(Context* context)
+{
+    // Send the same frame events as the engine main loop
+    Time* time = context->GetSubsystem<Time>();
+    time->BeginFrame(FRAME_TIME);
+    
+    // The scenes subscribe to the typed update event, so the events must be sent typed
+    UpdateEventData updateData(FRAME_TIME);
+    time->SendTypedEvent(updateData);
+    PostUpdateEventData postUpdateData(FRAME_TIME);
+    time->SendTypedEvent(postUpdateData);
+    RenderUpdateEventData renderUpdateData(FRAME_TIME);
+    time->SendTypedEvent(renderUpdateData);
+    PostRenderUpdateEventData postRenderUpdateData(FRAME_TIME);
+    time->SendTypedEvent(postRenderUpdateData);
+    
+    time->EndFrame();
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numClients = arguments.Size() > 0 ? ToUInt(arguments[0]) : 8;
+    unsigned numObjects = arguments.Size() > 1 ? ToUInt(arguments[1]) : 500;
+    float duration = arguments.Size() > 2 ? ToFloat(arguments[2]) : 10.0f;
+    int latency = arguments.Size() > 3 ? ToInt(arguments[3]) : 0;
+    float packetLoss = arguments.Size() > 4 ? ToFloat(arguments[4]) : 0.0f;
+    if (!numClients || !numObjects || duration <= 0.0f)
+        ErrorExit("Usage: NetworkLoadTest [clients] [objects] [seconds] [latency ms] [packet loss]\n"
+            "\n"
+            "Runs a headless server and loopback clients in one process, moving the objects every frame.\n"
+            "Latency and packet loss are simulated on both ends of each connection.\n"
+            "Defaults: 8 clients, 500 objects, 10 seconds, no latency or packet loss\n");
+    
+    // The server builds the client updates in worker threads if available
+    unsigned numCPUs = GetNumPhysicalCPUs();
+    SharedPtr<Context> serverContext = CreateContext(numCPUs > 1 ? numCPUs - 1 : 0, latency, packetLoss);
+    Log* log = new Log(serverContext);
+    log->SetLevel(LOG_WARNING);
+    serverContext->RegisterSubsystem(log);
+    
+    SharedPtr<LoadTestServer> server(new LoadTestServer(serverContext, numObjects));
+    Network* serverNetwork = serverContext->GetSubsystem<Network>();
+    if (!serverNetwork->StartServer(SERVER_PORT))
+        ErrorExit("Failed to start server");
+    
+    Vector<SharedPtr<Context> > clientContexts;
+    Vector<SharedPtr<LoadTestClient> > clients;
+    for (unsigned i = 0; i < numClients; ++i)
+    {
+        SharedPtr<Context> context = CreateContext(0, latency, packetLoss);
+        SharedPtr<LoadTestClient> client(new LoadTestClient(context));
+        if (!client->Connect(SERVER_PORT))
+            ErrorExit("Failed to connect client " + String(i));
+        clientContexts.Push(context);
+        clients.Push(client);
+    }
+    
+    char line[256];
+    sprintf(line, "Clients %u objects %u duration %.1f s latency %d ms packet loss %.2f update rate %d FPS\n", numClients,
+        numObjects, duration, latency, packetLoss, serverNetwork->GetUpdateFps());
+    PrintLine(line);
+    
+    HiresTimer testTimer;
+    HiresTimer frameTimer;
+    Timer connectTimer;
+    bool measuring = false;
+    float measureStart = 0.0f;
+    long long serverFrameUSec = 0;
+    long long maxServerFrameUSec = 0;
+    unsigned numServerFrames = 0;
+    double bytesOutPerSec = 0.0;
+    unsigned numByteSamples = 0;
+    float nextByteSample = 0.0f;
+    
+    for (;;)
+    {
+        frameTimer.Reset();
+        float time = testTimer.GetUSec(false) / 1000000.0f;
+        float clockMSec = time * 1000.0f;
+        
+        // Run the server frame, then the client frames
+        server->Update(time, clockMSec);
+        HiresTimer serverTimer;
+        RunFrame(serverContext);
+        long long frameUSec = serverTimer.GetUSec(false);
+        
+        for (unsigned i = 0; i < clients.Size(); ++i)
+        {
+            RunFrame(clientContexts[i]);
+            clients[i]->SampleLag(testTimer.GetUSec(false) / 1000.0f);
+        }
+        
+        if (!measuring)
+        {
+            bool allLoaded = true;
+            for (unsigned i = 0; i < clients.Size(); ++i)
+                allLoaded &= clients[i]->IsSceneLoaded();
+            
+            if (!allLoaded && connectTimer.GetMSec(false) > CONNECT_TIMEOUT)
+                ErrorExit("Timed out waiting for the clients to load the scene");
+            
+            // Wait until all clients have joined and received the initial state before measuring
+            if (allLoaded)
+            {
+                if (measureStart == 0.0f)
+                    measureStart = time + WARMUP_TIME;
+                else if (time >= measureStart)
+                {
+                    measuring = true;
+                    nextByteSample = time + 1.0f;
+                    server->ResetStatistics();
+                    for (unsigned i = 0; i < clients.Size(); ++i)
+                        clients[i]->ResetStatistics();
+                }
+            }
+        }
+        else
+        {
+            serverFrameUSec += frameUSec;
+            if (frameUSec > maxServerFrameUSec)
+                maxServerFrameUSec = frameUSec;
+            ++numServerFrames;
+            
+            // Sample the data rate of the server connections once per second
+            if (time >= nextByteSample)
+            {
+                Vector<SharedPtr<Connection> > connections = serverNetwork->GetClientConnections();
+                for (unsigned i = 0; i < connections.Size(); ++i)
+                {
+                    bytesOutPerSec += connections[i]->GetBytesOutPerSec();
+                    ++numByteSamples;
+                }
+                nextByteSample += 1.0f;
+            }
+            
+            if (time >= measureStart + duration)
+                break;
+        }
+        
+        // Run in real time so that the network simulation and the lag measurement are meaningful
+        long long elapsedUSec = frameTimer.GetUSec(false);
+        long long frameUSecTarget = (long long)(FRAME_TIME * 1000000.0f);
+        if (elapsedUSec < frameUSecTarget)
+            Time::Sleep((unsigned)((frameUSecTarget - elapsedUSec) / 1000));
+    }
+    
+    double lagMSec = 0.0;
+    float maxLagMSec = 0.0f;
+    unsigned numLagSamples = 0;
+    for (unsigned i = 0; i < clients.Size(); ++i)
+    {
+        lagMSec += clients[i]->GetLagMSec();
+        maxLagMSec = Max(maxLagMSec, clients[i]->GetMaxLagMSec());
+        numLagSamples += clients[i]->GetNumLagSamples();
+    }
+    
+    unsigned numUpdates = server->GetNumUpdates();
+    sprintf(line, "Server network update   %8.3f ms avg %8.3f ms max (%u updates)", numUpdates ?
+        server->GetUpdateUSec() / 1000.0 / numUpdates : 0.0, server->GetMaxUpdateUSec() / 1000.0, numUpdates);
+    PrintLine(line);
+    sprintf(line, "Server frame            %8.3f ms avg %8.3f ms max (%u frames)", numServerFrames ?
+        serverFrameUSec / 1000.0 / numServerFrames : 0.0, maxServerFrameUSec / 1000.0, numServerFrames);
+    PrintLine(line);
+    sprintf(line, "Data sent per client    %8.3f KB/s", numByteSamples ? bytesOutPerSec / 1000.0 / numByteSamples : 0.0);
+    PrintLine(line);
+    sprintf(line, "Replication lag         %8.3f ms avg %8.3f ms max", numLagSamples ? lagMSec / numLagSamples : 0.0,
+        (double)maxLagMSec);
+    PrintLine(line);
+    
+    // Disconnect the clients before tearing down the server
+    for (unsigned i = 0; i < clientContexts.Size(); ++i)
+        clientContexts[i]->GetSubsystem<Network>()->Disconnect();
+    serverNetwork->StopServer();
+}
+
+LoadTestServer::LoadTestServer(Context* context, unsigned numObjects) :
+    Object(context),
+    clockNode_(0),
+    updateUSec_(0),
+    maxUpdateUSec_(0),
+    numUpdates_(0)
+{
+    scene_ = new Scene(context_);
+    clockNode_ = scene_->CreateChild("Clock");
+    
+    // Place the objects on a square grid
+    unsigned side = (unsigned)ceilf(sqrtf((float)numObjects));
+    for (unsigned i = 0; i < numObjects; ++i)
+    {
+        Node* node = scene_->CreateChild("Object");
+        node->SetPosition(Vector3((i % side) * OBJECT_SPACING, 0.0f, (i / side) * OBJECT_SPACING));
+        objects_.Push(node);
+    }
+    
+    SubscribeToEvent(E_CLIENTCONNECTED, HANDLER(LoadTestServer, HandleClientConnected));
+    SubscribeToEvent(E_NETWORKUPDATE, HANDLER(LoadTestServer, HandleNetworkUpdate));
+    SubscribeToEvent(E_NETWORKUPDATESENT, HANDLER(LoadTestServer, HandleNetworkUpdateSent));
+}
+
+void LoadTestServer::Update(float time, float clockMSec)
+{
+    // Move every object on a circle, with slightly different speeds
+    unsigned side = (unsigned)ceilf(sqrtf((float)objects_.Size()));
+    for (unsigned i = 0; i < objects_.Size(); ++i)
+    {
+        float angle = time * (30.0f + (i % 7) * 10.0f) + i * 10.0f;
+        Vector3 center((i % side) * OBJECT_SPACING, 0.0f, (i / side) * OBJECT_SPACING);
+        objects_[i]->SetTransform(center + Vector3(Cos(angle), 0.0f, Sin(angle)) * MOVE_RADIUS, Quaternion(angle, Vector3::UP));
+    }
+    
+    clockNode_->SetPosition(Vector3(clockMSec, 0.0f, 0.0f));
+}
+
+void LoadTestServer::ResetStatistics()
+{
+    updateUSec_ = 0;
+    maxUpdateUSec_ = 0;
+    numUpdates_ = 0;
+}
+
+void LoadTestServer::HandleClientConnected(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientConnected;
+    
+    Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+    connection->SetScene(scene_);
+}
+
+void LoadTestServer::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
+{
+    updateTimer_.Reset();
+}
+
+void LoadTestServer::HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData)
+{
+    long long usec = updateTimer_.GetUSec(false);
+    updateUSec_ += usec;
+    if (usec > maxUpdateUSec_)
+        maxUpdateUSec_ = usec;
+    ++numUpdates_;
+}
+
+LoadTestClient::LoadTestClient(Context* context) :
+    Object(context),
+    lagMSec_(0.0),
+    maxLagMSec_(0.0f),
+    numLagSamples_(0)
+{
+    scene_ = new Scene(context_);
+}
+
+bool LoadTestClient::Connect(unsigned short port)
+{
+    return GetSubsystem<Network>()->Connect("127.0.0.1", port, scene_);
+}
+
+void LoadTestClient::SampleLag(float clockMSec)
+{
+    if (!IsSceneLoaded())
+        return;
+    
+    if (!clockNode_)
+        clockNode_ = scene_->GetChild("Clock");
+    if (!clockNode_)
+        return;
+    
+    // The lag is the age of the newest server state seen by the client
+    float lag = clockMSec - clockNode_->GetPosition().x_;
+    lagMSec_ += lag;
+    maxLagMSec_ = Max(maxLagMSec_, lag);
+    ++numLagSamples_;
+}
+
+void LoadTestClient::ResetStatistics()
+{
+    lagMSec_ = 0.0;
+    maxLagMSec_ = 0.0f;
+    numLagSamples_ = 0;
+}
+
+bool LoadTestClient::IsSceneLoaded() const
+{
+    Connection* connection = GetSubsystem<Network>()->GetServerConnection();
+    return connection && connection->IsSceneLoaded();
+}
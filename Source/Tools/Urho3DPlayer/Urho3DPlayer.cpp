@@ -113,6 +113,8 @@ void Urho3DPlayer::Setup()
             "-noshadows   Disable shadow rendering\n"
             "-nolimit     Disable frame limiter\n"
             "-nothreads   Disable worker threads\n"
+            "-allocstats  Count heap allocations per profiling block in the profiler output\n"
+            "-trace <file> Write a Chrome trace of the profiling blocks of all threads to a file on exit\n"
             "-nosound     Disable sound output\n"
             "-noip        Disable sound mixing interpolation\n"
             "-touch       Touch emulation on desktop platform\n"
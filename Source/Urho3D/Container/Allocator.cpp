@@ -29,12 +29,35 @@
 namespace Urho3D
 {
 
+static AllocationHook allocationHook = 0;
+
+void SetAllocationHook(AllocationHook hook)
+{
+    allocationHook = hook;
+}
+
+AllocationHook GetAllocationHook()
+{
+    return allocationHook;
+}
+
+void ReportAllocation(unsigned size)
+{
+    AllocationHook hook = allocationHook;
+    if (hook)
+        hook(size);
+}
+
 AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSize, unsigned capacity)
 {
     if (!capacity)
         capacity = 1;
     
-    unsigned char* blockPtr = new unsigned char[sizeof(AllocatorBlock) + capacity * (sizeof(AllocatorNode) + nodeSize)];
+    unsigned blockSize = sizeof(AllocatorBlock) + capacity * (sizeof(AllocatorNode) + nodeSize);
+    #ifdef URHO3D_PROFILING
+    ReportAllocation(blockSize);
+    #endif
+    unsigned char* blockPtr = new unsigned char[blockSize];
     AllocatorBlock* newBlock = reinterpret_cast<AllocatorBlock*>(blockPtr);
     newBlock->nodeSize_ = nodeSize;
     newBlock->capacity_ = capacity;
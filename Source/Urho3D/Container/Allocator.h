@@ -61,6 +61,16 @@ URHO3D_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 URHO3D_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
 
+/// Function called with the size of each heap allocation made by the container classes.
+typedef void (*AllocationHook)(unsigned size);
+
+/// Set the function to call on container heap allocations, or null to disable. Has effect only when profiling is compiled in.
+URHO3D_API void SetAllocationHook(AllocationHook hook);
+/// Return the function called on container heap allocations.
+URHO3D_API AllocationHook GetAllocationHook();
+/// Report a container heap allocation to the allocation hook if set.
+URHO3D_API void ReportAllocation(unsigned size);
+
 /// %Allocator template class. Allocates objects of a specific class.
 template <class T> class Allocator
 {
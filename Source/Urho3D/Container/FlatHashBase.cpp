@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Container/FlatHashBase.h"
+
+#include <cstring>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+unsigned char* FlatHashBase::EmptyCtrl()
+{
+    // Never written to, as a zero-capacity container never marks slots
+    static unsigned char emptyCtrl[1] = { CTRL_END };
+    return emptyCtrl;
+}
+
+unsigned FlatHashBase::CapacityFor(unsigned numElements)
+{
+    // Allow at most 7/8 of the slots to be non-empty, so that probing always terminates at an empty slot
+    unsigned capacity = MIN_CAPACITY;
+    while (capacity - capacity / 8 < numElements)
+        capacity <<= 1;
+    return capacity;
+}
+
+void* FlatHashBase::AllocateSlots(unsigned capacity, unsigned slotSize)
+{
+    void* oldSlots = slots_;
+    unsigned slotBytes = capacity * slotSize;
+    
+    #ifdef URHO3D_PROFILING
+    ReportAllocation(slotBytes + capacity + 1);
+    #endif
+    unsigned char* storage = new unsigned char[slotBytes + capacity + 1];
+    slots_ = storage;
+    ctrl_ = storage + slotBytes;
+    capacity_ = capacity;
+    size_ = 0;
+    
+    ResetCtrl();
+    return oldSlots;
+}
+
+void FlatHashBase::ResetCtrl()
+{
+    if (!capacity_)
+        return;
+    
+    memset(ctrl_, CTRL_EMPTY, capacity_);
+    ctrl_[capacity_] = CTRL_END;
+    growthLeft_ = capacity_ - capacity_ / 8 - size_;
+}
+
+unsigned FlatHashBase::FindFreeSlot(unsigned mixed) const
+{
+    unsigned index = HomeSlot(mixed);
+    while (IsFull(ctrl_[index]))
+        index = NextSlot(index);
+    return index;
+}
+
+void FlatHashBase::SetErased(unsigned index)
+{
+    // If the next slot is empty, no probe sequence continues past this slot and it can become empty again
+    if (ctrl_[NextSlot(index)] == CTRL_EMPTY)
+    {
+        ctrl_[index] = CTRL_EMPTY;
+        ++growthLeft_;
+    }
+    else
+        ctrl_[index] = CTRL_DELETED;
+    
+    --size_;
+}
+
+}
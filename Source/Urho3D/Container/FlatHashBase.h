@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Allocator.h"
+#include "../Container/Hash.h"
+#include "../Container/Swap.h"
+
+namespace Urho3D
+{
+
+/// Open addressing hash set/map base class. Keeps one control byte per slot, which is either empty, deleted, or holds 7 bits
+/// of the key's hash, so that most probes are resolved without touching the elements.
+/** Note that to prevent extra memory use due to vtable pointer, %FlatHashBase intentionally does not declare a virtual destructor
+    and therefore %FlatHashBase pointers should never be used.
+  */
+class URHO3D_API FlatHashBase
+{
+public:
+    /// Initial amount of slots.
+    static const unsigned MIN_CAPACITY = 8;
+    
+    /// Construct.
+    FlatHashBase() :
+        ctrl_(EmptyCtrl()),
+        slots_(0),
+        capacity_(0),
+        size_(0),
+        growthLeft_(0)
+    {
+    }
+    
+    /// Swap with another hash set or map.
+    void Swap(FlatHashBase& rhs)
+    {
+        Urho3D::Swap(ctrl_, rhs.ctrl_);
+        Urho3D::Swap(slots_, rhs.slots_);
+        Urho3D::Swap(capacity_, rhs.capacity_);
+        Urho3D::Swap(size_, rhs.size_);
+        Urho3D::Swap(growthLeft_, rhs.growthLeft_);
+    }
+    
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+    /// Return number of slots.
+    unsigned Capacity() const { return capacity_; }
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+    
+protected:
+    /// Control byte of an empty slot.
+    static const unsigned char CTRL_EMPTY = 0x80;
+    /// Control byte of a slot whose element has been erased.
+    static const unsigned char CTRL_DELETED = 0xfe;
+    /// Control byte past the last slot, which stops iteration.
+    static const unsigned char CTRL_END = 0xff;
+    
+    /// Scramble a key hash so that sequential keys spread over the slots.
+    static unsigned MixHash(unsigned hash) { return hash * 0x9e3779b1; }
+    /// Return the control byte stored for a scrambled hash.
+    static unsigned char HashFragment(unsigned mixed) { return (unsigned char)(mixed & 0x7f); }
+    /// Return whether a control byte denotes an element.
+    static bool IsFull(unsigned char ctrl) { return ctrl < CTRL_EMPTY; }
+    /// Return the control bytes used before any slots have been allocated.
+    static unsigned char* EmptyCtrl();
+    
+    /// Return the first slot to probe for a scrambled hash. Do not call if the slots have not been allocated.
+    unsigned HomeSlot(unsigned mixed) const { return (mixed >> 7) & (capacity_ - 1); }
+    /// Return the next slot to probe.
+    unsigned NextSlot(unsigned index) const { return (index + 1) & (capacity_ - 1); }
+    /// Return the smallest capacity that holds the given amount of elements.
+    static unsigned CapacityFor(unsigned numElements);
+    /// Return the capacity to rehash to when out of free slots: double if mostly full of elements, otherwise only purge the deleted slots.
+    unsigned GrowCapacity() const { return capacity_ && size_ * 16 < capacity_ * 7 ? capacity_ : CapacityFor(size_ + 1); }
+    
+    /// Allocate slots of given size and reset all control bytes to empty. Return the previous slot storage, which the caller must free.
+    void* AllocateSlots(unsigned capacity, unsigned slotSize);
+    /// Free slot storage returned by AllocateSlots.
+    static void FreeSlots(void* slots) { delete[] static_cast<unsigned char*>(slots); }
+    /// Reset all control bytes to empty.
+    void ResetCtrl();
+    /// Return the first empty or deleted slot on the probe sequence of a scrambled hash. Do not call if the slots have not been allocated.
+    unsigned FindFreeSlot(unsigned mixed) const;
+    /// Mark a slot as holding an element.
+    void SetFull(unsigned index, unsigned mixed)
+    {
+        if (ctrl_[index] == CTRL_EMPTY)
+            --growthLeft_;
+        ctrl_[index] = HashFragment(mixed);
+        ++size_;
+    }
+    /// Mark a slot as no longer holding an element.
+    void SetErased(unsigned index);
+    /// Return the first slot at or after index which holds an element, or capacity if none.
+    unsigned SkipFree(unsigned index) const
+    {
+        while (ctrl_[index] != CTRL_END && !IsFull(ctrl_[index]))
+            ++index;
+        return index;
+    }
+    
+    /// Control bytes, with a terminating CTRL_END byte.
+    unsigned char* ctrl_;
+    /// Slot storage. The control bytes are allocated in the same block after the slots.
+    void* slots_;
+    /// Number of slots. Always zero or a power of two.
+    unsigned capacity_;
+    /// Number of elements.
+    unsigned size_;
+    /// Number of empty slots that may still be filled before a rehash.
+    unsigned growthLeft_;
+};
+
+}
@@ -0,0 +1,461 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Pair.h"
+#include "../Container/Vector.h"
+
+#include <new>
+
+namespace Urho3D
+{
+
+/// Open addressing hash map template class. Stores the pairs inline in a single array, so lookups and inserts do not chase
+/// pointers or allocate per element. Iteration order is unspecified. Unlike %HashMap, inserting may move the pairs, which
+/// invalidates iterators and references to them. Erasing does not move other pairs.
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef U ValueType;
+    
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+        
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            second_(value.second_)
+        {
+        }
+        
+        /// Test for equality with another pair.
+        bool operator == (const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+        /// Test for inequality with another pair.
+        bool operator != (const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+        
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+        
+    private:
+        /// Prevent assignment.
+        KeyValue& operator = (const KeyValue& rhs);
+    };
+    
+    /// Flat hash map iterator.
+    struct Iterator
+    {
+        /// Construct.
+        Iterator() :
+            ptr_(0),
+            ctrl_(0)
+        {
+        }
+        
+        /// Construct with a slot and its control byte.
+        Iterator(KeyValue* ptr, const unsigned char* ctrl) :
+            ptr_(ptr),
+            ctrl_(ctrl)
+        {
+        }
+        
+        /// Test for equality with another iterator.
+        bool operator == (const Iterator& rhs) const { return ctrl_ == rhs.ctrl_; }
+        /// Test for inequality with another iterator.
+        bool operator != (const Iterator& rhs) const { return ctrl_ != rhs.ctrl_; }
+        
+        /// Preincrement the pointer.
+        Iterator& operator ++ () { GotoNext(); return *this; }
+        /// Postincrement the pointer.
+        Iterator operator ++ (int) { Iterator it = *this; GotoNext(); return it; }
+        
+        /// Point to the pair.
+        KeyValue* operator -> () const { return ptr_; }
+        /// Dereference the pair.
+        KeyValue& operator * () const { return *ptr_; }
+        
+        /// Go to the next element.
+        void GotoNext()
+        {
+            do
+            {
+                ++ptr_;
+                ++ctrl_;
+            }
+            while (*ctrl_ != CTRL_END && !IsFull(*ctrl_));
+        }
+        
+        /// Slot pointer.
+        KeyValue* ptr_;
+        /// Control byte pointer.
+        const unsigned char* ctrl_;
+    };
+    
+    /// Flat hash map const iterator.
+    struct ConstIterator
+    {
+        /// Construct.
+        ConstIterator() :
+            ptr_(0),
+            ctrl_(0)
+        {
+        }
+        
+        /// Construct with a slot and its control byte.
+        ConstIterator(const KeyValue* ptr, const unsigned char* ctrl) :
+            ptr_(ptr),
+            ctrl_(ctrl)
+        {
+        }
+        
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :
+            ptr_(rhs.ptr_),
+            ctrl_(rhs.ctrl_)
+        {
+        }
+        
+        /// Assign from a non-const iterator.
+        ConstIterator& operator = (const Iterator& rhs) { ptr_ = rhs.ptr_; ctrl_ = rhs.ctrl_; return *this; }
+        /// Test for equality with another iterator.
+        bool operator == (const ConstIterator& rhs) const { return ctrl_ == rhs.ctrl_; }
+        /// Test for inequality with another iterator.
+        bool operator != (const ConstIterator& rhs) const { return ctrl_ != rhs.ctrl_; }
+        
+        /// Preincrement the pointer.
+        ConstIterator& operator ++ () { GotoNext(); return *this; }
+        /// Postincrement the pointer.
+        ConstIterator operator ++ (int) { ConstIterator it = *this; GotoNext(); return it; }
+        
+        /// Point to the pair.
+        const KeyValue* operator -> () const { return ptr_; }
+        /// Dereference the pair.
+        const KeyValue& operator * () const { return *ptr_; }
+        
+        /// Go to the next element.
+        void GotoNext()
+        {
+            do
+            {
+                ++ptr_;
+                ++ctrl_;
+            }
+            while (*ctrl_ != CTRL_END && !IsFull(*ctrl_));
+        }
+        
+        /// Slot pointer.
+        const KeyValue* ptr_;
+        /// Control byte pointer.
+        const unsigned char* ctrl_;
+    };
+    
+    /// Construct empty.
+    FlatHashMap()
+    {
+    }
+    
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        Reserve(map.Size());
+        Insert(map);
+    }
+    
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        DestructSlots();
+        FreeSlots(slots_);
+    }
+    
+    /// Assign a hash map.
+    FlatHashMap& operator = (const FlatHashMap<T, U>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+    
+    /// Add-assign a pair.
+    FlatHashMap& operator += (const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+    
+    /// Add-assign a hash map.
+    FlatHashMap& operator += (const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+    
+    /// Test for equality with another hash map.
+    bool operator == (const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+        
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+        
+        return true;
+    }
+    
+    /// Test for inequality with another hash map.
+    bool operator != (const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+    
+    /// Index the map. Create a new pair if key not found.
+    U& operator [] (const T& key)
+    {
+        unsigned mixed = MixHash(MakeHash(key));
+        unsigned index = FindIndex(key, mixed);
+        if (index == capacity_)
+            index = InsertNew(key, U(), mixed);
+        return Slots()[index].second_;
+    }
+    
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair) { return MakeIterator(InsertIndex(pair.first_, pair.second_)); }
+    
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        for (ConstIterator i = map.Begin(); i != map.End(); ++i)
+            InsertIndex(i->first_, i->second_);
+    }
+    
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return MakeIterator(InsertIndex(it->first_, it->second_)); }
+    
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator i = start; i != end; ++i)
+            InsertIndex(i->first_, i->second_);
+    }
+    
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned index = FindIndex(key, MixHash(MakeHash(key)));
+        if (index == capacity_)
+            return false;
+        
+        EraseIndex(index);
+        return true;
+    }
+    
+    /// Erase a pair by iterator. Return iterator to the next pair.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!capacity_ || !it.ctrl_ || it == End())
+            return End();
+        
+        unsigned index = (unsigned)(it.ptr_ - Slots());
+        EraseIndex(index);
+        return MakeIterator(SkipFree(index));
+    }
+    
+    /// Clear the map. Keeps the allocated slots.
+    void Clear()
+    {
+        DestructSlots();
+        size_ = 0;
+        ResetCtrl();
+    }
+    
+    /// Reserve slots for at least the given amount of elements, so that inserting them will not rehash.
+    void Reserve(unsigned numElements)
+    {
+        unsigned capacity = CapacityFor(numElements);
+        if (capacity > capacity_)
+            Rehash(capacity);
+    }
+    
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key) { return MakeIterator(FindIndex(key, MixHash(MakeHash(key)))); }
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const { return MakeIterator(FindIndex(key, MixHash(MakeHash(key)))); }
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindIndex(key, MixHash(MakeHash(key))) != capacity_; }
+    
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+    
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+    
+    /// Return iterator to the beginning.
+    Iterator Begin() { return MakeIterator(SkipFree(0)); }
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return MakeIterator(SkipFree(0)); }
+    /// Return iterator to the end.
+    Iterator End() { return MakeIterator(capacity_); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return MakeIterator(capacity_); }
+    
+private:
+    /// Return the slots.
+    KeyValue* Slots() const { return static_cast<KeyValue*>(slots_); }
+    /// Return an iterator to a slot index.
+    Iterator MakeIterator(unsigned index) { return Iterator(Slots() + index, ctrl_ + index); }
+    /// Return a const iterator to a slot index.
+    ConstIterator MakeIterator(unsigned index) const { return ConstIterator(Slots() + index, ctrl_ + index); }
+    
+    /// Return the slot index of key, or capacity if not found.
+    unsigned FindIndex(const T& key, unsigned mixed) const
+    {
+        if (!size_)
+            return capacity_;
+        
+        unsigned char fragment = HashFragment(mixed);
+        for (unsigned index = HomeSlot(mixed);; index = NextSlot(index))
+        {
+            unsigned char ctrl = ctrl_[index];
+            if (ctrl == fragment && Slots()[index].first_ == key)
+                return index;
+            if (ctrl == CTRL_EMPTY)
+                return capacity_;
+        }
+    }
+    
+    /// Insert a key and value, or assign the value if the key exists. Return the slot index.
+    unsigned InsertIndex(const T& key, const U& value)
+    {
+        unsigned mixed = MixHash(MakeHash(key));
+        unsigned index = FindIndex(key, mixed);
+        if (index != capacity_)
+        {
+            Slots()[index].second_ = value;
+            return index;
+        }
+        
+        return InsertNew(key, value, mixed);
+    }
+    
+    /// Insert a key known not to exist. Return the slot index.
+    unsigned InsertNew(const T& key, const U& value, unsigned mixed)
+    {
+        unsigned index = capacity_ ? FindFreeSlot(mixed) : 0;
+        if (!capacity_ || (!growthLeft_ && ctrl_[index] == CTRL_EMPTY))
+        {
+            Rehash(GrowCapacity());
+            index = FindFreeSlot(mixed);
+        }
+        
+        new(Slots() + index) KeyValue(key, value);
+        SetFull(index, mixed);
+        return index;
+    }
+    
+    /// Destruct and free the pair at a slot index.
+    void EraseIndex(unsigned index)
+    {
+        (Slots() + index)->~KeyValue();
+        SetErased(index);
+    }
+    
+    /// Destruct all pairs.
+    void DestructSlots()
+    {
+        if (!size_)
+            return;
+        
+        KeyValue* slots = Slots();
+        for (unsigned i = 0; i < capacity_; ++i)
+        {
+            if (IsFull(ctrl_[i]))
+                (slots + i)->~KeyValue();
+        }
+    }
+    
+    /// Move all pairs to new slots.
+    void Rehash(unsigned capacity)
+    {
+        unsigned char* oldCtrl = ctrl_;
+        unsigned oldCapacity = capacity_;
+        KeyValue* oldSlots = static_cast<KeyValue*>(AllocateSlots(capacity, sizeof(KeyValue)));
+        KeyValue* slots = Slots();
+        
+        for (unsigned i = 0; i < oldCapacity; ++i)
+        {
+            if (IsFull(oldCtrl[i]))
+            {
+                unsigned mixed = MixHash(MakeHash(oldSlots[i].first_));
+                unsigned index = FindFreeSlot(mixed);
+                new(slots + index) KeyValue(oldSlots[i]);
+                SetFull(index, mixed);
+                (oldSlots + i)->~KeyValue();
+            }
+        }
+        
+        FreeSlots(oldSlots);
+    }
+};
+
+}
+
+namespace std
+{
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator begin(const Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator end(const Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator begin(Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator end(Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
@@ -0,0 +1,378 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+
+#include <new>
+
+namespace Urho3D
+{
+
+/// Open addressing hash set template class. Stores the keys inline in a single array, so lookups and inserts do not chase
+/// pointers or allocate per element. Iteration order is unspecified. Unlike %HashSet, inserting may move the keys, which
+/// invalidates iterators. Erasing does not move other keys.
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    /// Flat hash set iterator.
+    struct Iterator
+    {
+        /// Construct.
+        Iterator() :
+            ptr_(0),
+            ctrl_(0)
+        {
+        }
+        
+        /// Construct with a slot and its control byte.
+        Iterator(T* ptr, const unsigned char* ctrl) :
+            ptr_(ptr),
+            ctrl_(ctrl)
+        {
+        }
+        
+        /// Test for equality with another iterator.
+        bool operator == (const Iterator& rhs) const { return ctrl_ == rhs.ctrl_; }
+        /// Test for inequality with another iterator.
+        bool operator != (const Iterator& rhs) const { return ctrl_ != rhs.ctrl_; }
+        
+        /// Preincrement the pointer.
+        Iterator& operator ++ () { GotoNext(); return *this; }
+        /// Postincrement the pointer.
+        Iterator operator ++ (int) { Iterator it = *this; GotoNext(); return it; }
+        
+        /// Point to the key.
+        const T* operator -> () const { return ptr_; }
+        /// Dereference the key.
+        const T& operator * () const { return *ptr_; }
+        
+        /// Go to the next element.
+        void GotoNext()
+        {
+            do
+            {
+                ++ptr_;
+                ++ctrl_;
+            }
+            while (*ctrl_ != CTRL_END && !IsFull(*ctrl_));
+        }
+        
+        /// Slot pointer.
+        T* ptr_;
+        /// Control byte pointer.
+        const unsigned char* ctrl_;
+    };
+    
+    /// Flat hash set const iterator.
+    struct ConstIterator
+    {
+        /// Construct.
+        ConstIterator() :
+            ptr_(0),
+            ctrl_(0)
+        {
+        }
+        
+        /// Construct with a slot and its control byte.
+        ConstIterator(const T* ptr, const unsigned char* ctrl) :
+            ptr_(ptr),
+            ctrl_(ctrl)
+        {
+        }
+        
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :
+            ptr_(rhs.ptr_),
+            ctrl_(rhs.ctrl_)
+        {
+        }
+        
+        /// Assign from a non-const iterator.
+        ConstIterator& operator = (const Iterator& rhs) { ptr_ = rhs.ptr_; ctrl_ = rhs.ctrl_; return *this; }
+        /// Test for equality with another iterator.
+        bool operator == (const ConstIterator& rhs) const { return ctrl_ == rhs.ctrl_; }
+        /// Test for inequality with another iterator.
+        bool operator != (const ConstIterator& rhs) const { return ctrl_ != rhs.ctrl_; }
+        
+        /// Preincrement the pointer.
+        ConstIterator& operator ++ () { GotoNext(); return *this; }
+        /// Postincrement the pointer.
+        ConstIterator operator ++ (int) { ConstIterator it = *this; GotoNext(); return it; }
+        
+        /// Point to the key.
+        const T* operator -> () const { return ptr_; }
+        /// Dereference the key.
+        const T& operator * () const { return *ptr_; }
+        
+        /// Go to the next element.
+        void GotoNext()
+        {
+            do
+            {
+                ++ptr_;
+                ++ctrl_;
+            }
+            while (*ctrl_ != CTRL_END && !IsFull(*ctrl_));
+        }
+        
+        /// Slot pointer.
+        const T* ptr_;
+        /// Control byte pointer.
+        const unsigned char* ctrl_;
+    };
+    
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+    
+    /// Construct from another hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        Reserve(set.Size());
+        Insert(set);
+    }
+    
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        DestructSlots();
+        FreeSlots(slots_);
+    }
+    
+    /// Assign a hash set.
+    FlatHashSet& operator = (const FlatHashSet<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+    
+    /// Add-assign a value.
+    FlatHashSet& operator += (const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+    
+    /// Add-assign a hash set.
+    FlatHashSet& operator += (const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+    
+    /// Test for equality with another hash set.
+    bool operator == (const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+        
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+        
+        return true;
+    }
+    
+    /// Test for inequality with another hash set.
+    bool operator != (const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+    
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        unsigned mixed = MixHash(MakeHash(key));
+        unsigned index = FindIndex(key, mixed);
+        if (index == capacity_)
+            index = InsertNew(key, mixed);
+        return MakeIterator(index);
+    }
+    
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        for (ConstIterator i = set.Begin(); i != set.End(); ++i)
+            Insert(*i);
+    }
+    
+    /// Insert a key by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(*it); }
+    
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned index = FindIndex(key, MixHash(MakeHash(key)));
+        if (index == capacity_)
+            return false;
+        
+        EraseIndex(index);
+        return true;
+    }
+    
+    /// Erase a key by iterator. Return iterator to the next key.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!capacity_ || !it.ctrl_ || it == End())
+            return End();
+        
+        unsigned index = (unsigned)(it.ptr_ - Slots());
+        EraseIndex(index);
+        return MakeIterator(SkipFree(index));
+    }
+    
+    /// Clear the set. Keeps the allocated slots.
+    void Clear()
+    {
+        DestructSlots();
+        size_ = 0;
+        ResetCtrl();
+    }
+    
+    /// Reserve slots for at least the given amount of keys, so that inserting them will not rehash.
+    void Reserve(unsigned numElements)
+    {
+        unsigned capacity = CapacityFor(numElements);
+        if (capacity > capacity_)
+            Rehash(capacity);
+    }
+    
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key) { return MakeIterator(FindIndex(key, MixHash(MakeHash(key)))); }
+    /// Return const iterator to the key, or end iterator if not found.
+    ConstIterator Find(const T& key) const { return MakeIterator(FindIndex(key, MixHash(MakeHash(key)))); }
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindIndex(key, MixHash(MakeHash(key))) != capacity_; }
+    
+    /// Return iterator to the beginning.
+    Iterator Begin() { return MakeIterator(SkipFree(0)); }
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return MakeIterator(SkipFree(0)); }
+    /// Return iterator to the end.
+    Iterator End() { return MakeIterator(capacity_); }
+    /// Return iterator to the end.
+    ConstIterator End() const { return MakeIterator(capacity_); }
+    
+private:
+    /// Return the slots.
+    T* Slots() const { return static_cast<T*>(slots_); }
+    /// Return an iterator to a slot index.
+    Iterator MakeIterator(unsigned index) { return Iterator(Slots() + index, ctrl_ + index); }
+    /// Return a const iterator to a slot index.
+    ConstIterator MakeIterator(unsigned index) const { return ConstIterator(Slots() + index, ctrl_ + index); }
+    
+    /// Return the slot index of key, or capacity if not found.
+    unsigned FindIndex(const T& key, unsigned mixed) const
+    {
+        if (!size_)
+            return capacity_;
+        
+        unsigned char fragment = HashFragment(mixed);
+        for (unsigned index = HomeSlot(mixed);; index = NextSlot(index))
+        {
+            unsigned char ctrl = ctrl_[index];
+            if (ctrl == fragment && Slots()[index] == key)
+                return index;
+            if (ctrl == CTRL_EMPTY)
+                return capacity_;
+        }
+    }
+    
+    /// Insert a key known not to exist. Return the slot index.
+    unsigned InsertNew(const T& key, unsigned mixed)
+    {
+        unsigned index = capacity_ ? FindFreeSlot(mixed) : 0;
+        if (!capacity_ || (!growthLeft_ && ctrl_[index] == CTRL_EMPTY))
+        {
+            Rehash(GrowCapacity());
+            index = FindFreeSlot(mixed);
+        }
+        
+        new(Slots() + index) T(key);
+        SetFull(index, mixed);
+        return index;
+    }
+    
+    /// Destruct and free the key at a slot index.
+    void EraseIndex(unsigned index)
+    {
+        (Slots() + index)->~T();
+        SetErased(index);
+    }
+    
+    /// Destruct all keys.
+    void DestructSlots()
+    {
+        if (!size_)
+            return;
+        
+        T* slots = Slots();
+        for (unsigned i = 0; i < capacity_; ++i)
+        {
+            if (IsFull(ctrl_[i]))
+                (slots + i)->~T();
+        }
+    }
+    
+    /// Move all keys to new slots.
+    void Rehash(unsigned capacity)
+    {
+        unsigned char* oldCtrl = ctrl_;
+        unsigned oldCapacity = capacity_;
+        T* oldSlots = static_cast<T*>(AllocateSlots(capacity, sizeof(T)));
+        T* slots = Slots();
+        
+        for (unsigned i = 0; i < oldCapacity; ++i)
+        {
+            if (IsFull(oldCtrl[i]))
+            {
+                unsigned mixed = MixHash(MakeHash(oldSlots[i]));
+                unsigned index = FindFreeSlot(mixed);
+                new(slots + index) T(oldSlots[i]);
+                SetFull(index, mixed);
+                (oldSlots + i)->~T();
+            }
+        }
+        
+        FreeSlots(oldSlots);
+    }
+};
+
+}
+
+namespace std
+{
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator begin(const Urho3D::FlatHashSet<T>& v) { return v.Begin(); }
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator end(const Urho3D::FlatHashSet<T>& v) { return v.End(); }
+template <class T> typename Urho3D::FlatHashSet<T>::Iterator begin(Urho3D::FlatHashSet<T>& v) { return v.Begin(); }
+template <class T> typename Urho3D::FlatHashSet<T>::Iterator end(Urho3D::FlatHashSet<T>& v) { return v.End(); }
+
+}
@@ -32,6 +32,9 @@ void HashBase::AllocateBuckets(unsigned size, unsigned numBuckets)
     if (ptrs_)
         delete[] ptrs_;
     
+    #ifdef URHO3D_PROFILING
+    ReportAllocation((numBuckets + 2) * sizeof(HashNodeBase*));
+    #endif
     HashNodeBase** ptrs = new HashNodeBase*[numBuckets + 2];
     unsigned* data = reinterpret_cast<unsigned*>(ptrs);
     data[0] = size;
@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "../Container/Allocator.h"
 #include "../Container/Str.h"
 #include "../Container/Swap.h"
 
@@ -30,146 +31,116 @@
 namespace Urho3D
 {
 
-char String::endZero = 0;
-
 const String String::EMPTY;
 
-String::String(const WString& str) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(const WString& str)
 {
+    InitEmpty();
     SetUTF8FromWChar(str.CString());
 }
 
-String::String(int value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(int value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
     *this = tempBuffer;
 }
 
-String::String(short value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(short value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%d", value);
     *this = tempBuffer;
 }
 
-String::String(long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(long value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%ld", value);
     *this = tempBuffer;
 }
     
-String::String(long long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(long long value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lld", value);
     *this = tempBuffer;
 }
 
-String::String(unsigned value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(unsigned value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
     *this = tempBuffer;
 }
 
-String::String(unsigned short value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(unsigned short value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%u", value);
     *this = tempBuffer;
 }
 
-String::String(unsigned long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(unsigned long value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%lu", value);
     *this = tempBuffer;
 }
     
-String::String(unsigned long long value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(unsigned long long value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%llu", value);
     *this = tempBuffer;
 }
 
-String::String(float value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(float value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
     *this = tempBuffer;
 }
 
-String::String(double value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(double value)
 {
+    InitEmpty();
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
     sprintf(tempBuffer, "%g", value);
     *this = tempBuffer;
 }
 
-String::String(bool value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(bool value)
 {
+    InitEmpty();
     if (value)
         *this = "true";
     else
         *this = "false";
 }
 
-String::String(char value) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(char value)
 {
+    InitEmpty();
     Resize(1);
-    buffer_[0] = value;
+    Buffer()[0] = value;
 }
 
-String::String(char value, unsigned length) :
-    length_(0),
-    capacity_(0),
-    buffer_(&endZero)
+String::String(char value, unsigned length)
 {
+    InitEmpty();
     Resize(length);
     for (unsigned i = 0; i < length; ++i)
-        buffer_[i] = value;
+        Buffer()[i] = value;
 }
 
 String& String::operator += (int rhs)
@@ -226,19 +197,19 @@ void String::Replace(char replaceThis, char replaceWith, bool caseSensitive)
 {
     if (caseSensitive)
     {
-        for (unsigned i = 0; i < length_; ++i)
+        for (unsigned i = 0; i < Length(); ++i)
         {
-            if (buffer_[i] == replaceThis)
-                buffer_[i] = replaceWith;
+            if (Buffer()[i] == replaceThis)
+                Buffer()[i] = replaceWith;
         }
     }
     else
     {
         replaceThis = tolower(replaceThis);
-        for (unsigned i = 0; i < length_; ++i)
+        for (unsigned i = 0; i < Length(); ++i)
         {
-            if (tolower(buffer_[i]) == replaceThis)
-                buffer_[i] = replaceWith;
+            if (tolower(Buffer()[i]) == replaceThis)
+                Buffer()[i] = replaceWith;
         }
     }
 }
@@ -247,29 +218,29 @@ void String::Replace(const String& replaceThis, const String& replaceWith, bool
 {
     unsigned nextPos = 0;
     
-    while (nextPos < length_)
+    while (nextPos < Length())
     {
         unsigned pos = Find(replaceThis, nextPos, caseSensitive);
         if (pos == NPOS)
             break;
-        Replace(pos, replaceThis.length_, replaceWith);
-        nextPos = pos + replaceWith.length_;
+        Replace(pos, replaceThis.Length(), replaceWith);
+        nextPos = pos + replaceWith.Length();
     }
 }
 
 void String::Replace(unsigned pos, unsigned length, const String& replaceWith)
 {
     // If substring is illegal, do nothing
-    if (pos + length > length_)
+    if (pos + length > Length())
         return;
     
-    Replace(pos, length, replaceWith.buffer_, replaceWith.length_);
+    Replace(pos, length, replaceWith.Buffer(), replaceWith.Length());
 }
 
 void String::Replace(unsigned pos, unsigned length, const char* replaceWith)
 {
     // If substring is illegal, do nothing
-    if (pos + length > length_)
+    if (pos + length > Length())
         return;
     
     Replace(pos, length, replaceWith, CStringLength(replaceWith));
@@ -278,7 +249,7 @@ void String::Replace(unsigned pos, unsigned length, const char* replaceWith)
 String::Iterator String::Replace(const String::Iterator& start, const String::Iterator& end, const String& replaceWith)
 {
     unsigned pos = start - Begin();
-    if (pos >= length_)
+    if (pos >= Length())
         return End();
     unsigned length = end - start;
     Replace(pos, length, replaceWith);
@@ -319,19 +290,19 @@ String& String::Append(const char* str, unsigned length)
 {
     if (str)
     {
-        unsigned oldLength = length_;
+        unsigned oldLength = Length();
         Resize(oldLength + length);
-        CopyChars(&buffer_[oldLength], str, length);
+        CopyChars(&Buffer()[oldLength], str, length);
     }
     return *this;
 }
 
 void String::Insert(unsigned pos, const String& str)
 {
-    if (pos > length_)
-        pos = length_;
+    if (pos > Length())
+        pos = Length();
     
-    if (pos == length_)
+    if (pos == Length())
         (*this) += str;
     else
         Replace(pos, 0, str);
@@ -339,25 +310,25 @@ void String::Insert(unsigned pos, const String& str)
 
 void String::Insert(unsigned pos, char c)
 {
-    if (pos > length_)
-        pos = length_;
+    if (pos > Length())
+        pos = Length();
     
-    if (pos == length_)
+    if (pos == Length())
         (*this) += c;
     else
     {
-        unsigned oldLength = length_;
-        Resize(length_ + 1);
+        unsigned oldLength = Length();
+        Resize(Length() + 1);
         MoveRange(pos + 1, pos, oldLength - pos);
-        buffer_[pos] = c;
+        Buffer()[pos] = c;
     }
 }
 
 String::Iterator String::Insert(const String::Iterator& dest, const String& str)
 {
     unsigned pos = dest - Begin();
-    if (pos > length_)
-        pos = length_;
+    if (pos > Length())
+        pos = Length();
     Insert(pos, str);
     
     return Begin() + pos;
@@ -366,8 +337,8 @@ String::Iterator String::Insert(const String::Iterator& dest, const String& str)
 String::Iterator String::Insert(const String::Iterator& dest, const String::Iterator& start, const String::Iterator& end)
 {
     unsigned pos = dest - Begin();
-    if (pos > length_)
-        pos = length_;
+    if (pos > Length())
+        pos = Length();
     unsigned length = end - start;
     Replace(pos, 0, &(*start), length);
     
@@ -377,8 +348,8 @@ String::Iterator String::Insert(const String::Iterator& dest, const String::Iter
 String::Iterator String::Insert(const String::Iterator& dest, char c)
 {
     unsigned pos = dest - Begin();
-    if (pos > length_)
-        pos = length_;
+    if (pos > Length())
+        pos = Length();
     Insert(pos, c);
     
     return Begin() + pos;
@@ -392,7 +363,7 @@ void String::Erase(unsigned pos, unsigned length)
 String::Iterator String::Erase(const String::Iterator& it)
 {
     unsigned pos = it - Begin();
-    if (pos >= length_)
+    if (pos >= Length())
         return End();
     Erase(pos);
     
@@ -402,7 +373,7 @@ String::Iterator String::Erase(const String::Iterator& it)
 String::Iterator String::Erase(const String::Iterator& start, const String::Iterator& end)
 {
     unsigned pos = start - Begin();
-    if (pos >= length_)
+    if (pos >= Length())
         return End();
     unsigned length = end - start;
     Erase(pos, length);
@@ -412,62 +383,60 @@ String::Iterator String::Erase(const String::Iterator& start, const String::Iter
 
 void String::Resize(unsigned newLength)
 {
-    if (!capacity_)
+    if (IsInline())
     {
-        // If zero length requested, do not allocate buffer yet
-        if (!newLength)
+        if (newLength <= INLINE_CAPACITY)
+        {
+            // When the string is full length, the unused capacity byte doubles as the null terminator
+            inline_[newLength] = 0;
+            inline_[INLINE_CAPACITY] = (char)(INLINE_CAPACITY - newLength);
             return;
+        }
         
-        // Calculate initial capacity
-        capacity_ = newLength + 1;
-        if (capacity_ < MIN_CAPACITY)
-            capacity_ = MIN_CAPACITY;
-        
-        buffer_ = new char[capacity_];
+        MoveToHeap(newLength + 1);
     }
     else
     {
-        if (newLength && capacity_ < newLength + 1)
+        unsigned capacity = heap_.capacity_ & ~HEAP_FLAG;
+        if (capacity < newLength + 1)
         {
             // Increase the capacity with half each time it is exceeded
-            while (capacity_ < newLength + 1)
-                capacity_ += (capacity_ + 1) >> 1;
+            while (capacity < newLength + 1)
+                capacity += (capacity + 1) >> 1;
             
-            char* newBuffer = new char[capacity_];
-            // Move the existing data to the new buffer, then delete the old buffer
-            if (length_)
-                CopyChars(newBuffer, buffer_, length_);
-            delete[] buffer_;
-            
-            buffer_ = newBuffer;
+            MoveToHeap(capacity);
         }
     }
     
-    buffer_[newLength] = 0;
-    length_ = newLength;
+    heap_.buffer_[newLength] = 0;
+    heap_.length_ = newLength;
 }
 
 void String::Reserve(unsigned newCapacity)
 {
-    if (newCapacity < length_ + 1)
-        newCapacity = length_ + 1;
-    if (newCapacity == capacity_)
+    unsigned length = Length();
+    if (newCapacity < length + 1)
+        newCapacity = length + 1;
+    if (newCapacity == Capacity())
         return;
     
-    char* newBuffer = new char[newCapacity];
-    // Move the existing data to the new buffer, then delete the old buffer
-    CopyChars(newBuffer, buffer_, length_ + 1);
-    if (capacity_)
-        delete[] buffer_;
-    
-    capacity_ = newCapacity;
-    buffer_ = newBuffer;
+    if (newCapacity > INLINE_CAPACITY + 1)
+        MoveToHeap(newCapacity);
+    else if (!IsInline())
+    {
+        // Move back to inline storage, which overwrites the heap buffer pointer
+        char* oldBuffer = heap_.buffer_;
+        CopyChars(inline_, oldBuffer, length);
+        delete[] oldBuffer;
+        inline_[length] = 0;
+        inline_[INLINE_CAPACITY] = (char)(INLINE_CAPACITY - length);
+    }
 }
 
 void String::Compact()
 {
-    if (capacity_)
-        Reserve(length_ + 1);
+    if (!IsInline())
+        Reserve(Length() + 1);
 }
 
 void String::Clear()
@@ -477,18 +446,20 @@ void String::Clear()
 
 void String::Swap(String& str)
 {
-    Urho3D::Swap(length_, str.length_);
-    Urho3D::Swap(capacity_, str.capacity_);
-    Urho3D::Swap(buffer_, str.buffer_);
+    // The storage holds no pointers to itself, so it can be swapped as raw bytes
+    char temp[INLINE_CAPACITY + 1];
+    memcpy(temp, inline_, sizeof temp);
+    memcpy(inline_, str.inline_, sizeof temp);
+    memcpy(str.inline_, temp, sizeof temp);
 }
 
 String String::Substring(unsigned pos) const
 {
-    if (pos < length_)
+    if (pos < Length())
     {
         String ret;
-        ret.Resize(length_ - pos);
-        CopyChars(ret.buffer_, buffer_ + pos, ret.length_);
+        ret.Resize(Length() - pos);
+        CopyChars(ret.Buffer(), Buffer() + pos, ret.Length());
         
         return ret;
     }
@@ -498,13 +469,13 @@ String String::Substring(unsigned pos) const
 
 String String::Substring(unsigned pos, unsigned length) const
 {
-    if (pos < length_)
+    if (pos < Length())
     {
         String ret;
-        if (pos + length > length_)
-            length = length_ - pos;
+        if (pos + length > Length())
+            length = Length() - pos;
         ret.Resize(length);
-        CopyChars(ret.buffer_, buffer_ + pos, ret.length_);
+        CopyChars(ret.Buffer(), Buffer() + pos, ret.Length());
         
         return ret;
     }
@@ -515,18 +486,18 @@ String String::Substring(unsigned pos, unsigned length) const
 String String::Trimmed() const
 {
     unsigned trimStart = 0;
-    unsigned trimEnd = length_;
+    unsigned trimEnd = Length();
     
     while (trimStart < trimEnd)
     {
-        char c = buffer_[trimStart];
+        char c = Buffer()[trimStart];
         if (c != ' ' && c != 9)
             break;
         ++trimStart;
     }
     while (trimEnd > trimStart)
     {
-        char c = buffer_[trimEnd - 1];
+        char c = Buffer()[trimEnd - 1];
         if (c != ' ' && c != 9)
             break;
         --trimEnd;
@@ -538,8 +509,8 @@ String String::Trimmed() const
 String String::ToLower() const
 {
     String ret(*this);
-    for (unsigned i = 0; i < ret.length_; ++i)
-        ret[i] = tolower(buffer_[i]);
+    for (unsigned i = 0; i < ret.Length(); ++i)
+        ret[i] = tolower(Buffer()[i]);
     
     return ret;
 }
@@ -547,8 +518,8 @@ String String::ToLower() const
 String String::ToUpper() const
 {
     String ret(*this);
-    for (unsigned i = 0; i < ret.length_; ++i)
-        ret[i] = toupper(buffer_[i]);
+    for (unsigned i = 0; i < ret.Length(); ++i)
+        ret[i] = toupper(Buffer()[i]);
     
     return ret;
 }
@@ -567,18 +538,18 @@ unsigned String::Find(char c, unsigned startPos, bool caseSensitive) const
 {
     if (caseSensitive)
     {
-        for (unsigned i = startPos; i < length_; ++i)
+        for (unsigned i = startPos; i < Length(); ++i)
         {
-            if (buffer_[i] == c)
+            if (Buffer()[i] == c)
                 return i;
         }
     }
     else
     {
         c = tolower(c);
-        for (unsigned i = startPos; i < length_; ++i)
+        for (unsigned i = startPos; i < Length(); ++i)
         {
-            if (tolower(buffer_[i]) == c)
+            if (tolower(Buffer()[i]) == c)
                 return i;
         }
     }
@@ -588,16 +559,16 @@ unsigned String::Find(char c, unsigned startPos, bool caseSensitive) const
 
 unsigned String::Find(const String& str, unsigned startPos, bool caseSensitive) const
 {
-    if (!str.length_ || str.length_ > length_)
+    if (!str.Length() || str.Length() > Length())
         return NPOS;
     
-    char first = str.buffer_[0];
+    char first = str.Buffer()[0];
     if (!caseSensitive)
         first = tolower(first);
 
-    for (unsigned i = startPos; i <= length_ - str.length_; ++i)
+    for (unsigned i = startPos; i <= Length() - str.Length(); ++i)
     {
-        char c = buffer_[i];
+        char c = Buffer()[i];
         if (!caseSensitive)
             c = tolower(c);
 
@@ -605,10 +576,10 @@ unsigned String::Find(const String& str, unsigned startPos, bool caseSensitive)
         {
             unsigned skip = NPOS;
             bool found = true;
-            for (unsigned j = 1; j < str.length_; ++j)
+            for (unsigned j = 1; j < str.Length(); ++j)
             {
-                c = buffer_[i + j];
-                char d = str.buffer_[j];
+                c = Buffer()[i + j];
+                char d = str.Buffer()[j];
                 if (!caseSensitive)
                 {
                     c = tolower(c);
@@ -636,23 +607,23 @@ unsigned String::Find(const String& str, unsigned startPos, bool caseSensitive)
 
 unsigned String::FindLast(char c, unsigned startPos, bool caseSensitive) const
 {
-    if (startPos >= length_)
-        startPos = length_ - 1;
+    if (startPos >= Length())
+        startPos = Length() - 1;
     
     if (caseSensitive)
     {
-        for (unsigned i = startPos; i < length_; --i)
+        for (unsigned i = startPos; i < Length(); --i)
         {
-            if (buffer_[i] == c)
+            if (Buffer()[i] == c)
                 return i;
         }
     }
     else
     {
         c = tolower(c);
-        for (unsigned i = startPos; i < length_; --i)
+        for (unsigned i = startPos; i < Length(); --i)
         {
-            if (tolower(buffer_[i]) == c)
+            if (tolower(Buffer()[i]) == c)
                 return i;
         }
     }
@@ -662,28 +633,28 @@ unsigned String::FindLast(char c, unsigned startPos, bool caseSensitive) const
 
 unsigned String::FindLast(const String& str, unsigned startPos, bool caseSensitive) const
 {
-    if (!str.length_ || str.length_ > length_)
+    if (!str.Length() || str.Length() > Length())
         return NPOS;
-    if (startPos > length_ - str.length_)
-        startPos = length_ - str.length_;
+    if (startPos > Length() - str.Length())
+        startPos = Length() - str.Length();
     
-    char first = str.buffer_[0];
+    char first = str.Buffer()[0];
     if (!caseSensitive)
         first = tolower(first);
 
-    for (unsigned i = startPos; i < length_; --i)
+    for (unsigned i = startPos; i < Length(); --i)
     {
-        char c = buffer_[i];
+        char c = Buffer()[i];
         if (!caseSensitive)
             c = tolower(c);
 
         if (c == first)
         {
             bool found = true;
-            for (unsigned j = 1; j < str.length_; ++j)
+            for (unsigned j = 1; j < str.Length(); ++j)
             {
-                c = buffer_[i + j];
-                char d = str.buffer_[j];
+                c = Buffer()[i + j];
+                char d = str.Buffer()[j];
                 if (!caseSensitive)
                 {
                     c = tolower(c);
@@ -776,10 +747,10 @@ unsigned String::LengthUTF8() const
 {
     unsigned ret = 0;
     
-    const char* src = buffer_;
+    const char* src = Buffer();
     if (!src)
         return ret;
-    const char* end = buffer_ + length_;
+    const char* end = Buffer() + Length();
     
     while (src < end)
     {
@@ -795,7 +766,7 @@ unsigned String::ByteOffsetUTF8(unsigned index) const
     unsigned byteOffset = 0;
     unsigned utfPos = 0;
     
-    while (utfPos < index && byteOffset < length_)
+    while (utfPos < index && byteOffset < Length())
     {
         NextUTF8Char(byteOffset);
         ++utfPos;
@@ -806,12 +777,12 @@ unsigned String::ByteOffsetUTF8(unsigned index) const
 
 unsigned String::NextUTF8Char(unsigned& byteOffset) const
 {
-    if (!buffer_)
+    if (!Buffer())
         return 0;
     
-    const char* src = buffer_ + byteOffset;
+    const char* src = Buffer() + byteOffset;
     unsigned ret = DecodeUTF8(src);
-    byteOffset = src - buffer_;
+    byteOffset = src - Buffer();
     
     return ret;
 }
@@ -827,7 +798,7 @@ void String::ReplaceUTF8(unsigned index, unsigned unicodeChar)
     unsigned utfPos = 0;
     unsigned byteOffset = 0;
     
-    while (utfPos < index && byteOffset < length_)
+    while (utfPos < index && byteOffset < Length())
     {
         NextUTF8Char(byteOffset);
         ++utfPos;
@@ -1225,23 +1196,40 @@ void String::Replace(unsigned pos, unsigned length, const char* srcStart, unsign
 {
     int delta = (int)srcLength - (int)length;
     
-    if (pos + length < length_)
+    if (pos + length < Length())
     {
         if (delta < 0)
         {
-            MoveRange(pos + srcLength, pos + length, length_ - pos - length);
-            Resize(length_ + delta);
+            MoveRange(pos + srcLength, pos + length, Length() - pos - length);
+            Resize(Length() + delta);
         }
         if (delta > 0)
         {
-            Resize(length_ + delta);
-            MoveRange(pos + srcLength, pos + length, length_ - pos - length - delta);
+            Resize(Length() + delta);
+            MoveRange(pos + srcLength, pos + length, Length() - pos - length - delta);
         }
     }
     else
-        Resize(length_ + delta);
+        Resize(Length() + delta);
     
-    CopyChars(buffer_ + pos, srcStart, srcLength);
+    CopyChars(Buffer() + pos, srcStart, srcLength);
+}
+
+void String::MoveToHeap(unsigned capacity)
+{
+    #ifdef URHO3D_PROFILING
+    ReportAllocation(capacity);
+    #endif
+    char* newBuffer = new char[capacity];
+    // Move the existing data and the terminator to the new buffer, then delete the old buffer if it was on the heap
+    unsigned length = Length();
+    CopyChars(newBuffer, Buffer(), length + 1);
+    if (!IsInline())
+        delete[] heap_.buffer_;
+    
+    heap_.buffer_ = newBuffer;
+    heap_.length_ = length;
+    heap_.capacity_ = capacity | HEAP_FLAG;
 }
 
 WString::WString() :
@@ -44,65 +44,57 @@ public:
     typedef RandomAccessConstIterator<char> ConstIterator;
     
     /// Construct empty.
-    String() :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    String()
     {
+        InitEmpty();
     }
     
     /// Construct from another string.
-    String(const String& str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    String(const String& str)
     {
-        *this = str;
+        // Inline strings are copied as a whole, including the length
+        if (str.IsInline())
+            memcpy(inline_, str.inline_, sizeof inline_);
+        else
+        {
+            InitEmpty();
+            *this = str;
+        }
     }
     
     /// Construct from a C string.
-    String(const char* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    String(const char* str)
     {
+        InitEmpty();
         *this = str;
     }
     
     /// Construct from a C string.
-    String(char* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    String(char* str)
     {
+        InitEmpty();
         *this = (const char*)str;
     }
     
     /// Construct from a char array and length.
-    String(const char* str, unsigned length) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    String(const char* str, unsigned length)
     {
+        InitEmpty();
         Resize(length);
-        CopyChars(buffer_, str, length);
+        CopyChars(Buffer(), str, length);
     }
     
     /// Construct from a null-terminated wide character array.
-    String(const wchar_t* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    String(const wchar_t* str)
     {
+        InitEmpty();
         SetUTF8FromWChar(str);
     }
     
     /// Construct from a null-terminated wide character array.
-    String(wchar_t* str) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    String(wchar_t* str)
     {
+        InitEmpty();
         SetUTF8FromWChar(str);
     }
     
@@ -137,26 +129,31 @@ public:
     explicit String(char value, unsigned length);
     
     /// Construct from a convertable value.
-    template <class T> explicit String(const T& value) :
-        length_(0),
-        capacity_(0),
-        buffer_(&endZero)
+    template <class T> explicit String(const T& value)
     {
+        InitEmpty();
         *this = value.ToString();
     }
     
     /// Destruct.
     ~String()
     {
-        if (capacity_)
-            delete[] buffer_;
+        if (!IsInline())
+            delete[] heap_.buffer_;
     }
     
     /// Assign a string.
     String& operator = (const String& rhs)
     {
-        Resize(rhs.length_);
-        CopyChars(buffer_, rhs.buffer_, rhs.length_);
+        if (IsInline() && rhs.IsInline())
+        {
+            memcpy(inline_, rhs.inline_, sizeof inline_);
+            return *this;
+        }
+        
+        unsigned rhsLength = rhs.Length();
+        Resize(rhsLength);
+        CopyChars(Buffer(), rhs.Buffer(), rhsLength);
         
         return *this;
     }
@@ -166,7 +163,7 @@ public:
     {
         unsigned rhsLength = CStringLength(rhs);
         Resize(rhsLength);
-        CopyChars(buffer_, rhs, rhsLength);
+        CopyChars(Buffer(), rhs, rhsLength);
         
         return *this;
     }
@@ -174,9 +171,10 @@ public:
     /// Add-assign a string.
     String& operator += (const String& rhs)
     {
-        unsigned oldLength = length_;
-        Resize(length_ + rhs.length_);
-        CopyChars(buffer_ + oldLength, rhs.buffer_, rhs.length_);
+        unsigned oldLength = Length();
+        unsigned rhsLength = rhs.Length();
+        Resize(oldLength + rhsLength);
+        CopyChars(Buffer() + oldLength, rhs.Buffer(), rhsLength);
         
         return *this;
     }
@@ -185,9 +183,9 @@ public:
     String& operator += (const char* rhs)
     {
         unsigned rhsLength = CStringLength(rhs);
-        unsigned oldLength = length_;
-        Resize(length_ + rhsLength);
-        CopyChars(buffer_ + oldLength, rhs, rhsLength);
+        unsigned oldLength = Length();
+        Resize(Length() + rhsLength);
+        CopyChars(Buffer() + oldLength, rhs, rhsLength);
         
         return *this;
     }
@@ -195,9 +193,9 @@ public:
     /// Add-assign a character.
     String& operator += (char rhs)
     {
-        unsigned oldLength = length_;
-        Resize(length_ + 1);
-        buffer_[oldLength]  = rhs;
+        unsigned oldLength = Length();
+        Resize(Length() + 1);
+        Buffer()[oldLength]  = rhs;
         
         return *this;
     }
@@ -229,9 +227,9 @@ public:
     String operator + (const String& rhs) const
     {
         String ret;
-        ret.Resize(length_ + rhs.length_);
-        CopyChars(ret.buffer_, buffer_, length_);
-        CopyChars(ret.buffer_ + length_, rhs.buffer_, rhs.length_);
+        ret.Resize(Length() + rhs.Length());
+        CopyChars(ret.Buffer(), Buffer(), Length());
+        CopyChars(ret.Buffer() + Length(), rhs.Buffer(), rhs.Length());
         
         return ret;
     }
@@ -241,9 +239,9 @@ public:
     {
         unsigned rhsLength = CStringLength(rhs);
         String ret;
-        ret.Resize(length_ + rhsLength);
-        CopyChars(ret.buffer_, buffer_, length_);
-        CopyChars(ret.buffer_ + length_, rhs, rhsLength);
+        ret.Resize(Length() + rhsLength);
+        CopyChars(ret.Buffer(), Buffer(), Length());
+        CopyChars(ret.Buffer() + Length(), rhs, rhsLength);
         
         return ret;
     }
@@ -274,13 +272,13 @@ public:
     /// Test if string is greater than a C string.
     bool operator > (const char* rhs) const { return strcmp(CString(), rhs) > 0; }
     /// Return char at index.
-    char& operator [] (unsigned index) { assert(index < length_); return buffer_[index]; }
+    char& operator [] (unsigned index) { assert(index < Length()); return Buffer()[index]; }
     /// Return const char at index.
-    const char& operator [] (unsigned index) const { assert(index < length_); return buffer_[index]; }
+    const char& operator [] (unsigned index) const { assert(index < Length()); return Buffer()[index]; }
     /// Return char at index.
-    char& At(unsigned index) { assert(index < length_); return buffer_[index]; }
+    char& At(unsigned index) { assert(index < Length()); return Buffer()[index]; }
     /// Return const char at index.
-    const char& At(unsigned index) const { assert(index < length_); return buffer_[index]; }
+    const char& At(unsigned index) const { assert(index < Length()); return Buffer()[index]; }
     
     /// Replace all occurrences of a character.
     void Replace(char replaceThis, char replaceWith, bool caseSensitive = true);
@@ -332,17 +330,17 @@ public:
     void Swap(String& str);
     
     /// Return iterator to the beginning.
-    Iterator Begin() { return Iterator(buffer_); }
+    Iterator Begin() { return Iterator(Buffer()); }
     /// Return const iterator to the beginning.
-    ConstIterator Begin() const { return ConstIterator(buffer_); }
+    ConstIterator Begin() const { return ConstIterator(const_cast<char*>(Buffer())); }
     /// Return iterator to the end.
-    Iterator End() { return Iterator(buffer_ + length_); }
+    Iterator End() { return Iterator(Buffer() + Length()); }
     /// Return const iterator to the end.
-    ConstIterator End() const { return ConstIterator(buffer_ + length_); }
+    ConstIterator End() const { return ConstIterator(const_cast<char*>(Buffer()) + Length()); }
     /// Return first char, or 0 if empty.
-    char Front() const { return buffer_[0]; }
+    char Front() const { return Buffer()[0]; }
     /// Return last char, or 0 if empty.
-    char Back() const { return length_ ? buffer_[length_ - 1] : buffer_[0]; }
+    char Back() const { return Length() ? Buffer()[Length() - 1] : Buffer()[0]; }
     /// Return a substring from position to end.
     String Substring(unsigned pos) const;
     /// Return a substring with length from position.
@@ -370,13 +368,15 @@ public:
     /// Return whether ends with a string.
     bool EndsWith(const String& str, bool caseSensitive = true) const;
     /// Return the C string.
-    const char* CString() const { return buffer_; }
+    const char* CString() const { return Buffer(); }
     /// Return length.
-    unsigned Length() const { return length_; }
-    /// Return buffer capacity.
-    unsigned Capacity() const { return capacity_; }
+    unsigned Length() const { return IsInline() ? INLINE_CAPACITY - (unsigned char)inline_[INLINE_CAPACITY] : heap_.length_; }
+    /// Return buffer capacity, including the null terminator.
+    unsigned Capacity() const { return IsInline() ? INLINE_CAPACITY + 1 : heap_.capacity_ & ~HEAP_FLAG; }
+    /// Return whether the characters are stored inside the string object instead of a heap allocation.
+    bool IsInline() const { return (unsigned char)inline_[INLINE_CAPACITY] <= INLINE_CAPACITY; }
     /// Return whether the string is empty.
-    bool Empty() const { return length_ == 0; }
+    bool Empty() const { return Length() == 0; }
     /// Return comparison result with a string.
     int Compare(const String& str, bool caseSensitive = true) const;
     /// Return comparison result with a C string.
@@ -411,7 +411,7 @@ public:
     unsigned ToHash() const
     {
         unsigned hash = 0;
-        const char* ptr = buffer_;
+        const char* ptr = Buffer();
         while (*ptr)
         {
             hash = *ptr + (hash << 6) + (hash << 16) - hash;
@@ -463,15 +463,45 @@ public:
     static const unsigned NPOS = 0xffffffff;
     /// Initial dynamic allocation size.
     static const unsigned MIN_CAPACITY = 8;
+    /// Maximum length of a string stored inline without a heap allocation: 15 characters on 64-bit and 11 on 32-bit platforms.
+    static const unsigned INLINE_CAPACITY = 2 * sizeof(unsigned) + sizeof(char*) - 1;
     /// Empty string.
     static const String EMPTY;
     
 private:
+    /// Heap storage of a long string.
+    struct HeapData
+    {
+        /// String buffer.
+        char* buffer_;
+        /// String length.
+        unsigned length_;
+        /// Buffer capacity, with HEAP_FLAG set.
+        unsigned capacity_;
+    };
+    
+    /// Flag in the heap capacity which marks the string as not inline. Lands in the last byte of the storage on little-endian platforms.
+    static const unsigned HEAP_FLAG = 0x80000000;
+    
+    /// Initialize as an empty inline string.
+    void InitEmpty()
+    {
+        inline_[0] = 0;
+        inline_[INLINE_CAPACITY] = (char)INLINE_CAPACITY;
+    }
+    
+    /// Return the character buffer.
+    char* Buffer() { return IsInline() ? inline_ : heap_.buffer_; }
+    /// Return the character buffer.
+    const char* Buffer() const { return IsInline() ? inline_ : heap_.buffer_; }
+    /// Move the characters to a heap buffer of given capacity.
+    void MoveToHeap(unsigned capacity);
+    
     /// Move a range of characters within the string.
     void MoveRange(unsigned dest, unsigned src, unsigned count)
     {
         if (count)
-            memmove(buffer_ + dest, buffer_ + src, count);
+            memmove(Buffer() + dest, Buffer() + src, count);
     }
     
     /// Copy chars from one buffer to another.
@@ -494,15 +524,15 @@ private:
     /// Replace a substring with another substring.
     void Replace(unsigned pos, unsigned length, const char* srcStart, unsigned srcLength);
     
-    /// String length.
-    unsigned length_;
-    /// Capacity, zero if buffer not allocated.
-    unsigned capacity_;
-    /// String buffer, null if not allocated.
-    char* buffer_;
-    
-    /// End zero for empty strings.
-    static char endZero;
+    /// Storage. Short strings keep their characters inline, with the last byte holding the unused inline capacity, so that it
+    /// also acts as the null terminator of a full-length inline string.
+    union
+    {
+        /// Heap storage.
+        HeapData heap_;
+        /// Inline storage.
+        char inline_[INLINE_CAPACITY + 1];
+    };
 };
 
 /// Add a string to a C string.
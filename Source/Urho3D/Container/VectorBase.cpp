@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "../Container/Allocator.h"
 #include "../Container/VectorBase.h"
 
 #include "../DebugNew.h"
@@ -29,6 +30,9 @@ namespace Urho3D
 
 unsigned char* VectorBase::AllocateBuffer(unsigned size)
 {
+    #ifdef URHO3D_PROFILING
+    ReportAllocation(size);
+    #endif
     return new unsigned char[size];
 }
 
@@ -49,6 +49,62 @@ static const unsigned AM_NODEIDVECTOR = 0x40;
 
 class Serializable;
 
+/// Quantization mode of an attribute in network latest data updates.
+enum AttributeQuantizationMode
+{
+    /// Full precision.
+    AQ_NONE = 0,
+    /// Float components mapped to a fixed-point range.
+    AQ_RANGE,
+    /// Float components as 16-bit half floats.
+    AQ_HALFFLOAT,
+    /// Quaternion as its three smallest components and the index of the largest.
+    AQ_SMALLESTTHREE
+};
+
+/// Quantization of an attribute in network latest data updates. Supported for float, Vector2, Vector3, Vector4 and Quaternion attributes; smallest three mode only for quaternions. Must be the same on the server and the client.
+struct AttributeQuantization
+{
+    /// Construct as full precision.
+    AttributeQuantization() :
+        mode_(AQ_NONE),
+        bits_(0),
+        min_(0.0f),
+        max_(0.0f)
+    {
+    }
+    
+    /// Construct with mode and amount of bits per component. Range mode also needs the minimum and maximum value.
+    AttributeQuantization(AttributeQuantizationMode mode, unsigned bits, float min = 0.0f, float max = 0.0f) :
+        mode_(mode),
+        bits_(bits),
+        min_(min),
+        max_(max)
+    {
+    }
+    
+    /// Construct as range quantization with the smallest amount of bits needed for the given precision.
+    AttributeQuantization(float min, float max, float precision) :
+        mode_(AQ_RANGE),
+        bits_(1),
+        min_(min),
+        max_(max)
+    {
+        double steps = precision > 0.0f ? ((double)max - min) / precision : 0.0;
+        while (bits_ < 32 && (double)((1U << bits_) - 1) < steps)
+            ++bits_;
+    }
+    
+    /// Quantization mode.
+    AttributeQuantizationMode mode_;
+    /// Bits per component in range and smallest three modes.
+    unsigned bits_;
+    /// Minimum value in range mode.
+    float min_;
+    /// Maximum value in range mode.
+    float max_;
+};
+
 /// Abstract base class for invoking attribute accessors.
 class URHO3D_API AttributeAccessor : public RefCounted
 {
@@ -138,6 +194,8 @@ struct AttributeInfo
     unsigned mode_;
     /// Attribute data pointer if elsewhere than in the Serializable.
     void* ptr_;
+    /// Quantization in network latest data updates.
+    AttributeQuantization quantization_;
 };
 
 }
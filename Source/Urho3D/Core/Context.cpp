@@ -50,6 +50,82 @@ void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attribute
         attributes.Erase(i);
 }
 
+AttributeInfo* GetNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attributes, StringHash objectType, const char* name)
+{
+    HashMap<StringHash, Vector<AttributeInfo> >::Iterator i = attributes.Find(objectType);
+    if (i == attributes.End())
+        return 0;
+
+    Vector<AttributeInfo>& infos = i->second_;
+
+    for (Vector<AttributeInfo>::Iterator j = infos.Begin(); j != infos.End(); ++j)
+    {
+        if (!j->name_.Compare(name, true))
+            return &(*j);
+    }
+
+    return 0;
+}
+
+TypedEventReceiverGroup::TypedEventReceiverGroup() :
+    inSend_(0),
+    dirty_(false)
+{
+}
+
+void TypedEventReceiverGroup::EndSendEvent()
+{
+    assert(inSend_ > 0);
+    --inSend_;
+    
+    if (!inSend_ && dirty_)
+    {
+        // Remove the empty slots left by handlers removed during the send, preserving the order of the rest
+        unsigned dest = 0;
+        for (unsigned i = 0; i < handlers_.Size(); ++i)
+        {
+            TypedEventHandler* handler = handlers_[i];
+            if (handler)
+            {
+                handler->index_ = dest;
+                handlers_[dest++] = handler;
+            }
+        }
+        handlers_.Resize(dest);
+        dirty_ = false;
+    }
+}
+
+void TypedEventReceiverGroup::Add(TypedEventHandler* handler)
+{
+    handler->index_ = handlers_.Size();
+    handlers_.Push(handler);
+}
+
+void TypedEventReceiverGroup::Remove(TypedEventHandler* handler)
+{
+    unsigned index = handler->index_;
+    if (index >= handlers_.Size() || handlers_[index] != handler)
+        return;
+    
+    if (inSend_)
+    {
+        // Leave an empty slot to be compacted after the send
+        handlers_[index] = 0;
+        dirty_ = true;
+    }
+    else
+    {
+        // Move the last handler into the freed slot
+        TypedEventHandler* last = handlers_.Back();
+        handlers_[index] = last;
+        last->index_ = index;
+        handlers_.Pop();
+    }
+    
+    handler->index_ = M_MAX_UNSIGNED;
+}
+
 Context::Context() :
     eventHandler_(0)
 {
@@ -83,7 +159,7 @@ Context::~Context()
 
 SharedPtr<Object> Context::CreateObject(StringHash objectType)
 {
-    HashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
     if (i != factories_.End())
         return i->second_->CreateObject();
     else
@@ -148,6 +224,18 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
         info->defaultValue_ = defaultValue;
 }
 
+void Context::UpdateAttributeQuantization(StringHash objectType, const char* name, const AttributeQuantization& quantization)
+{
+    AttributeInfo* info = GetNamedAttribute(attributes_, objectType, name);
+    if (info)
+        info->quantization_ = quantization;
+
+    // The network attributes are a separate copy, which is what replication uses
+    info = GetNamedAttribute(networkAttributes_, objectType, name);
+    if (info)
+        info->quantization_ = quantization;
+}
+
 VariantMap& Context::GetEventDataMap()
 {
     unsigned nestingLevel = eventSenders_.Size();
@@ -195,25 +283,13 @@ Object* Context::GetEventSender() const
 const String& Context::GetTypeName(StringHash objectType) const
 {
     // Search factories to find the hash-to-name mapping
-    HashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories_.Find(objectType);
     return i != factories_.End() ? i->second_->GetTypeName() : String::EMPTY;
 }
 
 AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
 {
-    HashMap<StringHash, Vector<AttributeInfo> >::Iterator i = attributes_.Find(objectType);
-    if (i == attributes_.End())
-        return 0;
-
-    Vector<AttributeInfo>& infos = i->second_;
-
-    for (Vector<AttributeInfo>::Iterator j = infos.Begin(); j != infos.End(); ++j)
-    {
-        if (!j->name_.Compare(name, true))
-            return &(*j);
-    }
-
-    return 0;
+    return GetNamedAttribute(attributes_, objectType, name);
 }
 
 void Context::AddEventReceiver(Object* receiver, StringHash eventType)
@@ -238,6 +314,19 @@ void Context::RemoveEventSender(Object* sender)
         }
         specificEventReceivers_.Erase(i);
     }
+    
+    i = specificTypedEventReceivers_.Find(sender);
+    if (i != specificTypedEventReceivers_.End())
+    {
+        // Removing the receivers' typed event handlers also removes them from the map, so take a copy first
+        HashMap<StringHash, HashSet<Object*> > receivers = i->second_;
+        specificTypedEventReceivers_.Erase(i);
+        for (HashMap<StringHash, HashSet<Object*> >::Iterator j = receivers.Begin(); j != receivers.End(); ++j)
+        {
+            for (HashSet<Object*>::Iterator k = j->second_.Begin(); k != j->second_.End(); ++k)
+                (*k)->RemoveEventSender(sender);
+        }
+    }
 }
 
 void Context::RemoveEventReceiver(Object* receiver, StringHash eventType)
@@ -254,4 +343,43 @@ void Context::RemoveEventReceiver(Object* receiver, Object* sender, StringHash e
         group->Erase(receiver);
 }
 
+void Context::AddTypedEventReceiver(TypedEventHandler* handler)
+{
+    SharedPtr<TypedEventReceiverGroup>& group = typedEventReceivers_[handler->GetEventType()];
+    if (!group)
+        group = new TypedEventReceiverGroup();
+    group->Add(handler);
+    
+    if (handler->IsSpecific())
+        specificTypedEventReceivers_[handler->GetSender()][handler->GetEventType()].Insert(handler->GetReceiver());
+}
+
+void Context::RemoveTypedEventReceiver(TypedEventHandler* handler)
+{
+    TypedEventReceiverGroup* group = GetTypedEventReceivers(handler->GetEventType());
+    if (group)
+        group->Remove(handler);
+    
+    if (handler->IsSpecific())
+    {
+        HashMap<Object*, HashMap<StringHash, HashSet<Object*> > >::Iterator i = specificTypedEventReceivers_.Find(handler->GetSender());
+        if (i != specificTypedEventReceivers_.End())
+        {
+            HashMap<StringHash, HashSet<Object*> >::Iterator j = i->second_.Find(handler->GetEventType());
+            if (j != i->second_.End())
+                j->second_.Erase(handler->GetReceiver());
+        }
+    }
+}
+
+bool Context::HasEventReceivers(Object* sender, StringHash eventType)
+{
+    HashSet<Object*>* group = GetEventReceivers(eventType);
+    if (group && !group->Empty())
+        return true;
+    
+    group = GetEventReceivers(sender, eventType);
+    return group && !group->Empty();
+}
+
 }
@@ -24,11 +24,40 @@
 
 #include "../Core/Attribute.h"
 #include "../Core/Object.h"
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashSet.h"
 
 namespace Urho3D
 {
 
+/// Typed event handlers of one event type in a flat array. Handlers removed while the event is being sent leave an empty slot, which is compacted afterward.
+class URHO3D_API TypedEventReceiverGroup : public RefCounted
+{
+public:
+    /// Construct.
+    TypedEventReceiverGroup();
+    
+    /// Begin event send. Removals are deferred until the send ends.
+    void BeginSendEvent() { ++inSend_; }
+    /// End event send. Compact the array if handlers were removed during it.
+    void EndSendEvent();
+    /// Add a handler.
+    void Add(TypedEventHandler* handler);
+    /// Remove a handler.
+    void Remove(TypedEventHandler* handler);
+    
+    /// Return the handlers. May contain null slots during an event send.
+    const PODVector<TypedEventHandler*>& GetHandlers() const { return handlers_; }
+    
+private:
+    /// Handlers.
+    PODVector<TypedEventHandler*> handlers_;
+    /// Event send nesting level.
+    unsigned inSend_;
+    /// Handlers removed during the send flag.
+    bool dirty_;
+};
+
 /// Urho3D execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class URHO3D_API Context : public RefCounted
 {
@@ -56,6 +85,8 @@ public:
     void RemoveAttribute(StringHash objectType, const char* name);
     /// Update object attribute's default value.
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
+    /// Update object attribute's quantization in network latest data updates.
+    void UpdateAttributeQuantization(StringHash objectType, const char* name, const AttributeQuantization& quantization);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
 
@@ -75,13 +106,15 @@ public:
     template <class T, class U> void CopyBaseAttributes();
     /// Template version of updating an object attribute's default value.
     template <class T> void UpdateAttributeDefaultValue(const char* name, const Variant& defaultValue);
+    /// Template version of updating an object attribute's quantization.
+    template <class T> void UpdateAttributeQuantization(const char* name, const AttributeQuantization& quantization);
 
     /// Return subsystem by type.
     Object* GetSubsystem(StringHash type) const;
     /// Return all subsystems.
     const HashMap<StringHash, SharedPtr<Object> >& GetSubsystems() const { return subsystems_; }
     /// Return all object factories.
-    const HashMap<StringHash, SharedPtr<ObjectFactory> >& GetObjectFactories() const { return factories_; }
+    const FlatHashMap<StringHash, SharedPtr<ObjectFactory> >& GetObjectFactories() const { return factories_; }
     /// Return all object categories.
     const HashMap<String, Vector<StringHash> >& GetObjectCategories() const { return objectCategories_; }
     /// Return active event sender. Null outside event handling.
@@ -133,6 +166,16 @@ public:
         HashMap<StringHash, HashSet<Object*> >::Iterator i = eventReceivers_.Find(eventType);
         return i != eventReceivers_.End() ? &i->second_ : 0;
     }
+    
+    /// Return typed event receivers for an event type, or null if they do not exist.
+    TypedEventReceiverGroup* GetTypedEventReceivers(StringHash eventType) const
+    {
+        FlatHashMap<StringHash, SharedPtr<TypedEventReceiverGroup> >::ConstIterator i = typedEventReceivers_.Find(eventType);
+        return i != typedEventReceivers_.End() ? i->second_.Get() : 0;
+    }
+    
+    /// Return whether a sender's event has VariantMap event receivers, either specific or non-specific.
+    bool HasEventReceivers(Object* sender, StringHash eventType);
 
 private:
     /// Add event receiver.
@@ -145,6 +188,10 @@ private:
     void RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType);
     /// Remove event receiver from non-specific events.
     void RemoveEventReceiver(Object* receiver, StringHash eventType);
+    /// Add typed event handler.
+    void AddTypedEventReceiver(TypedEventHandler* handler);
+    /// Remove typed event handler.
+    void RemoveTypedEventReceiver(TypedEventHandler* handler);
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
     /// Begin event send.
@@ -153,7 +200,7 @@ private:
     void EndSendEvent() { eventSenders_.Pop(); }
 
     /// Object factories.
-    HashMap<StringHash, SharedPtr<ObjectFactory> > factories_;
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory> > factories_;
     /// Subsystems.
     HashMap<StringHash, SharedPtr<Object> > subsystems_;
     /// Attribute descriptions per object type.
@@ -164,6 +211,10 @@ private:
     HashMap<StringHash, HashSet<Object*> > eventReceivers_;
     /// Event receivers for specific senders' events.
     HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificEventReceivers_;
+    /// Typed event handlers per event type. The groups are held by pointer, so that they stay in place while sending.
+    FlatHashMap<StringHash, SharedPtr<TypedEventReceiverGroup> > typedEventReceivers_;
+    /// Typed event receivers for specific senders' events.
+    HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificTypedEventReceivers_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
@@ -183,5 +234,6 @@ template <class T, class U> void Context::CopyBaseAttributes() { CopyBaseAttribu
 template <class T> T* Context::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
 template <class T> AttributeInfo* Context::GetAttribute(const char* name) { return GetAttribute(T::GetTypeStatic(), name); }
 template <class T> void Context::UpdateAttributeDefaultValue(const char* name, const Variant& defaultValue) { UpdateAttributeDefaultValue(T::GetTypeStatic(), name, defaultValue); }
+template <class T> void Context::UpdateAttributeQuantization(const char* name, const AttributeQuantization& quantization) { UpdateAttributeQuantization(T::GetTypeStatic(), name, quantization); }
 
 }
@@ -40,24 +40,96 @@ EVENT(E_UPDATE, Update)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the application-wide logic update event.
+struct UpdateEventData
+{
+    TYPED_EVENT(E_UPDATE);
+    
+    /// Construct.
+    UpdateEventData(float timeStep) :
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const { eventData[Update::P_TIMESTEP] = timeStep_; }
+    
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Application-wide logic post-update event.
 EVENT(E_POSTUPDATE, PostUpdate)
 {
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the application-wide logic post-update event.
+struct PostUpdateEventData
+{
+    TYPED_EVENT(E_POSTUPDATE);
+    
+    /// Construct.
+    PostUpdateEventData(float timeStep) :
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const { eventData[PostUpdate::P_TIMESTEP] = timeStep_; }
+    
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Render update event.
 EVENT(E_RENDERUPDATE, RenderUpdate)
 {
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the render update event.
+struct RenderUpdateEventData
+{
+    TYPED_EVENT(E_RENDERUPDATE);
+    
+    /// Construct.
+    RenderUpdateEventData(float timeStep) :
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const { eventData[RenderUpdate::P_TIMESTEP] = timeStep_; }
+    
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Post-render update event.
 EVENT(E_POSTRENDERUPDATE, PostRenderUpdate)
 {
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the post-render update event.
+struct PostRenderUpdateEventData
+{
+    TYPED_EVENT(E_POSTRENDERUPDATE);
+    
+    /// Construct.
+    PostRenderUpdateEventData(float timeStep) :
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const { eventData[PostRenderUpdate::P_TIMESTEP] = timeStep_; }
+    
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Frame end event.
 EVENT(E_ENDFRAME, EndFrame)
 {
@@ -119,6 +119,50 @@ void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler
     context_->AddEventReceiver(this, sender, eventType);
 }
 
+void Object::SubscribeToEvent(TypedEventHandler* handler)
+{
+    if (!handler)
+        return;
+    
+    // Remove old event handler first
+    TypedEventHandler* previous;
+    TypedEventHandler* oldHandler = FindTypedEventHandler(0, handler->GetEventType(), &previous);
+    if (oldHandler)
+    {
+        context_->RemoveTypedEventReceiver(oldHandler);
+        typedEventHandlers_.Erase(oldHandler, previous);
+    }
+    
+    typedEventHandlers_.InsertFront(handler);
+    
+    context_->AddTypedEventReceiver(handler);
+}
+
+void Object::SubscribeToEvent(Object* sender, TypedEventHandler* handler)
+{
+    // If a null sender was specified, the event can not be subscribed to. Delete the handler in that case
+    if (!sender || !handler)
+    {
+        delete handler;
+        return;
+    }
+    
+    handler->sender_ = sender;
+    handler->specific_ = true;
+    // Remove old event handler first
+    TypedEventHandler* previous;
+    TypedEventHandler* oldHandler = FindTypedEventHandler(sender, handler->GetEventType(), &previous);
+    if (oldHandler)
+    {
+        context_->RemoveTypedEventReceiver(oldHandler);
+        typedEventHandlers_.Erase(oldHandler, previous);
+    }
+    
+    typedEventHandlers_.InsertFront(handler);
+    
+    context_->AddTypedEventReceiver(handler);
+}
+
 void Object::UnsubscribeFromEvent(StringHash eventType)
 {
     for (;;)
@@ -136,6 +180,8 @@ void Object::UnsubscribeFromEvent(StringHash eventType)
         else
             break;
     }
+    
+    RemoveTypedEventHandlers(0, eventType);
 }
 
 void Object::UnsubscribeFromEvent(Object* sender, StringHash eventType)
@@ -150,6 +196,8 @@ void Object::UnsubscribeFromEvent(Object* sender, StringHash eventType)
         context_->RemoveEventReceiver(this, handler->GetSender(), eventType);
         eventHandlers_.Erase(handler, previous);
     }
+    
+    RemoveTypedEventHandlers(sender, eventType);
 }
 
 void Object::UnsubscribeFromEvents(Object* sender)
@@ -169,6 +217,8 @@ void Object::UnsubscribeFromEvents(Object* sender)
         else
             break;
     }
+    
+    RemoveTypedEventHandlers(sender, StringHash::ZERO);
 }
 
 void Object::UnsubscribeFromAllEvents()
@@ -187,6 +237,8 @@ void Object::UnsubscribeFromAllEvents()
         else
             break;
     }
+    
+    RemoveTypedEventHandlers(0, StringHash::ZERO);
 }
 
 void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& exceptions, bool onlyUserData)
@@ -212,6 +264,10 @@ void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& excepti
 
         handler = next;
     }
+    
+    // Typed event handlers have no userdata
+    if (!onlyUserData)
+        RemoveTypedEventHandlers(0, StringHash::ZERO, &exceptions);
 }
 
 void Object::SendEvent(StringHash eventType)
@@ -326,6 +382,53 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+bool Object::DispatchTypedEvent(StringHash eventType, void* eventData)
+{
+    if (!Thread::IsMainThread())
+    {
+        LOGERROR("Sending events is only supported from the main thread");
+        return false;
+    }
+    
+    Context* context = context_;
+    // Hold a reference to the group so that it stays valid even if the handlers unsubscribe
+    SharedPtr<TypedEventReceiverGroup> group(context->GetTypedEventReceivers(eventType));
+    if (group && !group->GetHandlers().Empty())
+    {
+        // Make a weak pointer to self to check for destruction during event handling
+        WeakPtr<Object> self(this);
+        const PODVector<TypedEventHandler*>& handlers = group->GetHandlers();
+        // Handlers subscribed during the send are not invoked until the next send
+        unsigned numHandlers = handlers.Size();
+        
+        context->BeginSendEvent(this);
+        group->BeginSendEvent();
+        
+        for (unsigned i = 0; i < numHandlers; ++i)
+        {
+            // Skip empty slots of handlers removed during the send, and handlers of other specific senders
+            TypedEventHandler* handler = handlers[i];
+            if (!handler || (handler->IsSpecific() && handler->GetSender() != this))
+                continue;
+            
+            handler->Invoke(eventData);
+            
+            // If self has been destroyed as a result of event handling, exit
+            if (self.Expired())
+            {
+                group->EndSendEvent();
+                context->EndSendEvent();
+                return false;
+            }
+        }
+        
+        group->EndSendEvent();
+        context->EndSendEvent();
+    }
+    
+    return context->HasEventReceivers(this, eventType);
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
@@ -348,7 +451,7 @@ EventHandler* Object::GetEventHandler() const
 
 bool Object::HasSubscribedToEvent(StringHash eventType) const
 {
-    return FindEventHandler(eventType) != 0;
+    return FindEventHandler(eventType) != 0 || FindTypedEventHandler(0, eventType) != 0;
 }
 
 bool Object::HasSubscribedToEvent(Object* sender, StringHash eventType) const
@@ -356,7 +459,7 @@ bool Object::HasSubscribedToEvent(Object* sender, StringHash eventType) const
     if (!sender)
         return false;
     else
-        return FindSpecificEventHandler(sender, eventType) != 0;
+        return FindSpecificEventHandler(sender, eventType) != 0 || FindTypedEventHandler(sender, eventType) != 0;
 }
 
 const String& Object::GetCategory() const
@@ -425,6 +528,46 @@ EventHandler* Object::FindSpecificEventHandler(Object* sender, StringHash eventT
     return 0;
 }
 
+TypedEventHandler* Object::FindTypedEventHandler(Object* sender, StringHash eventType, TypedEventHandler** previous) const
+{
+    TypedEventHandler* handler = typedEventHandlers_.First();
+    if (previous)
+        *previous = 0;
+    
+    while (handler)
+    {
+        if (handler->GetSender() == sender && handler->IsSpecific() == (sender != 0) && handler->GetEventType() == eventType)
+            return handler;
+        if (previous)
+            *previous = handler;
+        handler = typedEventHandlers_.Next(handler);
+    }
+    
+    return 0;
+}
+
+void Object::RemoveTypedEventHandlers(Object* sender, StringHash eventType, const PODVector<StringHash>* exceptions)
+{
+    TypedEventHandler* handler = typedEventHandlers_.First();
+    TypedEventHandler* previous = 0;
+    
+    while (handler)
+    {
+        TypedEventHandler* next = typedEventHandlers_.Next(handler);
+        
+        if ((!sender || handler->GetSender() == sender) && (!eventType || handler->GetEventType() == eventType) &&
+            (!exceptions || !exceptions->Contains(handler->GetEventType())))
+        {
+            context_->RemoveTypedEventReceiver(handler);
+            typedEventHandlers_.Erase(handler, previous);
+        }
+        else
+            previous = handler;
+        
+        handler = next;
+    }
+}
+
 void Object::RemoveEventSender(Object* sender)
 {
     EventHandler* handler = eventHandlers_.First();
@@ -444,6 +587,8 @@ void Object::RemoveEventSender(Object* sender)
             handler = eventHandlers_.Next(handler);
         }
     }
+    
+    RemoveTypedEventHandlers(sender, StringHash::ZERO);
 }
 
 }
@@ -30,6 +30,7 @@ namespace Urho3D
 
 class Context;
 class EventHandler;
+class TypedEventHandler;
 
 #define OBJECT(typeName) \
     public: \
@@ -37,12 +38,12 @@ class EventHandler;
         virtual Urho3D::StringHash GetType() const { return GetTypeStatic(); } \
         virtual Urho3D::StringHash GetBaseType() const { return GetBaseTypeStatic(); } \
         virtual const Urho3D::String& GetTypeName() const { return GetTypeNameStatic(); } \
-        static Urho3D::StringHash GetTypeStatic() { static const Urho3D::StringHash typeStatic(#typeName); return typeStatic; } \
+        static Urho3D::StringHash GetTypeStatic() { static const Urho3D::StringHash typeStatic(URHO3D_HASH_LITERAL(#typeName)); return typeStatic; } \
         static const Urho3D::String& GetTypeNameStatic() { static const Urho3D::String typeNameStatic(#typeName); return typeNameStatic; } \
 
 #define BASEOBJECT(typeName) \
     public: \
-        static Urho3D::StringHash GetBaseTypeStatic() { static const Urho3D::StringHash baseTypeStatic(#typeName); return baseTypeStatic; } \
+        static Urho3D::StringHash GetBaseTypeStatic() { static const Urho3D::StringHash baseTypeStatic(URHO3D_HASH_LITERAL(#typeName)); return baseTypeStatic; } \
 
 /// Base class for objects with type identification, subsystem access and event sending/receiving capability.
 class URHO3D_API Object : public RefCounted
@@ -70,7 +71,11 @@ public:
     void SubscribeToEvent(StringHash eventType, EventHandler* handler);
     /// Subscribe to a specific sender's event.
     void SubscribeToEvent(Object* sender, StringHash eventType, EventHandler* handler);
-    /// Unsubscribe from an event.
+    /// Subscribe to a typed event that can be sent by any sender. The event type is defined by the handler's event data structure.
+    void SubscribeToEvent(TypedEventHandler* handler);
+    /// Subscribe to a specific sender's typed event.
+    void SubscribeToEvent(Object* sender, TypedEventHandler* handler);
+    /// Unsubscribe from an event. Removes both VariantMap and typed event handlers.
     void UnsubscribeFromEvent(StringHash eventType);
     /// Unsubscribe from a specific sender's event.
     void UnsubscribeFromEvent(Object* sender, StringHash eventType);
@@ -80,10 +85,12 @@ public:
     void UnsubscribeFromAllEvents();
     /// Unsubscribe from all events except those listed, and optionally only those with userdata (script registered events.)
     void UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& exceptions, bool onlyUserData);
-    /// Send event to all subscribers.
+    /// Send event to all subscribers. Does not reach typed event handlers.
     void SendEvent(StringHash eventType);
-    /// Send event with parameters to all subscribers.
+    /// Send event with parameters to all subscribers. Does not reach typed event handlers, so for example the update events which the scene subscribes to typed must be sent with SendTypedEvent().
     void SendEvent(StringHash eventType, VariantMap& eventData);
+    /// Send a typed event to all subscribers. Typed event handlers receive the data structure directly, after which it is converted to a VariantMap for the event handlers subscribed with a StringHash event type, such as script functions, if there are any.
+    template <class T> void SendTypedEvent(T& eventData);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
     
@@ -100,7 +107,7 @@ public:
     /// Return whether has subscribed to a specific sender's event.
     bool HasSubscribedToEvent(Object* sender, StringHash eventType) const;
     /// Return whether has subscribed to any event.
-    bool HasEventHandlers() const { return !eventHandlers_.Empty(); }
+    bool HasEventHandlers() const { return !eventHandlers_.Empty() || !typedEventHandlers_.Empty(); }
     /// Template version of returning a subsystem.
     template <class T> T* GetSubsystem() const;
     /// Return object category. Categories are (optionally) registered along with the object factory. Return an empty string if the object category is not registered.
@@ -119,13 +126,32 @@ private:
     EventHandler* FindSpecificEventHandler(Object* sender, StringHash eventType, EventHandler** previous = 0) const;
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
+    /// Find the typed event handler with specific sender and event type. Null sender finds the non-specific handler.
+    TypedEventHandler* FindTypedEventHandler(Object* sender, StringHash eventType, TypedEventHandler** previous = 0) const;
+    /// Remove typed event handlers, optionally only those of a specific sender and/or event type, and except the listed event types.
+    void RemoveTypedEventHandlers(Object* sender, StringHash eventType, const PODVector<StringHash>* exceptions = 0);
+    /// Send a typed event to the typed event handlers. Return true if it should also be sent as a VariantMap event.
+    bool DispatchTypedEvent(StringHash eventType, void* eventData);
     
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
+    /// Typed event handlers.
+    LinkedList<TypedEventHandler> typedEventHandlers_;
 };
 
 template <class T> T* Object::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
 
+template <class T> void Object::SendTypedEvent(T& eventData)
+{
+    StringHash eventType = T::GetEventTypeStatic();
+    if (DispatchTypedEvent(eventType, &eventData))
+    {
+        VariantMap& variantEventData = GetEventDataMap();
+        eventData.ToVariantMap(variantEventData);
+        SendEvent(eventType, variantEventData);
+    }
+}
+
 /// Base class for object factories.
 class URHO3D_API ObjectFactory : public RefCounted
 {
@@ -274,13 +300,94 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Internal helper class for invoking typed event handler functions. Stored in a flat array per event type for dispatch.
+class URHO3D_API TypedEventHandler : public LinkedListNode
+{
+    friend class Object;
+    friend class TypedEventReceiverGroup;
+    
+public:
+    /// Construct with specified receiver and event type.
+    TypedEventHandler(Object* receiver, StringHash eventType) :
+        receiver_(receiver),
+        eventType_(eventType),
+        index_(M_MAX_UNSIGNED),
+        specific_(false)
+    {
+        assert(receiver_);
+    }
+    
+    /// Destruct.
+    virtual ~TypedEventHandler() {}
+    
+    /// Invoke event handler function with a pointer to the event data structure.
+    virtual void Invoke(void* eventData) = 0;
+    
+    /// Return event receiver.
+    Object* GetReceiver() const { return receiver_; }
+    /// Return event sender. Null if the handler is non-specific.
+    Object* GetSender() const { return sender_.Get(); }
+    /// Return event type.
+    const StringHash& GetEventType() const { return eventType_; }
+    /// Return whether the handler is for a specific sender.
+    bool IsSpecific() const { return specific_; }
+    
+protected:
+    /// Event receiver.
+    Object* receiver_;
+    /// Event sender. The handler is removed when the sender is destroyed.
+    WeakPtr<Object> sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Index in the receiver group of the event type.
+    unsigned index_;
+    /// Specific sender flag.
+    bool specific_;
+};
+
+/// Template implementation of the typed event handler invoke helper (stores a function pointer of specific class.)
+template <class T, class U> class TypedEventHandlerImpl : public TypedEventHandler
+{
+public:
+    typedef void (T::*HandlerFunctionPtr)(U&);
+    
+    /// Construct with receiver and function pointers.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function) :
+        TypedEventHandler(receiver, U::GetEventTypeStatic()),
+        function_(function)
+    {
+        assert(function_);
+    }
+    
+    /// Invoke event handler function.
+    virtual void Invoke(void* eventData)
+    {
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(*static_cast<U*>(eventData));
+    }
+    
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+/// Construct a typed event handler, deducing the event data structure from the handler function.
+template <class T, class U> TypedEventHandler* CreateTypedEventHandler(T* receiver, void (T::*function)(U&))
+{
+    return new TypedEventHandlerImpl<T, U>(receiver, function);
+}
+
 /// Describe an event's hash ID and begin a namespace in which to define its parameters.
-#define EVENT(eventID, eventName) static const Urho3D::StringHash eventID(#eventName); namespace eventName
+#define EVENT(eventID, eventName) static const Urho3D::StringHash eventID(URHO3D_HASH_LITERAL(#eventName)); namespace eventName
 /// Describe an event's parameter hash ID. Should be used inside an event namespace.
-#define PARAM(paramID, paramName) static const Urho3D::StringHash paramID(#paramName)
+#define PARAM(paramID, paramName) static const Urho3D::StringHash paramID(URHO3D_HASH_LITERAL(#paramName))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function.
 #define HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
 #define HANDLER_USERDATA(className, function, userData) (new Urho3D::EventHandlerImpl<className>(this, &className::function, userData))
+/// Describe the event hash ID of a typed event data structure. The structure must also define ToVariantMap() to fill the event's parameters.
+#define TYPED_EVENT(eventID) static Urho3D::StringHash GetEventTypeStatic() { return eventID; }
+/// Convenience macro to construct a TypedEventHandler that points to a receiver object and its member function taking the event data structure.
+#define TYPED_HANDLER(className, function) (Urho3D::CreateTypedEventHandler<className>(this, &className::function))
 
 }
@@ -22,6 +22,9 @@
 
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../IO/Log.h"
+#include "../Math/BoundingBox.h"
+#include "../IO/Serializer.h"
 
 #include <cstdio>
 #include <cstring>
@@ -33,20 +36,71 @@ namespace Urho3D
 
 static const int LINE_MAX_LENGTH = 256;
 static const int NAME_MAX_LENGTH = 30;
+static const unsigned MAX_TRACE_EVENTS = 4000000;
+
+/// Profiler which counts the container heap allocations.
+static Profiler* allocationProfiler = 0;
+
+/// Profiling data of a thread other than the main thread.
+class ProfilerThread
+{
+public:
+    /// Construct.
+    ProfilerThread(ThreadID id, unsigned index) :
+        id_(id),
+        index_(index)
+    {
+        root_ = new ProfilerBlock(0, "Root");
+        current_ = root_;
+    }
+    
+    /// Destruct.
+    ~ProfilerThread()
+    {
+        delete root_;
+        root_ = 0;
+    }
+    
+    /// Thread ID.
+    ThreadID id_;
+    /// Thread index in trace output.
+    unsigned index_;
+    /// Root profiling block.
+    ProfilerBlock* root_;
+    /// Current profiling block.
+    ProfilerBlock* current_;
+    /// Trace events recorded since the last merge.
+    PODVector<ProfilerTraceEvent> traceEvents_;
+    /// Mutex held by the thread while recording and by the main thread while merging. Normally uncontended.
+    Mutex mutex_;
+};
 
 Profiler::Profiler(Context* context) :
     Object(context),
     current_(0),
     root_(0),
     intervalFrames_(0),
-    totalFrames_(0)
+    totalFrames_(0),
+    tracing_(false),
+    allocationTracking_(false)
 {
     root_ = new ProfilerBlock(0, "Root");
     current_ = root_;
+    
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS; ++i)
+        threads_[i] = 0;
 }
 
 Profiler::~Profiler()
 {
+    SetAllocationTracking(false);
+    
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS; ++i)
+    {
+        delete threads_[i];
+        threads_[i] = 0;
+    }
+    
     delete root_;
     root_ = 0;
 }
@@ -70,6 +124,22 @@ void Profiler::EndFrame()
             ++totalFrames_;
         root_->EndFrame();
         current_ = root_;
+        
+        // Update the frame values of the other threads
+        for (unsigned i = 0; i < MAX_PROFILER_THREADS && threads_[i]; ++i)
+        {
+            ProfilerThread* thread = threads_[i];
+            MutexLock lock(thread->mutex_);
+            thread->root_->EndFrame();
+        }
+        
+        MergeTraceEvents();
+        
+        if (tracing_ && traceEvents_.Size() >= MAX_TRACE_EVENTS)
+        {
+            LOGWARNING("Profiler trace event limit reached, stopping trace");
+            StopTrace();
+        }
     }
 }
 
@@ -77,6 +147,68 @@ void Profiler::BeginInterval()
 {
     root_->BeginInterval();
     intervalFrames_ = 0;
+    
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS && threads_[i]; ++i)
+    {
+        ProfilerThread* thread = threads_[i];
+        MutexLock lock(thread->mutex_);
+        thread->root_->BeginInterval();
+    }
+}
+
+void Profiler::StartTrace()
+{
+    // Discard events still pending from a previous trace
+    MergeTraceEvents();
+    traceEvents_.Clear();
+    tracing_ = true;
+}
+
+void Profiler::StopTrace()
+{
+    tracing_ = false;
+    MergeTraceEvents();
+}
+
+bool Profiler::SaveTrace(Serializer& dest)
+{
+    MergeTraceEvents();
+    
+    char line[LINE_MAX_LENGTH];
+    bool success = true;
+    
+    String header("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    success &= dest.Write(header.CString(), header.Length()) == header.Length();
+    
+    // Name the threads first, the timeline shows them in this order
+    sprintf(line, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Main\"}}");
+    success &= dest.Write(line, strlen(line)) == strlen(line);
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS && threads_[i]; ++i)
+    {
+        sprintf(line, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+            threads_[i]->index_, threads_[i]->index_);
+        success &= dest.Write(line, strlen(line)) == strlen(line);
+    }
+    
+    for (PODVector<ProfilerTraceEvent>::ConstIterator i = traceEvents_.Begin(); i != traceEvents_.End(); ++i)
+    {
+        String name(i->name_);
+        name.Replace("\\", "\\\\");
+        name.Replace("\"", "\\\"");
+        if (name.Length() > NAME_MAX_LENGTH * 4)
+            name.Resize(NAME_MAX_LENGTH * 4);
+        
+        sprintf(line, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":0,\"tid\":%u}", name.CString(),
+            i->begin_, i->duration_, i->threadIndex_);
+        success &= dest.Write(line, strlen(line)) == strlen(line);
+    }
+    
+    String footer("\n]}\n");
+    success &= dest.Write(footer.CString(), footer.Length()) == footer.Length();
+    
+    if (!success)
+        LOGERROR("Failed to write profiler trace");
+    return success;
 }
 
 String Profiler::GetData(bool showUnused, bool showTotal, unsigned maxDepth) const
@@ -84,11 +216,16 @@ String Profiler::GetData(bool showUnused, bool showTotal, unsigned maxDepth) con
     String output;
     
     if (!showTotal)
-        output += String("Block                            Cnt     Avg      Max     Frame     Total\n\n");
+    {
+        output += String("Block                            Cnt     Avg      Max     Frame     Total");
+        output += allocationTracking_ ? String("   Allocs      Bytes\n\n") : String("\n\n");
+    }
     else
     {
-        output += String("Block                                       Last frame                       Whole execution time\n\n");
-        output += String("                                 Cnt     Avg      Max      Total      Cnt      Avg       Max        Total\n\n");
+        output += String("Block                                       Last frame                       Whole execution time");
+        output += allocationTracking_ ? String("           Last frame\n\n") : String("\n\n");
+        output += String("                                 Cnt     Avg      Max      Total      Cnt      Avg       Max        Total");
+        output += allocationTracking_ ? String("   Allocs      Bytes\n\n") : String("\n\n");
     }
     
     if (!maxDepth)
@@ -96,6 +233,17 @@ String Profiler::GetData(bool showUnused, bool showTotal, unsigned maxDepth) con
     
     GetData(root_, output, 0, maxDepth, showUnused, showTotal);
     
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS && threads_[i]; ++i)
+    {
+        ProfilerThread* thread = threads_[i];
+        MutexLock lock(thread->mutex_);
+        if (HasData(thread->root_, showUnused, showTotal))
+        {
+            output += "\nThread " + String(thread->index_) + "\n\n";
+            GetData(thread->root_, output, 0, maxDepth, showUnused, showTotal);
+        }
+    }
+    
     return output;
 }
 
@@ -110,7 +258,7 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
         return;
     
     // Do not print the root block as it does not collect any actual data
-    if (block != root_)
+    if (block->parent_)
     {
         if (showUnused || block->intervalCount_ || (showTotal && block->totalCount_))
         {
@@ -127,8 +275,15 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
                 float frame = block->intervalTime_ / intervalFrames / 1000.0f;
                 float all = block->intervalTime_ / 1000.0f;
         
-                sprintf(line, "%s %5u %8.3f %8.3f %8.3f %9.3f\n", indentedName, Min(block->intervalCount_, 99999),
+                sprintf(line, "%s %5u %8.3f %8.3f %8.3f %9.3f", indentedName, Min(block->intervalCount_, 99999),
                     avg, max, frame, all);
+                
+                if (allocationTracking_)
+                {
+                    float frameAllocs = (float)block->intervalAllocCount_ / intervalFrames;
+                    float frameBytes = (float)block->intervalAllocBytes_ / intervalFrames;
+                    sprintf(line + strlen(line), " %8.1f %10.0f", frameAllocs, frameBytes);
+                }
             }
             else
             {
@@ -140,10 +295,14 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
                 float totalMax = block->totalMaxTime_ / 1000.0f;
                 float totalAll = block->totalTime_ / 1000.0f;
                 
-                sprintf(line, "%s %5u %8.3f %8.3f %9.3f  %7u %9.3f %9.3f %11.3f\n", indentedName, Min(block->frameCount_, 99999),
+                sprintf(line, "%s %5u %8.3f %8.3f %9.3f  %7u %9.3f %9.3f %11.3f", indentedName, Min(block->frameCount_, 99999),
                     avg, max, all, Min(block->totalCount_, 99999), totalAvg, totalMax, totalAll);
+                
+                if (allocationTracking_)
+                    sprintf(line + strlen(line), " %8u %10lld", block->frameAllocCount_, block->frameAllocBytes_);
             }
             
+            strcat(line, "\n");
             output += String(line);
         }
         
@@ -154,4 +313,132 @@ void Profiler::GetData(ProfilerBlock* block, String& output, unsigned depth, uns
         GetData(*i, output, depth, maxDepth, showUnused, showTotal);
 }
 
+bool Profiler::HasData(ProfilerBlock* block, bool showUnused, bool showTotal) const
+{
+    if (block->parent_ && (showUnused || block->intervalCount_ || (showTotal && block->totalCount_)))
+        return true;
+    
+    for (PODVector<ProfilerBlock*>::ConstIterator i = block->children_.Begin(); i != block->children_.End(); ++i)
+    {
+        if (HasData(*i, showUnused, showTotal))
+            return true;
+    }
+    
+    return false;
+}
+
+void Profiler::BeginThreadBlock(const char* name)
+{
+    ProfilerThread* thread = GetThread();
+    if (!thread)
+        return;
+    
+    MutexLock lock(thread->mutex_);
+    thread->current_ = thread->current_->GetChild(name);
+    thread->current_->Begin();
+    thread->current_->traceBegin_ = tracing_ ? traceTimer_.GetUSec(false) : -1;
+}
+
+void Profiler::EndThreadBlock()
+{
+    ProfilerThread* thread = GetThread();
+    if (!thread)
+        return;
+    
+    MutexLock lock(thread->mutex_);
+    ProfilerBlock* block = thread->current_;
+    if (block != thread->root_)
+    {
+        long long time = block->End();
+        if (block->traceBegin_ >= 0 && tracing_)
+            AddTraceEvent(thread->traceEvents_, block, time, thread->index_);
+        thread->current_ = block->parent_;
+    }
+}
+
+ProfilerThread* Profiler::GetThread()
+{
+    ThreadID id = Thread::GetCurrentThreadID();
+    
+    // Threads are never unregistered, so search without locking first
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS && threads_[i]; ++i)
+    {
+        if (threads_[i]->id_ == id)
+            return threads_[i];
+    }
+    
+    MutexLock lock(threadsMutex_);
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS; ++i)
+    {
+        if (!threads_[i])
+        {
+            // Construct fully before publishing to the searching threads
+            ProfilerThread* thread = new ProfilerThread(id, i + 1);
+            threads_[i] = thread;
+            return thread;
+        }
+    }
+    
+    return 0;
+}
+
+void Profiler::SetAllocationTracking(bool enable)
+{
+    if (enable)
+    {
+        allocationProfiler = this;
+        SetAllocationHook(HandleAllocation);
+        allocationTracking_ = true;
+    }
+    else if (allocationTracking_)
+    {
+        if (allocationProfiler == this)
+        {
+            SetAllocationHook(0);
+            allocationProfiler = 0;
+        }
+        allocationTracking_ = false;
+    }
+}
+
+void Profiler::AddAllocation(unsigned size)
+{
+    if (Thread::IsMainThread())
+    {
+        ++current_->allocCount_;
+        current_->allocBytes_ += size;
+    }
+    else
+    {
+        ProfilerThread* thread = GetThread();
+        if (!thread)
+            return;
+        
+        MutexLock lock(thread->mutex_);
+        ++thread->current_->allocCount_;
+        thread->current_->allocBytes_ += size;
+    }
+}
+
+void Profiler::HandleAllocation(unsigned size)
+{
+    Profiler* profiler = allocationProfiler;
+    if (profiler)
+        profiler->AddAllocation(size);
+}
+
+void Profiler::MergeTraceEvents()
+{
+    for (unsigned i = 0; i < MAX_PROFILER_THREADS && threads_[i]; ++i)
+    {
+        ProfilerThread* thread = threads_[i];
+        MutexLock lock(thread->mutex_);
+        if (thread->traceEvents_.Size())
+        {
+            traceEvents_.Push(thread->traceEvents_);
+            thread->traceEvents_.Clear();
+        }
+    }
+}
+
 }
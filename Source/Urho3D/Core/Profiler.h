@@ -23,12 +23,19 @@
 #pragma once
 
 #include "../Container/Str.h"
+#include "../Core/Mutex.h"
 #include "../Core/Thread.h"
 #include "../Core/Timer.h"
 
 namespace Urho3D
 {
 
+class ProfilerThread;
+class Serializer;
+
+/// Maximum number of threads other than the main thread that can be profiled.
+static const unsigned MAX_PROFILER_THREADS = 64;
+
 /// Profiling data for one block in the profiling tree.
 class URHO3D_API ProfilerBlock
 {
@@ -36,9 +43,12 @@ public:
     /// Construct with the specified parent block and name.
     ProfilerBlock(ProfilerBlock* parent, const char* name) :
         name_(0),
+        traceBegin_(-1),
         time_(0),
         maxTime_(0),
         count_(0),
+        allocCount_(0),
+        allocBytes_(0),
         parent_(parent),
         frameTime_(0),
         frameMaxTime_(0),
@@ -48,7 +58,13 @@ public:
         intervalCount_(0),
         totalTime_(0),
         totalMaxTime_(0),
-        totalCount_(0)
+        totalCount_(0),
+        frameAllocCount_(0),
+        frameAllocBytes_(0),
+        intervalAllocCount_(0),
+        intervalAllocBytes_(0),
+        totalAllocCount_(0),
+        totalAllocBytes_(0)
     {
         if (name)
         {
@@ -77,13 +93,14 @@ public:
         ++count_;
     }
     
-    /// End timing.
-    void End()
+    /// End timing. Return the block duration.
+    long long End()
     {
         long long time = timer_.GetUSec(false);
         if (time > maxTime_)
             maxTime_ = time;
         time_ += time;
+        return time;
     }
     
     /// End profiling frame and update interval and total values.
@@ -100,9 +117,17 @@ public:
         if (maxTime_ > totalMaxTime_)
             totalMaxTime_ = maxTime_;
         totalCount_ += count_;
+        frameAllocCount_ = allocCount_;
+        frameAllocBytes_ = allocBytes_;
+        intervalAllocCount_ += allocCount_;
+        intervalAllocBytes_ += allocBytes_;
+        totalAllocCount_ += allocCount_;
+        totalAllocBytes_ += allocBytes_;
         time_ = 0;
         maxTime_ = 0;
         count_ = 0;
+        allocCount_ = 0;
+        allocBytes_ = 0;
         
         for (PODVector<ProfilerBlock*>::Iterator i = children_.Begin(); i != children_.End(); ++i)
             (*i)->EndFrame();
@@ -114,6 +139,8 @@ public:
         intervalTime_ = 0;
         intervalMaxTime_ = 0;
         intervalCount_ = 0;
+        intervalAllocCount_ = 0;
+        intervalAllocBytes_ = 0;
         
         for (PODVector<ProfilerBlock*>::Iterator i = children_.Begin(); i != children_.End(); ++i)
             (*i)->BeginInterval();
@@ -138,12 +165,18 @@ public:
     char* name_;
     /// High-resolution timer for measuring the block duration.
     HiresTimer timer_;
+    /// Start time of the current call on the trace timeline, or -1 if not tracing.
+    long long traceBegin_;
     /// Time on current frame.
     long long time_;
     /// Maximum time on current frame.
     long long maxTime_;
     /// Calls on current frame.
     unsigned count_;
+    /// Heap allocations on current frame.
+    unsigned allocCount_;
+    /// Heap allocated bytes on current frame.
+    long long allocBytes_;
     /// Parent block.
     ProfilerBlock* parent_;
     /// Child blocks.
@@ -166,6 +199,31 @@ public:
     long long totalMaxTime_;
     /// Total accumulated calls.
     unsigned totalCount_;
+    /// Heap allocations on the previous frame.
+    unsigned frameAllocCount_;
+    /// Heap allocated bytes on the previous frame.
+    long long frameAllocBytes_;
+    /// Heap allocations during current profiler interval.
+    unsigned intervalAllocCount_;
+    /// Heap allocated bytes during current profiler interval.
+    long long intervalAllocBytes_;
+    /// Total accumulated heap allocations.
+    unsigned totalAllocCount_;
+    /// Total accumulated heap allocated bytes.
+    long long totalAllocBytes_;
+};
+
+/// Timed call of a profiling block on the trace timeline.
+struct ProfilerTraceEvent
+{
+    /// Block name.
+    const char* name_;
+    /// Start time in microseconds.
+    long long begin_;
+    /// Duration in microseconds.
+    long long duration_;
+    /// Thread index. 0 is the main thread.
+    unsigned threadIndex_;
 };
 
 /// Hierarchical performance profiler subsystem.
@@ -182,23 +240,32 @@ public:
     /// Begin timing a profiling block.
     void BeginBlock(const char* name)
     {
-        // Profiler supports only the main thread currently
+        // Other threads record into their own block trees
         if (!Thread::IsMainThread())
+        {
+            BeginThreadBlock(name);
             return;
+        }
         
         current_ = current_->GetChild(name);
         current_->Begin();
+        current_->traceBegin_ = tracing_ ? traceTimer_.GetUSec(false) : -1;
     }
     
     /// End timing the current profiling block.
     void EndBlock()
     {
         if (!Thread::IsMainThread())
+        {
+            EndThreadBlock();
             return;
+        }
         
         if (current_ != root_)
         {
-            current_->End();
+            long long time = current_->End();
+            if (current_->traceBegin_ >= 0 && tracing_)
+                AddTraceEvent(traceEvents_, current_, time, 0);
             current_ = current_->parent_;
         }
     }
@@ -209,6 +276,14 @@ public:
     void EndFrame();
     /// Begin a new interval.
     void BeginInterval();
+    /// Start recording the profiling blocks of all threads on a timeline. Clears the previously recorded trace.
+    void StartTrace();
+    /// Stop recording the trace. The recorded trace is kept until the next StartTrace().
+    void StopTrace();
+    /// Write the recorded trace in Chrome trace event JSON format. Return true if successful.
+    bool SaveTrace(Serializer& dest);
+    /// Set whether to count the container heap allocations of each profiling block. Only one profiler can count allocations at a time.
+    void SetAllocationTracking(bool enable);
     
     /// Return profiling data as text output.
     String GetData(bool showUnused = false, bool showTotal = false, unsigned maxDepth = M_MAX_UNSIGNED) const;
@@ -216,10 +291,40 @@ public:
     const ProfilerBlock* GetCurrentBlock() { return current_; }
     /// Return the root profiling block.
     const ProfilerBlock* GetRootBlock() { return root_; }
+    /// Return whether a trace is being recorded.
+    bool IsTracing() const { return tracing_; }
+    /// Return whether container heap allocations are counted.
+    bool GetAllocationTracking() const { return allocationTracking_; }
+    /// Return number of recorded trace events.
+    unsigned GetNumTraceEvents() const { return traceEvents_.Size(); }
     
 private:
     /// Return profiling data as text output for a specified profiling block.
     void GetData(ProfilerBlock* block, String& output, unsigned depth, unsigned maxDepth, bool showUnused, bool showTotal) const;
+    /// Return whether a block or its children have data to show.
+    bool HasData(ProfilerBlock* block, bool showUnused, bool showTotal) const;
+    /// Begin timing a profiling block outside the main thread.
+    void BeginThreadBlock(const char* name);
+    /// End timing the current profiling block outside the main thread.
+    void EndThreadBlock();
+    /// Return the profiling data of the calling thread, registering it on first use. Return null if too many threads.
+    ProfilerThread* GetThread();
+    /// Move the trace events recorded by other threads to the main trace.
+    void MergeTraceEvents();
+    /// Count a heap allocation to the current profiling block of the calling thread.
+    void AddAllocation(unsigned size);
+    /// Container allocation hook function.
+    static void HandleAllocation(unsigned size);
+    /// Record a trace event for a block that just ended.
+    void AddTraceEvent(PODVector<ProfilerTraceEvent>& events, ProfilerBlock* block, long long duration, unsigned threadIndex)
+    {
+        ProfilerTraceEvent event;
+        event.name_ = block->name_;
+        event.begin_ = block->traceBegin_;
+        event.duration_ = duration;
+        event.threadIndex_ = threadIndex;
+        events.Push(event);
+    }
     
     /// Current profiling block.
     ProfilerBlock* current_;
@@ -229,6 +334,18 @@ private:
     unsigned intervalFrames_;
     /// Total frames.
     unsigned totalFrames_;
+    /// Profiling data of other threads. Entries are only added, so they can be searched without locking.
+    ProfilerThread* volatile threads_[MAX_PROFILER_THREADS];
+    /// Mutex for registering other threads.
+    Mutex threadsMutex_;
+    /// Timer for the trace timeline.
+    HiresTimer traceTimer_;
+    /// Recorded trace events.
+    PODVector<ProfilerTraceEvent> traceEvents_;
+    /// Trace recording flag.
+    volatile bool tracing_;
+    /// Allocation tracking flag.
+    bool allocationTracking_;
 };
 
 /// Helper class for automatically beginning and ending a profiling block
@@ -60,8 +60,78 @@ private:
     unsigned index_;
 };
 
+/// Prioritized work item queue owned by one thread. Other threads may steal from it.
+class WorkItemQueue : public RefCounted
+{
+public:
+    /// Construct.
+    WorkItemQueue() :
+        size_(0)
+    {
+    }
+    
+    /// Add a work item. Items are kept sorted in ascending priority, so that the highest priority item is at the back. Items with equal priority are taken in LIFO order.
+    void Push(WorkItem* item)
+    {
+        MutexLock lock(mutex_);
+        
+        unsigned i = items_.Size();
+        while (i > 0 && items_[i - 1]->priority_ > item->priority_)
+            --i;
+        items_.Insert(i, item);
+        size_ = items_.Size();
+    }
+    
+    /// Take the highest priority work item if it has at least the specified priority. Return null if none.
+    WorkItem* Pop(unsigned priority)
+    {
+        // Do not contend for the mutex of an empty queue
+        if (!size_)
+            return 0;
+        
+        MutexLock lock(mutex_);
+        
+        if (items_.Empty() || items_.Back()->priority_ < priority)
+            return 0;
+        
+        WorkItem* item = items_.Back();
+        items_.Pop();
+        size_ = items_.Size();
+        return item;
+    }
+    
+    /// Remove a work item before it has been taken for execution. Return true if successfully removed.
+    bool Remove(WorkItem* item)
+    {
+        MutexLock lock(mutex_);
+        
+        PODVector<WorkItem*>::Iterator i = items_.Find(item);
+        if (i == items_.End())
+            return false;
+        
+        items_.Erase(i);
+        size_ = items_.Size();
+        return true;
+    }
+    
+    /// Return whether has no work items.
+    bool Empty() const { return size_ == 0; }
+    
+    /// Statistics of the owning thread. Only modified by the owning thread.
+    WorkQueueThreadStats stats_;
+    
+private:
+    /// Work items sorted by priority.
+    PODVector<WorkItem*> items_;
+    /// Queue mutex.
+    Mutex mutex_;
+    /// Number of work items, for checking emptiness without locking.
+    volatile unsigned size_;
+};
+
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    nextQueue_(0),
     shutDown_(false),
     pausing_(false),
     paused_(false),
@@ -69,6 +139,9 @@ WorkQueue::WorkQueue(Context* context) :
     lastSize_(0),
     maxNonThreadedWorkMs_(5)
 {
+    // The main thread queue is used for all work when there are no worker threads
+    queues_.Push(SharedPtr<WorkItemQueue>(new WorkItemQueue()));
+    
     SubscribeToEvent(E_BEGINFRAME, HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -80,6 +153,12 @@ WorkQueue::~WorkQueue()
     
     for (unsigned i = 0; i < threads_.Size(); ++i)
         threads_[i]->Stop();
+    
+    // Release the references held by the work item collection and the pool
+    for (unsigned i = 0; i < workItems_.Size(); ++i)
+        workItems_[i]->ReleaseRef();
+    for (unsigned i = 0; i < poolItems_.Size(); ++i)
+        poolItems_[i]->ReleaseRef();
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -92,6 +171,15 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
     
+    #ifdef URHO3D_PROFILING
+    // Look up the profiler now, as the subsystems can not be safely accessed from the worker threads
+    profiler_ = GetSubsystem<Profiler>();
+    #endif
+    
+    // Create all queues before starting the threads, as threads may steal from any queue
+    for (unsigned i = 0; i < numThreads; ++i)
+        queues_.Push(SharedPtr<WorkItemQueue>(new WorkItemQueue()));
+    
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -102,22 +190,14 @@ void WorkQueue::CreateThreads(unsigned numThreads)
 
 SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
-    if (poolItems_.Size() > 0)
-    {
-        SharedPtr<WorkItem> item = poolItems_.Front();
-        poolItems_.PopFront();
-        return item;
-    }
-    else
-    {
-        // No usable items found, create a new one set it as pooled and return it.
-        SharedPtr<WorkItem> item(new WorkItem());
-        item->pooled_ = true;
-        return item;
-    }
+    // Hand the reference taken from the pool over to the returned pointer
+    WorkItem* item = TakeFreeItem();
+    SharedPtr<WorkItem> ret(item);
+    item->ReleaseRef();
+    return ret;
 }
 
-void WorkQueue::AddWorkItem(SharedPtr<WorkItem> item)
+void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
 {
     if (!item)
     {
@@ -125,57 +205,52 @@ void WorkQueue::AddWorkItem(SharedPtr<WorkItem> item)
         return;
     }
     
-    // Check for duplicate items.
-    assert(!workItems_.Contains(item));
-    
-    // Push to the main thread list to keep item alive
-    // Clear completed flag in case item is reused
-    workItems_.Push(item);
-    item->completed_ = false;
+    // The work item collection holds a reference to keep the item alive
+    item->AddRef();
+    AddItem(item.Get(), 0, 0);
+}
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.Acquire();
-    
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
+void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item, const PODVector<WorkItem*>& dependencies)
+{
+    if (!item)
     {
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
-        {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.Insert(i, item);
-                break;
-            }
-        }
+        LOGERROR("Null work item submitted to the work queue");
+        return;
     }
     
-    if (threads_.Size())
+    item->AddRef();
+    AddItem(item.Get(), dependencies.Begin().ptr_, dependencies.Size());
+}
+
+void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item, WorkItem* dependency)
+{
+    if (!item)
     {
-        queueMutex_.Release();
-        paused_ = false;
+        LOGERROR("Null work item submitted to the work queue");
+        return;
     }
+    
+    item->AddRef();
+    AddItem(item.Get(), &dependency, 1);
 }
 
-bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
+bool WorkQueue::RemoveWorkItem(const SharedPtr<WorkItem>& item)
 {
     if (!item)
         return false;
 
-    MutexLock lock(queueMutex_);
+    PODVector<WorkItem*>::Iterator i = workItems_.Find(item.Get());
+    if (i == workItems_.End())
+        return false;
     
     // Can only remove successfully if the item was not yet taken by threads for execution
-    List<WorkItem*>::Iterator i = queue_.Find(item.Get());
-    if (i != queue_.End())
+    for (unsigned j = 0; j < queues_.Size(); ++j)
     {
-        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
-        if (j != workItems_.End())
+        if (queues_[j]->Remove(item.Get()))
         {
-            queue_.Erase(i);
-            ReturnToPool(item);
-            workItems_.Erase(j);
+            workItems_.Erase(i);
+            ReleaseDependents(item.Get());
+            ReturnToPool(item.Get());
             return true;
         }
     }
@@ -185,23 +260,12 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 
 unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
 {
-    MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
     for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
     {
-        List<WorkItem*>::Iterator j = queue_.Find(i->Get());
-        if (j != queue_.End())
-        {
-            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
-            if (k != workItems_.End())
-            {
-                queue_.Erase(j);
-                ReturnToPool(*k);
-                workItems_.Erase(k);
-                ++removed;
-            }
-        }
+        if (RemoveWorkItem(*i))
+            ++removed;
     }
 
     return removed;
@@ -213,7 +277,7 @@ void WorkQueue::Pause()
     {
         pausing_ = true;
         
-        queueMutex_.Acquire();
+        pauseMutex_.Acquire();
         paused_ = true;
         
         pausing_ = false;
@@ -224,7 +288,7 @@ void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
+        pauseMutex_.Release();
         paused_ = false;
     }
 }
@@ -236,44 +300,42 @@ void WorkQueue::Complete(unsigned priority)
     {
         Resume();
         
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.Empty())
+        WorkQueueThreadStats& stats = queues_[0]->stats_;
+        HiresTimer waitTimer;
+        bool waiting = false;
+        
+        // Take work items also in the main thread until all high-priority items have completed. Items waiting for
+        // dependencies become available as worker threads complete them
+        while (!IsCompleted(priority))
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+            WorkItem* item = TakeItem(0, priority);
+            if (item)
             {
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
+                if (waiting)
+                {
+                    stats.idleTime_ += waitTimer.GetUSec(false);
+                    waiting = false;
+                }
+                ProcessItem(item, 0);
             }
-            else
+            else if (!waiting)
             {
-                queueMutex_.Release();
-                break;
+                waitTimer.Reset();
+                waiting = true;
             }
         }
-        
-        // Wait for threaded work to complete
-        while (!IsCompleted(priority))
-        {
-        }
+        if (waiting)
+            stats.idleTime_ += waitTimer.GetUSec(false);
         
         // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
+        if (!HasQueuedItems())
             Pause();
     }
     else
     {
         // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-        {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
-        }
+        while (WorkItem* item = queues_[0]->Pop(priority))
+            ProcessItem(item, 0);
     }
     
     PurgeCompleted(priority);
@@ -281,7 +343,7 @@ void WorkQueue::Complete(unsigned priority)
 
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
-    for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
+    for (PODVector<WorkItem*>::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
     {
         if ((*i)->priority_ >= priority && !(*i)->completed_)
             return false;
@@ -290,9 +352,22 @@ bool WorkQueue::IsCompleted(unsigned priority) const
     return true;
 }
 
+WorkQueueThreadStats WorkQueue::GetThreadStats(unsigned threadIndex) const
+{
+    return threadIndex < queues_.Size() ? queues_[threadIndex]->stats_ : WorkQueueThreadStats();
+}
+
+void WorkQueue::ResetThreadStats()
+{
+    for (unsigned i = 0; i < queues_.Size(); ++i)
+        queues_[i]->stats_ = WorkQueueThreadStats();
+}
+
 void WorkQueue::ProcessItems(unsigned threadIndex)
 {
     bool wasActive = false;
+    WorkQueueThreadStats& stats = queues_[threadIndex]->stats_;
+    HiresTimer idleTimer;
     
     for (;;)
     {
@@ -303,52 +378,265 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
             Time::Sleep(0);
         else
         {
-            queueMutex_.Acquire();
-            if (!queue_.Empty())
+            WorkItem* item = TakeItem(threadIndex, 0);
+            if (item)
             {
+                if (!wasActive)
+                    stats.idleTime_ += idleTimer.GetUSec(false);
                 wasActive = true;
                 
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ProcessItem(item, threadIndex);
             }
             else
             {
+                if (wasActive)
+                    idleTimer.Reset();
                 wasActive = false;
                 
-                queueMutex_.Release();
+                // Block here while the main thread holds the pause mutex
+                pauseMutex_.Acquire();
+                pauseMutex_.Release();
                 Time::Sleep(0);
             }
         }
     }
 }
 
+WorkItem* WorkQueue::TakeItem(unsigned threadIndex, unsigned priority)
+{
+    WorkItem* item = queues_[threadIndex]->Pop(priority);
+    if (item)
+        return item;
+    
+    // Own queue is empty: steal, starting from the next thread's queue so that thieves spread over the victims
+    unsigned numQueues = queues_.Size();
+    for (unsigned i = 1; i < numQueues; ++i)
+    {
+        item = queues_[(threadIndex + i) % numQueues]->Pop(priority);
+        if (item)
+        {
+            ++queues_[threadIndex]->stats_.itemsStolen_;
+            return item;
+        }
+    }
+    
+    return 0;
+}
+
+bool WorkQueue::HasQueuedItems() const
+{
+    for (unsigned i = 0; i < queues_.Size(); ++i)
+    {
+        if (!queues_[i]->Empty())
+            return true;
+    }
+    
+    return false;
+}
+
+void WorkQueue::ProcessItem(WorkItem* item, unsigned threadIndex)
+{
+    // Work items without a work function only serve as dependencies
+    if (item->workFunction_)
+    {
+        #ifdef URHO3D_PROFILING
+        Profiler* profiler = profiler_;
+        if (profiler)
+            profiler->BeginBlock("WorkItem");
+        item->workFunction_(item, threadIndex);
+        if (profiler)
+            profiler->EndBlock();
+        #else
+        item->workFunction_(item, threadIndex);
+        #endif
+    }
+    
+    // After the executed flag is set no more dependents can be registered, so they can be accessed without locking
+    {
+        MutexLock lock(GetCompletionMutex(item));
+        item->executed_ = true;
+    }
+    
+    // Queue the ready dependents to this thread's own queue, as they are likely to use the same data
+    if (item->dependents_.Size())
+    {
+        for (PODVector<WorkItem*>::ConstIterator i = item->dependents_.Begin(); i != item->dependents_.End(); ++i)
+        {
+            if (ReleaseDependency(*i))
+                queues_[threadIndex]->Push(*i);
+        }
+        item->dependents_.Clear();
+    }
+    
+    ++queues_[threadIndex]->stats_.itemsProcessed_;
+    
+    // The item may be returned to the pool by the main thread right after this, so do not touch it anymore
+    item->completed_ = true;
+}
+
+void WorkQueue::AddItem(WorkItem* item, WorkItem* const* dependencies, unsigned numDependencies)
+{
+    // Check for duplicate items.
+    assert(!workItems_.Contains(item));
+    
+    // Push to the main thread list to keep item alive
+    // Clear completed flag in case item is reused
+    workItems_.Push(item);
+    item->completed_ = false;
+    item->executed_ = false;
+    
+    if (!numDependencies)
+    {
+        QueueItem(item);
+        return;
+    }
+    
+    // Count one extra dependency while registering, so that the item can not become ready before all are registered
+    item->pendingDependencies_ = numDependencies + 1;
+    
+    for (unsigned i = 0; i < numDependencies; ++i)
+    {
+        WorkItem* dependency = dependencies[i];
+        bool executed = true;
+        
+        if (dependency)
+        {
+            MutexLock lock(GetCompletionMutex(dependency));
+            executed = dependency->executed_;
+            if (!executed)
+                dependency->dependents_.Push(item);
+        }
+        
+        if (executed)
+            ReleaseDependency(item);
+    }
+    
+    if (ReleaseDependency(item))
+        QueueItem(item);
+}
+
+WorkItem* WorkQueue::TakeFreeItem()
+{
+    // Take the most recently used item, as it is the most likely to be in the CPU cache
+    if (poolItems_.Size())
+    {
+        WorkItem* item = poolItems_.Back();
+        poolItems_.Pop();
+        return item;
+    }
+    
+    // No usable items found, create a new one set it as pooled and return it.
+    WorkItem* item = new WorkItem();
+    item->pooled_ = true;
+    item->AddRef();
+    return item;
+}
+
+void WorkQueue::QueueItem(WorkItem* item)
+{
+    if (threads_.Size())
+    {
+        // Distribute items to the worker threads' queues in round-robin order. Idle threads will steal the rest
+        queues_[nextQueue_ + 1]->Push(item);
+        if (++nextQueue_ >= threads_.Size())
+            nextQueue_ = 0;
+        
+        Resume();
+    }
+    else
+        queues_[0]->Push(item);
+}
+
+bool WorkQueue::ReleaseDependency(WorkItem* item)
+{
+    MutexLock lock(GetCompletionMutex(item));
+    return --item->pendingDependencies_ == 0;
+}
+
+void WorkQueue::ReleaseDependents(WorkItem* item)
+{
+    // Mark as executed so that no more dependents are registered, then the dependents can be accessed without locking
+    {
+        MutexLock lock(GetCompletionMutex(item));
+        item->executed_ = true;
+    }
+    
+    for (PODVector<WorkItem*>::ConstIterator i = item->dependents_.Begin(); i != item->dependents_.End(); ++i)
+    {
+        if (ReleaseDependency(*i))
+            QueueItem(*i);
+    }
+    item->dependents_.Clear();
+}
+
+SharedPtr<WorkItem> WorkQueue::AddRangeWorkItems(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count,
+    unsigned elementSize, void* aux, unsigned grainSize, unsigned priority, WorkItem* dependency)
+{
+    // By default split into one item per thread, including the main thread
+    if (!grainSize)
+        grainSize = (unsigned)Max((int)((count + threads_.Size()) / (threads_.Size() + 1)), 1);
+    unsigned numItems = (count + grainSize - 1) / grainSize;
+    
+    // The handle item has no work function and waits for all the range items. As the range items are not yet queued,
+    // registering the dependencies needs no locking
+    WorkItem* handle = TakeFreeItem();
+    handle->priority_ = priority;
+    handle->workFunction_ = 0;
+    handle->pendingDependencies_ = numItems;
+    workItems_.Push(handle);
+    handle->completed_ = false;
+    handle->executed_ = false;
+    if (!numItems)
+        QueueItem(handle);
+    
+    // The range items are used directly from the pool without SharedPtr's, as the caller never sees them
+    unsigned char* begin = reinterpret_cast<unsigned char*>(start);
+    for (unsigned i = 0; i < count; i += grainSize)
+    {
+        WorkItem* item = TakeFreeItem();
+        item->priority_ = priority;
+        item->workFunction_ = workFunction;
+        item->aux_ = aux;
+        item->start_ = begin + i * elementSize;
+        item->end_ = begin + Min((int)(i + grainSize), (int)count) * elementSize;
+        item->dependents_.Push(handle);
+        AddItem(item, &dependency, dependency ? 1 : 0);
+    }
+    
+    return SharedPtr<WorkItem>(handle);
+}
+
 void WorkQueue::PurgeCompleted(unsigned priority)
 {
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
     // as those may be user submitted and lead to eg. scene manipulation that could happen in the middle of the
-    // render update, which is not allowed
-    for (List<SharedPtr<WorkItem> >::Iterator i = workItems_.Begin(); i != workItems_.End();)
+    // render update, which is not allowed. Compact the work item collection first, as event handlers may add new items
+    unsigned keep = 0;
+    for (unsigned i = 0; i < workItems_.Size(); ++i)
+    {
+        WorkItem* item = workItems_[i];
+        if (item->completed_ && item->priority_ >= priority)
+            completedItems_.Push(item);
+        else
+            workItems_[keep++] = item;
+    }
+    workItems_.Resize(keep);
+    
+    for (unsigned i = 0; i < completedItems_.Size(); ++i)
     {
-        if ((*i)->completed_ && (*i)->priority_ >= priority)
+        WorkItem* item = completedItems_[i];
+        if (item->sendEvent_)
         {
-            if ((*i)->sendEvent_)
-            {
-                using namespace WorkItemCompleted;
-                
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_ITEM] = i->Get();
-                SendEvent(E_WORKITEMCOMPLETED, eventData);
-            }
-
-            ReturnToPool(*i);
-            i = workItems_.Erase(i);
+            using namespace WorkItemCompleted;
+            
+            VariantMap& eventData = GetEventDataMap();
+            eventData[P_ITEM] = item;
+            SendEvent(E_WORKITEMCOMPLETED, eventData);
         }
-        else
-            ++i;
+        
+        ReturnToPool(item);
     }
+    completedItems_.Clear();
 }
 
 void WorkQueue::PurgePool()
@@ -356,14 +644,19 @@ void WorkQueue::PurgePool()
     unsigned currentSize = poolItems_.Size();
     int difference = lastSize_ - currentSize;
 
-    // Difference tolerance, should be fairly significant to reduce the pool size.
-    for (unsigned i = 0; poolItems_.Size() > 0 && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.PopFront();
+    // Difference tolerance, should be fairly significant to reduce the pool size. Delete the least recently used items
+    if (difference > tolerance_)
+    {
+        unsigned count = Min(difference, (int)currentSize);
+        for (unsigned i = 0; i < count; ++i)
+            poolItems_[i]->ReleaseRef();
+        poolItems_.Erase(0, count);
+    }
 
     lastSize_ = currentSize;
 }
 
-void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
+void WorkQueue::ReturnToPool(WorkItem* item)
 {
     // Check if this was a pooled item and set it to usable
     if (item->pooled_)
@@ -379,26 +672,31 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
         item->priority_ = M_MAX_UNSIGNED;
         item->sendEvent_ = false;
         item->completed_ = false;
+        item->dependents_.Clear();
+        item->pendingDependencies_ = 0;
 
+        // The pool takes over the work item collection's reference
         poolItems_.Push(item);
     }
+    else
+        item->ReleaseRef();
 }
 
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    if (threads_.Empty() && !queues_[0]->Empty())
     {
         PROFILE(CompleteWorkNonthreaded);
         
         HiresTimer timer;
         
-        while (!queue_.Empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = queues_[0]->Pop(0);
+            if (!item)
+                break;
+            ProcessItem(item, 0);
         }
     }
     
@@ -22,7 +22,6 @@
 
 #pragma once
 
-#include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
@@ -35,7 +34,12 @@ EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
     PARAM(P_ITEM, Item);                        // WorkItem ptr
 }
 
+class Profiler;
 class WorkerThread;
+class WorkItemQueue;
+
+/// Number of mutexes for work item completion and dependency tracking.
+static const unsigned NUM_COMPLETION_MUTEXES = 16;
 
 /// Work queue item.
 struct WorkItem : public RefCounted
@@ -48,6 +52,8 @@ public:
         priority_(0),
         sendEvent_(false),
         completed_(false),
+        pendingDependencies_(0),
+        executed_(false),
         pooled_(false)
     {
     }
@@ -68,9 +74,34 @@ public:
     volatile bool completed_;
 
 private:
+    /// Work items waiting for this item to complete.
+    PODVector<WorkItem*> dependents_;
+    /// Number of uncompleted work items to wait for before this item can be executed.
+    unsigned pendingDependencies_;
+    /// Work function executed flag. Dependencies on an executed item are satisfied immediately.
+    bool executed_;
     bool pooled_;
 };
 
+/// Work queue statistics for one thread.
+struct WorkQueueThreadStats
+{
+    /// Construct.
+    WorkQueueThreadStats() :
+        itemsProcessed_(0),
+        itemsStolen_(0),
+        idleTime_(0)
+    {
+    }
+    
+    /// Number of work items executed.
+    unsigned itemsProcessed_;
+    /// Number of work items taken from other threads' queues.
+    unsigned itemsStolen_;
+    /// Time spent without work, in microseconds. For the main thread this is the time spent waiting for worker threads in Complete().
+    long long idleTime_;
+};
+
 /// Work queue subsystem for multithreading.
 class URHO3D_API WorkQueue : public Object
 {
@@ -89,9 +120,19 @@ public:
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
     /// Add a work item and resume worker threads.
-    void AddWorkItem(SharedPtr<WorkItem> item);
-    /// Remove a work item before it has started executing. Return true if successfully removed.
-    bool RemoveWorkItem(SharedPtr<WorkItem> item);
+    void AddWorkItem(const SharedPtr<WorkItem>& item);
+    /// Add a work item to be executed after the dependency work items have completed. The dependencies must have been added and not yet purged, and should not have lower priority than the item.
+    void AddWorkItem(const SharedPtr<WorkItem>& item, const PODVector<WorkItem*>& dependencies);
+    /// Add a work item to be executed after the dependency work item has completed.
+    void AddWorkItem(const SharedPtr<WorkItem>& item, WorkItem* dependency);
+    /// Split a range of elements into work items of grainSize elements, or one item per thread if zero, and add them. The work function receives its subrange in start and end. Optionally wait for a dependency work item first. Return a work item which completes after all the items, to be used as a dependency for following work.
+    template <class T> SharedPtr<WorkItem> ParallelFor(void (*workFunction)(const WorkItem*, unsigned), RandomAccessIterator<T> start,
+        RandomAccessIterator<T> end, void* aux = 0, unsigned grainSize = 0, unsigned priority = M_MAX_UNSIGNED, WorkItem* dependency = 0)
+    {
+        return AddRangeWorkItems(workFunction, start.ptr_, (unsigned)(end - start), sizeof(T), aux, grainSize, priority, dependency);
+    }
+    /// Remove a work item before it has started executing. Return true if successfully removed. The work items depending on it no longer wait for it.
+    bool RemoveWorkItem(const SharedPtr<WorkItem>& item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items);
     /// Pause worker threads.
@@ -113,34 +154,67 @@ public:
     int GetTolerance() const { return tolerance_; }
     /// Return how many milliseconds maximum to spend on non-threaded low-priority work.
     int GetNonThreadedWorkMs() const { return maxNonThreadedWorkMs_; }
+    /// Return statistics for a thread. Index 0 is the main thread. The counters are updated without synchronization and are approximate while work is executing.
+    WorkQueueThreadStats GetThreadStats(unsigned threadIndex) const;
+    /// Reset statistics of all threads.
+    void ResetThreadStats();
     
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Take the highest priority work item with at least the specified priority, first from the thread's own queue and then by stealing from the other queues. Return null if none available.
+    WorkItem* TakeItem(unsigned threadIndex, unsigned priority);
+    /// Return whether any queue has work items waiting for execution.
+    bool HasQueuedItems() const;
+    /// Execute a work item, mark it completed and queue the dependent work items which become ready.
+    void ProcessItem(WorkItem* item, unsigned threadIndex);
+    /// Add a work item to the work item collection, taking over one reference, and queue it once the dependencies have completed.
+    void AddItem(WorkItem* item, WorkItem* const* dependencies, unsigned numDependencies);
+    /// Queue a work item for execution, distributing items to the worker threads in round-robin order.
+    void QueueItem(WorkItem* item);
+    /// Take a work item from the pool or allocate a new one. The caller receives the pool's reference.
+    WorkItem* TakeFreeItem();
+    /// Decrement the pending dependency count of a work item. Return true if it became ready for execution.
+    bool ReleaseDependency(WorkItem* item);
+    /// Release the dependents of a work item which was removed before execution, and queue those which become ready.
+    void ReleaseDependents(WorkItem* item);
+    /// Return the mutex guarding a work item's completion and dependency state.
+    Mutex& GetCompletionMutex(WorkItem* item) { return completionMutexes_[((size_t)item >> 6) & (NUM_COMPLETION_MUTEXES - 1)]; }
+    /// Add work items for a range of elements, and a work item which completes after them.
+    SharedPtr<WorkItem> AddRangeWorkItems(void (*workFunction)(const WorkItem*, unsigned), void* start, unsigned count,
+        unsigned elementSize, void* aux, unsigned grainSize, unsigned priority, WorkItem* dependency);
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
     void PurgePool();
-    /// Return a work item to the pool.
-    void ReturnToPool(SharedPtr<WorkItem>& item);
+    /// Return a work item to the pool, or release the reference to it if it is not pooled.
+    void ReturnToPool(WorkItem* item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
-    /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    List<SharedPtr<WorkItem> > poolItems_;
-    /// Work item collection. Accessed only by the main thread.
-    List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
-    List<WorkItem*> queue_;
-    /// Worker queue mutex.
-    Mutex queueMutex_;
+    /// Work item pool for reuse to cut down on allocation, ordered from least to most recently used. Holds one reference to each item. Accessed only by the main thread, so needs no locking.
+    PODVector<WorkItem*> poolItems_;
+    /// Work item collection. Holds one reference to each item. Accessed only by the main thread.
+    PODVector<WorkItem*> workItems_;
+    /// Completed work items being purged.
+    PODVector<WorkItem*> completedItems_;
+    /// Prioritized work item queues, one per thread with index 0 for the main thread. Worker threads steal from the other queues when their own is empty. Pointers are guaranteed to be valid (point to workItems.)
+    Vector<SharedPtr<WorkItemQueue> > queues_;
+    /// Pause mutex. Idle worker threads block on it while paused.
+    Mutex pauseMutex_;
+    /// Mutexes guarding work item completion and dependencies, selected by work item address.
+    Mutex completionMutexes_[NUM_COMPLETION_MUTEXES];
+    /// Worker queue to receive the next added work item.
+    unsigned nextQueue_;
+    /// Profiler for timing the work items.
+    WeakPtr<Profiler> profiler_;
     /// Shutting down flag.
     volatile bool shutDown_;
-    /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
+    /// Pausing flag. Indicates the worker threads should not contend for the pause mutex.
     volatile bool pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
+    /// Paused flag. Indicates the pause mutex being locked to prevent worker threads using up CPU time.
     bool paused_;
     /// Tolerance for the shared pool before it begins to deallocate.
     int tolerance_;
@@ -26,6 +26,7 @@
 #include "../Core/CoreEvents.h"
 #include "../Engine/DebugHud.h"
 #include "../Engine/Engine.h"
+#include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../Graphics/Graphics.h"
 #include "../Input/Input.h"
@@ -198,6 +199,16 @@ bool Engine::Initialize(const VariantMap& parameters)
         LOGINFOF("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : "");
     }
 
+    // Start recording a profiler trace if requested, it is written on exit
+    Profiler* profiler = GetSubsystem<Profiler>();
+    if (profiler && HasParameter(parameters, "ProfilerTrace"))
+    {
+        profilerTraceName_ = GetParameter(parameters, "ProfilerTrace").GetString();
+        profiler->StartTrace();
+    }
+    if (profiler && GetParameter(parameters, "ProfilerAllocations", false).GetBool())
+        profiler->SetAllocationTracking(true);
+
     // Add resource paths
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     FileSystem* fileSystem = GetSubsystem<FileSystem>();
@@ -379,8 +390,8 @@ bool Engine::Initialize(const VariantMap& parameters)
     #ifdef _DEBUG
     if (!resourcePaths.Empty())
     {
-        const HashMap<StringHash, SharedPtr<ObjectFactory> >& factories = context_->GetObjectFactories();
-        for (HashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories.Begin(); i != factories.End(); ++i)
+        const FlatHashMap<StringHash, SharedPtr<ObjectFactory> >& factories = context_->GetObjectFactories();
+        for (FlatHashMap<StringHash, SharedPtr<ObjectFactory> >::ConstIterator i = factories.Begin(); i != factories.End(); ++i)
             SharedPtr<Object> object = i->second_->CreateObject();
     }
     #endif
@@ -529,7 +540,7 @@ void Engine::DumpResources(bool dumpFileName)
 {
     #ifdef URHO3D_LOGGING
     ResourceCache* cache = GetSubsystem<ResourceCache>();
-    const HashMap<StringHash, ResourceGroup>& resourceGroups = cache->GetAllResources();
+    const FlatHashMap<StringHash, ResourceGroup>& resourceGroups = cache->GetAllResources();
     LOGRAW("\n");
 
     if (dumpFileName)
@@ -537,13 +548,13 @@ void Engine::DumpResources(bool dumpFileName)
         LOGRAW("Used resources:\n");
     }
 
-    for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin();
+    for (FlatHashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin();
         i != resourceGroups.End(); ++i)
     {
-        const HashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
+        const FlatHashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
         if (dumpFileName)
         {
-            for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin();
+            for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin();
                 j != resources.End(); ++j)
             {
                 LOGRAW(j->second_->GetName() + "\n");
@@ -615,20 +626,20 @@ void Engine::Update()
     PROFILE(Update);
 
     // Logic update event
-    using namespace Update;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    UpdateEventData updateData(timeStep_);
+    SendTypedEvent(updateData);
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    PostUpdateEventData postUpdateData(timeStep_);
+    SendTypedEvent(postUpdateData);
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    RenderUpdateEventData renderUpdateData(timeStep_);
+    SendTypedEvent(renderUpdateData);
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    PostRenderUpdateEventData postRenderUpdateData(timeStep_);
+    SendTypedEvent(postRenderUpdateData);
 }
 
 void Engine::Render()
@@ -759,6 +770,13 @@ VariantMap Engine::ParseParameters(const Vector<String>& arguments)
                 ret["LowQualityShadows"] = true;
             else if (argument == "nothreads")
                 ret["WorkerThreads"] = false;
+            else if (argument == "allocstats")
+                ret["ProfilerAllocations"] = true;
+            else if (argument == "trace" && !value.Empty())
+            {
+                ret["ProfilerTrace"] = value;
+                ++i;
+            }
             else if (argument == "v")
                 ret["VSync"] = true;
             else if (argument == "t")
@@ -895,6 +913,19 @@ void Engine::DoExit()
     if (graphics)
         graphics->Close();
 
+    Profiler* profiler = GetSubsystem<Profiler>();
+    if (profiler && !profilerTraceName_.Empty())
+    {
+        // Save also a trace which was already stopped due to reaching the event limit
+        profiler->StopTrace();
+        if (profiler->GetNumTraceEvents())
+        {
+            File traceFile(context_, profilerTraceName_, FILE_WRITE);
+            if (traceFile.IsOpen() && profiler->SaveTrace(traceFile))
+                LOGINFOF("Saved %u profiler trace events to %s", profiler->GetNumTraceEvents(), profilerTraceName_.CString());
+        }
+    }
+
     exiting_ = true;
     #if defined(EMSCRIPTEN) && defined(URHO3D_TESTING)
     emscripten_force_exit(EXIT_SUCCESS);    // Some how this is required to signal emrun to stop
@@ -144,6 +144,8 @@ private:
     bool headless_;
     /// Audio paused flag.
     bool audioPaused_;
+    /// Profiler trace output file name.
+    String profilerTraceName_;
 };
 
 }
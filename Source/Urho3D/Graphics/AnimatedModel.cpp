@@ -70,7 +70,8 @@ AnimatedModel::AnimatedModel(Context* context) :
     boneBoundingBoxDirty_(true),
     isMaster_(true),
     loading_(false),
-    assignBonesPending_(false)
+    assignBonesPending_(false),
+    flatPose_(false)
 {
 }
 
@@ -78,9 +79,17 @@ AnimatedModel::~AnimatedModel()
 {
     // When being destroyed, remove the bone hierarchy if appropriate (last AnimatedModel in the node)
     Bone* rootBone = skeleton_.GetRootBone();
-    if (rootBone && rootBone->node_)
+    Node* boneNode = rootBone ? rootBone->node_.Get() : 0;
+    // In flat pose mode only the bones with attachments have nodes, which are direct children of the model's node
+    if (flatPose_)
+    {
+        const Vector<Bone>& bones = skeleton_.GetBones();
+        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End() && !boneNode; ++i)
+            boneNode = i->node_;
+    }
+    if (boneNode)
     {
-        Node* parent = rootBone->node_->GetParent();
+        Node* parent = boneNode->GetParent();
         if (parent && !parent->GetComponent<AnimatedModel>())
             RemoveRootBone();
     }
@@ -105,6 +114,7 @@ void AnimatedModel::RegisterObject(Context* context)
     MIXED_ACCESSOR_ATTRIBUTE("Bone Animation Enabled", GetBonesEnabledAttr, SetBonesEnabledAttr, VariantVector, Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
     MIXED_ACCESSOR_ATTRIBUTE("Animation States", GetAnimationStatesAttr, SetAnimationStatesAttr, VariantVector, Variant::emptyVariantVector, AM_FILE);
     ACCESSOR_ATTRIBUTE("Morphs", GetMorphsAttr, SetMorphsAttr, PODVector<unsigned char>, Variant::emptyBuffer, AM_DEFAULT | AM_NOEDIT);
+    ACCESSOR_ATTRIBUTE("Flat Pose", GetFlatPose, SetFlatPose, bool, false, AM_DEFAULT);
 }
 
 bool AnimatedModel::Load(Deserializer& source, bool setInstanceDefault)
@@ -125,6 +135,15 @@ bool AnimatedModel::LoadXML(const XMLElement& source, bool setInstanceDefault)
     return success;
 }
 
+bool AnimatedModel::LoadValues(const Vector<Variant>& values)
+{
+    loading_ = true;
+    bool success = Component::LoadValues(values);
+    loading_ = false;
+
+    return success;
+}
+
 void AnimatedModel::ApplyAttributes()
 {
     if (assignBonesPending_)
@@ -146,12 +165,18 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         return;
 
     const Vector<Bone>& bones = skeleton_.GetBones();
+    bool flatPose = flatPose_ && boneTransforms_.Size() == bones.Size();
     Sphere boneSphere;
 
     for (unsigned i = 0; i < bones.Size(); ++i)
     {
         const Bone& bone = bones[i];
-        if (!bone.node_)
+        Matrix3x4 transform;
+        if (flatPose)
+            transform = node_->GetWorldTransform() * boneTransforms_[i];
+        else if (bone.node_)
+            transform = bone.node_->GetWorldTransform();
+        else
             continue;
 
         float distance;
@@ -161,7 +186,6 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -177,7 +201,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = transform.Translation();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -283,7 +307,32 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
-        debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+
+        const Vector<Bone>& bones = skeleton_.GetBones();
+        if (flatPose_ && boneTransforms_.Size() == bones.Size())
+        {
+            // Without bone nodes, draw the skeleton from the flat pose
+            const Matrix3x4& worldTransform = node_->GetWorldTransform();
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                // Skip if bone contains no skinned geometry
+                if (bones[i].radius_ < M_EPSILON && bones[i].boundingBox_.Size().LengthSquared() < M_EPSILON)
+                    continue;
+
+                Vector3 start = worldTransform * boneTransforms_[i].Translation();
+                Vector3 end = start;
+
+                // If bone has a parent defined, and it also skins geometry, draw a line to it
+                unsigned j = bones[i].parentIndex_;
+                if (j != i && j < bones.Size() && (bones[j].radius_ >= M_EPSILON ||
+                    bones[j].boundingBox_.Size().LengthSquared() >= M_EPSILON))
+                    end = worldTransform * boneTransforms_[j].Translation();
+
+                debug->AddLine(start, end, Color(0.75f, 0.75f, 0.75f), depthTest);
+            }
+        }
+        else
+            debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
     }
 }
 
@@ -576,6 +625,46 @@ void AnimatedModel::ResetMorphWeights()
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetFlatPose(bool enable)
+{
+    if (enable == flatPose_)
+        return;
+
+    // When loading, the bone nodes are assigned afterward so only the pose arrays need to be set up
+    if (loading_ || !model_ || !isMaster_)
+    {
+        flatPose_ = enable;
+        InitializeFlatPose();
+        MarkNetworkUpdate();
+        return;
+    }
+
+    // Remove the bone nodes of the current mode, then redefine the skeleton to create them for the new mode
+    RemoveRootBone();
+    flatPose_ = enable;
+    skeleton_.ClearBones();
+    SetSkeleton(model_->GetSkeleton(), true);
+    MarkAnimationDirty();
+    MarkNetworkUpdate();
+}
+
+Node* AnimatedModel::CreateBoneNode(const String& boneName)
+{
+    Bone* bone = skeleton_.GetBone(boneName);
+    if (!bone)
+        return 0;
+    // Without flat pose the bone nodes always exist already
+    if (bone->node_ || !flatPose_ || !isMaster_ || !node_ || boneTransforms_.Size() != skeleton_.GetNumBones())
+        return bone->node_;
+
+    // Create the node as local, as it is never to be directly synchronized over the network
+    Node* boneNode = node_->CreateChild(boneName, LOCAL);
+    bone->node_ = boneNode;
+    CalculateBoneTransforms();
+
+    return boneNode;
+}
+
 float AnimatedModel::GetMorphWeight(unsigned index) const
 {
     return index < morphs_.Size() ? morphs_[index].weight_ : 0.0f;
@@ -659,8 +748,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
 
             for (unsigned i = 0; i < destBones.Size(); ++i)
             {
-                if (destBones[i].node_ && destBones[i].name_ == srcBones[i].name_ && destBones[i].parentIndex_ ==
-                    srcBones[i].parentIndex_)
+                if ((destBones[i].node_ || flatPose_) && destBones[i].name_ == srcBones[i].name_ &&
+                    destBones[i].parentIndex_ == srcBones[i].parentIndex_)
                 {
                     // If compatible, just copy the values and retain the old node and animated status
                     Node* boneNode = destBones[i].node_;
@@ -676,7 +765,10 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
                 }
             }
             if (compatible)
+            {
+                InitializeFlatPose();
                 return;
+            }
         }
 
         RemoveAllAnimationStates();
@@ -698,8 +790,10 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
                 i->collisionMask_ &= ~BONECOLLISION_SPHERE;
         }
 
-        // Create scene nodes for the bones
-        if (createBones)
+        InitializeFlatPose();
+
+        // Create scene nodes for the bones. In flat pose mode they are created on demand instead
+        if (createBones && !flatPose_)
         {
             for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
             {
@@ -915,11 +1009,17 @@ void AnimatedModel::AssignBoneNodes()
         if (boneNode)
         {
             boneFound = true;
-            boneNode->AddListener(this);
+            // In flat pose mode the bone nodes only follow the pose, so they do not need to be listened to
+            if (!flatPose_)
+                boneNode->AddListener(this);
         }
         i->node_ = boneNode;
     }
 
+    // Bring the bone nodes found up to date with the flat pose
+    if (boneFound && flatPose_ && isMaster_)
+        CalculateBoneTransforms();
+
     // If no bones found, this may be a prefab where the bone information was left out.
     // In that case reassign the skeleton now if possible
     if (!boneFound && model_)
@@ -935,6 +1035,18 @@ void AnimatedModel::AssignBoneNodes()
 
 void AnimatedModel::RemoveRootBone()
 {
+    // In flat pose mode the bone nodes are not in a hierarchy, so remove each of them
+    if (flatPose_)
+    {
+        Vector<Bone>& bones = skeleton_.GetModifiableBones();
+        for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
+        {
+            if (i->node_)
+                i->node_->Remove();
+        }
+        return;
+    }
+
     Bone* rootBone = skeleton_.GetRootBone();
     if (rootBone && rootBone->node_)
         rootBone->node_->Remove();
@@ -1141,12 +1253,21 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
     // (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.ResetSilent();
-        for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
-            (*i)->Apply();
+        if (flatPose_)
+        {
+            UpdateFlatPose();
+            // The model's own node did not move, so only the skinning needs updating
+            skinningDirty_ = true;
+        }
+        else
+        {
+            skeleton_.ResetSilent();
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
 
-        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
-        node_->MarkDirty();
+            // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
+            node_->MarkDirty();
+        }
 
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
@@ -1155,27 +1276,144 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
     animationDirty_ = false;
 }
 
+void AnimatedModel::InitializeFlatPose()
+{
+    if (!flatPose_ || !isMaster_)
+    {
+        bonePositions_.Clear();
+        boneRotations_.Clear();
+        boneScales_.Clear();
+        boneTransforms_.Clear();
+        boneOrder_.Clear();
+        return;
+    }
+
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = bones.Size();
+    bonePositions_.Resize(numBones);
+    boneRotations_.Resize(numBones);
+    boneScales_.Resize(numBones);
+    boneTransforms_.Resize(numBones);
+
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        bonePositions_[i] = bones[i].initialPosition_;
+        boneRotations_[i] = bones[i].initialRotation_;
+        boneScales_[i] = bones[i].initialScale_;
+    }
+
+    // Order the bones so that each parent's transform is calculated before its children
+    boneOrder_.Clear();
+    PODVector<bool> ordered(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+        ordered[i] = false;
+
+    while (boneOrder_.Size() < numBones)
+    {
+        unsigned oldSize = boneOrder_.Size();
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            unsigned parentIndex = bones[i].parentIndex_;
+            if (!ordered[i] && (parentIndex == i || parentIndex >= numBones || ordered[parentIndex]))
+            {
+                boneOrder_.Push(i);
+                ordered[i] = true;
+            }
+        }
+
+        // If no progress, the skeleton has a parent cycle. Calculate the remaining bones in index order
+        if (boneOrder_.Size() == oldSize)
+        {
+            for (unsigned i = 0; i < numBones; ++i)
+            {
+                if (!ordered[i])
+                    boneOrder_.Push(i);
+            }
+        }
+    }
+
+    CalculateBoneTransforms();
+}
+
+void AnimatedModel::UpdateFlatPose()
+{
+    // Reset the animated bones, then let the animation states blend into the pose arrays
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        if (bones[i].animated_)
+        {
+            bonePositions_[i] = bones[i].initialPosition_;
+            boneRotations_[i] = bones[i].initialRotation_;
+            boneScales_[i] = bones[i].initialScale_;
+        }
+    }
+
+    for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+        (*i)->Apply();
+
+    CalculateBoneTransforms();
+}
+
+void AnimatedModel::CalculateBoneTransforms()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    if (boneTransforms_.Size() != bones.Size())
+        return;
+
+    for (PODVector<unsigned>::ConstIterator i = boneOrder_.Begin(); i != boneOrder_.End(); ++i)
+    {
+        unsigned index = *i;
+        unsigned parentIndex = bones[index].parentIndex_;
+        Matrix3x4 localTransform(bonePositions_[index], boneRotations_[index], boneScales_[index]);
+        if (parentIndex != index && parentIndex < bones.Size())
+            boneTransforms_[index] = boneTransforms_[parentIndex] * localTransform;
+        else
+            boneTransforms_[index] = localTransform;
+    }
+
+    // Copy the transforms to the bone nodes that were created for attachments
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        if (boneNode)
+        {
+            Vector3 position;
+            Quaternion rotation;
+            Vector3 scale;
+            boneTransforms_[i].Decompose(position, rotation, scale);
+            boneNode->SetTransform(position, rotation, scale);
+        }
+    }
+}
+
 void AnimatedModel::UpdateBoneBoundingBox()
 {
     if (skeleton_.GetNumBones())
     {
-        // The bone bounding box is in local space, so need the node's inverse transform
+        // The bone bounding box is in local space, so need the node's inverse transform. The flat pose is already in local space
         boneBoundingBox_.defined_ = false;
-        Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
-
         const Vector<Bone>& bones = skeleton_.GetBones();
-        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+        bool flatPose = flatPose_ && boneTransforms_.Size() == bones.Size();
+        Matrix3x4 inverseNodeTransform = flatPose ? Matrix3x4::IDENTITY : node_->GetWorldTransform().Inverse();
+
+        for (unsigned i = 0; i < bones.Size(); ++i)
         {
-            Node* boneNode = i->node_;
-            if (!boneNode)
+            const Bone& bone = bones[i];
+            Matrix3x4 transform;
+            if (flatPose)
+                transform = boneTransforms_[i];
+            else if (bone.node_)
+                transform = inverseNodeTransform * bone.node_->GetWorldTransform();
+            else
                 continue;
 
             // Use hitbox if available. If not, use only half of the sphere radius
             /// \todo The sphere radius should be multiplied with bone scale
-            if (i->collisionMask_ & BONECOLLISION_BOX)
-                boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
-            else if (i->collisionMask_ & BONECOLLISION_SPHERE)
-                boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            if (bone.collisionMask_ & BONECOLLISION_BOX)
+                boneBoundingBox_.Merge(bone.boundingBox_.Transformed(transform));
+            else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                boneBoundingBox_.Merge(Sphere(transform.Translation(), bone.radius_ * 0.5f));
         }
     }
 
@@ -1189,6 +1427,8 @@ void AnimatedModel::UpdateSkinning()
     const Vector<Bone>& bones = skeleton_.GetBones();
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    // In flat pose mode the bone transforms are relative to the model
+    bool flatPose = flatPose_ && boneTransforms_.Size() == bones.Size();
 
     // Skinning with global matrices only
     if (!geometrySkinMatrices_.Size())
@@ -1196,7 +1436,9 @@ void AnimatedModel::UpdateSkinning()
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
             const Bone& bone = bones[i];
-            if (bone.node_)
+            if (flatPose)
+                skinMatrices_[i] = worldTransform * boneTransforms_[i] * bone.offsetMatrix_;
+            else if (bone.node_)
                 skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
             else
                 skinMatrices_[i] = worldTransform;
@@ -1208,7 +1450,9 @@ void AnimatedModel::UpdateSkinning()
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
             const Bone& bone = bones[i];
-            if (bone.node_)
+            if (flatPose)
+                skinMatrices_[i] = worldTransform * boneTransforms_[i] * bone.offsetMatrix_;
+            else if (bone.node_)
                 skinMatrices_[i] = bone.node_->GetWorldTransform() * bone.offsetMatrix_;
             else
                 skinMatrices_[i] = worldTransform;
@@ -51,6 +51,8 @@ public:
     virtual bool Load(Deserializer& source, bool setInstanceDefault = false);
     /// Load from XML data. Return true if successful.
     virtual bool LoadXML(const XMLElement& source, bool setInstanceDefault = false);
+    /// Load from already decoded attribute values. Return true if successful.
+    virtual bool LoadValues(const Vector<Variant>& values);
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     virtual void ApplyAttributes();
     /// Process octree raycast. May be called from a worker thread.
@@ -94,6 +96,10 @@ public:
     void SetMorphWeight(StringHash nameHash, float weight);
     /// Reset all vertex morphs to zero.
     void ResetMorphWeights();
+    /// Set whether to calculate the skeleton pose in flat transform arrays instead of bone scene nodes. Bone nodes are then only created on demand for attachments. Manual bone control, ragdolls, decals and skinned models sharing the skeleton require bone nodes. Changing the mode at runtime resets the skeleton and removes the animation states.
+    void SetFlatPose(bool enable);
+    /// Create a scene node for attaching objects to a bone when using flat pose. The node follows the animated bone and should not be moved manually. Return the existing bone node if already created, or null if the bone is not found.
+    Node* CreateBoneNode(const String& boneName);
 
     /// Return skeleton.
     Skeleton& GetSkeleton() { return skeleton_; }
@@ -127,6 +133,10 @@ public:
     float GetMorphWeight(StringHash nameHash) const;
     /// Return whether is the master (first) animated model.
     bool IsMaster() const { return isMaster_; }
+    /// Return whether calculates the skeleton pose in flat transform arrays.
+    bool GetFlatPose() const { return flatPose_; }
+    /// Return model-space bone transforms when using flat pose.
+    const PODVector<Matrix3x4>& GetBoneTransforms() const { return boneTransforms_; }
 
     /// Set model attribute.
     void SetModelAttr(const ResourceRef& value);
@@ -178,6 +188,12 @@ private:
     void CopyMorphVertices(void* dest, void* src, unsigned vertexCount, VertexBuffer* clone, VertexBuffer* original);
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Size the flat pose arrays and order the bones for transform calculation, or clear the arrays if not using flat pose.
+    void InitializeFlatPose();
+    /// Reset the flat pose, apply all animations and calculate the bone transforms.
+    void UpdateFlatPose();
+    /// Calculate the model-space bone transforms from the flat pose and copy them to the bone nodes.
+    void CalculateBoneTransforms();
     /// Recalculate the bone bounding box.
     void UpdateBoneBoundingBox();
     /// Recalculate skinning.
@@ -199,6 +215,16 @@ private:
     Vector<SharedPtr<AnimationState> > animationStates_;
     /// Skinning matrices.
     PODVector<Matrix3x4> skinMatrices_;
+    /// Local-space bone positions when using flat pose.
+    PODVector<Vector3> bonePositions_;
+    /// Local-space bone rotations when using flat pose.
+    PODVector<Quaternion> boneRotations_;
+    /// Local-space bone scales when using flat pose.
+    PODVector<Vector3> boneScales_;
+    /// Model-space bone transforms when using flat pose.
+    PODVector<Matrix3x4> boneTransforms_;
+    /// Bone indices ordered so that parents come before their children.
+    PODVector<unsigned> boneOrder_;
     /// Mapping of subgeometry bone indices, used if more bones than skinning shader can manage.
     Vector<PODVector<unsigned> > geometryBoneMappings_;
     /// Subgeometry skinning matrices, used if more bones than skinning shader can manage.
@@ -237,6 +263,8 @@ private:
     bool loading_;
     /// Bone nodes assignment pending flag.
     bool assignBonesPending_;
+    /// Flat pose flag.
+    bool flatPose_;
 };
 
 }
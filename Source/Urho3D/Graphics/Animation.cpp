@@ -30,16 +30,195 @@
 #include "../IO/Serializer.h"
 #include "../Resource/XMLFile.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+static const float ROTATION_QUANTIZATION_SCALE = 32767.0f;
+
 inline bool CompareTriggers(AnimationTriggerPoint& lhs, AnimationTriggerPoint& rhs)
 {
     return lhs.time_ < rhs.time_;
 }
 
+static void QuantizeRotation(const Quaternion& rotation, short* dest)
+{
+    Quaternion q = rotation.Normalized();
+    dest[0] = (short)floorf(q.w_ * ROTATION_QUANTIZATION_SCALE + 0.5f);
+    dest[1] = (short)floorf(q.x_ * ROTATION_QUANTIZATION_SCALE + 0.5f);
+    dest[2] = (short)floorf(q.y_ * ROTATION_QUANTIZATION_SCALE + 0.5f);
+    dest[3] = (short)floorf(q.z_ * ROTATION_QUANTIZATION_SCALE + 0.5f);
+}
+
+static Quaternion DecodeRotation(const short* src)
+{
+    return Quaternion(src[0], src[1], src[2], src[3]).Normalized();
+}
+
+static Quaternion InterpolateRotations(const short* src1, const short* src2, float t)
+{
+    #ifdef URHO3D_SSE
+    // Sign-extend both keys to 32-bit integers and convert to floats. The quantization scale cancels out when normalizing
+    __m128i packed = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)src1), _mm_loadl_epi64((const __m128i*)src2));
+    __m128 q1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+    __m128 q2 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+    
+    // Take the shortest path
+    __m128 dot = _mm_mul_ps(q1, q2);
+    dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+    dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(0, 1, 2, 3)));
+    q2 = _mm_xor_ps(q2, _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+    
+    __m128 q = _mm_add_ps(q1, _mm_mul_ps(_mm_sub_ps(q2, q1), _mm_set1_ps(t)));
+    __m128 n = _mm_mul_ps(q, q);
+    n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 3, 0, 1)));
+    n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(0, 1, 2, 3)));
+    
+    Quaternion ret;
+    _mm_storeu_ps(&ret.w_, _mm_div_ps(q, _mm_sqrt_ps(n)));
+    return ret;
+    #else
+    Quaternion q1(src1[0], src1[1], src1[2], src1[3]);
+    Quaternion q2(src2[0], src2[1], src2[2], src2[3]);
+    return q1.Nlerp(q2, t, true);
+    #endif
+}
+
+static float RotationDifference(const Quaternion& lhs, const Quaternion& rhs)
+{
+    // Measure the angle from the chord length, which stays accurate for small angles unlike the dot product
+    Quaternion delta = lhs.DotProduct(rhs) < 0.0f ? lhs + rhs : lhs - rhs;
+    return 4.0f * Asin(0.5f * sqrtf(delta.LengthSquared()));
+}
+
+static float VectorDifference(const Vector3& lhs, const Vector3& rhs)
+{
+    Vector3 delta = (lhs - rhs).Abs();
+    return Max(Max(delta.x_, delta.y_), delta.z_);
+}
+
+static float GetInterpolationFactor(float time, float startTime, float endTime)
+{
+    float timeInterval = endTime - startTime;
+    return timeInterval > 0.0f ? (time - startTime) / timeInterval : 1.0f;
+}
+
+static bool CanSkipVectorKeys(const Vector<AnimationKeyFrame>& keyFrames, Vector3 AnimationKeyFrame::* value, unsigned start,
+    unsigned end, float tolerance)
+{
+    const AnimationKeyFrame& startKey = keyFrames[start];
+    const AnimationKeyFrame& endKey = keyFrames[end];
+    
+    for (unsigned i = start + 1; i < end; ++i)
+    {
+        float t = GetInterpolationFactor(keyFrames[i].time_, startKey.time_, endKey.time_);
+        if (VectorDifference((startKey.*value).Lerp(endKey.*value, t), keyFrames[i].*value) > tolerance)
+            return false;
+    }
+    
+    return true;
+}
+
+static void CompressVectorChannel(const Vector<AnimationKeyFrame>& keyFrames, Vector3 AnimationKeyFrame::* value, float tolerance,
+    AnimationChannel& dest)
+{
+    unsigned numKeys = keyFrames.Size();
+    
+    dest.times_.Push(keyFrames[0].time_);
+    dest.vectors_.Push(keyFrames[0].*value);
+    
+    // Reduce a constant channel to the first key
+    unsigned i = 1;
+    while (i < numKeys && VectorDifference(keyFrames[i].*value, keyFrames[0].*value) <= tolerance)
+        ++i;
+    if (i == numKeys)
+        return;
+    
+    // Extend each interpolated segment as far as the skipped keys stay within the tolerance
+    unsigned start = 0;
+    while (start < numKeys - 1)
+    {
+        unsigned end = start + 1;
+        while (end + 1 < numKeys && CanSkipVectorKeys(keyFrames, value, start, end + 1, tolerance))
+            ++end;
+        
+        dest.times_.Push(keyFrames[end].time_);
+        dest.vectors_.Push(keyFrames[end].*value);
+        start = end;
+    }
+}
+
+static bool CanSkipRotationKeys(const Vector<AnimationKeyFrame>& keyFrames, const short* startRotation, unsigned start, unsigned end,
+    float tolerance)
+{
+    short endRotation[4];
+    QuantizeRotation(keyFrames[end].rotation_, endRotation);
+    
+    for (unsigned i = start + 1; i < end; ++i)
+    {
+        float t = GetInterpolationFactor(keyFrames[i].time_, keyFrames[start].time_, keyFrames[end].time_);
+        if (RotationDifference(InterpolateRotations(startRotation, endRotation, t), keyFrames[i].rotation_.Normalized()) > tolerance)
+            return false;
+    }
+    
+    return true;
+}
+
+static void CompressRotationChannel(const Vector<AnimationKeyFrame>& keyFrames, float tolerance, AnimationChannel& dest)
+{
+    unsigned numKeys = keyFrames.Size();
+    
+    dest.times_.Push(keyFrames[0].time_);
+    dest.rotations_.Resize(4);
+    QuantizeRotation(keyFrames[0].rotation_, &dest.rotations_[0]);
+    
+    // Reduce a constant channel to the first key, including the quantization error
+    Quaternion first = DecodeRotation(&dest.rotations_[0]);
+    unsigned i = 0;
+    while (i < numKeys && RotationDifference(keyFrames[i].rotation_.Normalized(), first) <= tolerance)
+        ++i;
+    if (i == numKeys)
+        return;
+    
+    // Extend each interpolated segment as far as the skipped keys stay within the tolerance. Test against the quantized
+    // keys so that the quantization error is included
+    unsigned start = 0;
+    while (start < numKeys - 1)
+    {
+        const short* startRotation = &dest.rotations_[dest.rotations_.Size() - 4];
+        unsigned end = start + 1;
+        while (end + 1 < numKeys && CanSkipRotationKeys(keyFrames, startRotation, start, end + 1, tolerance))
+            ++end;
+        
+        dest.times_.Push(keyFrames[end].time_);
+        dest.rotations_.Resize(dest.rotations_.Size() + 4);
+        QuantizeRotation(keyFrames[end].rotation_, &dest.rotations_[dest.rotations_.Size() - 4]);
+        start = end;
+    }
+}
+
+void AnimationChannel::GetKeyIndex(float time, unsigned& index) const
+{
+    if (time < 0.0f)
+        time = 0.0f;
+    
+    if (index >= times_.Size())
+        index = times_.Size() - 1;
+    
+    // Check for being too far ahead
+    while (index && time < times_[index])
+        --index;
+    
+    // Check for being too far behind
+    while (index < times_.Size() - 1 && time >= times_[index + 1])
+        ++index;
+}
+
 void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
 {
     if (time < 0.0f)
@@ -57,6 +236,146 @@ void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
         ++index;
 }
 
+void AnimationTrack::Compress(float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    if (compressed_)
+        return;
+    
+    if (keyFrames_.Empty())
+        channelMask_ = 0;
+    
+    if (channelMask_ & CHANNEL_POSITION)
+        CompressVectorChannel(keyFrames_, &AnimationKeyFrame::position_, positionTolerance, channels_[0]);
+    if (channelMask_ & CHANNEL_ROTATION)
+        CompressRotationChannel(keyFrames_, rotationTolerance, channels_[1]);
+    if (channelMask_ & CHANNEL_SCALE)
+        CompressVectorChannel(keyFrames_, &AnimationKeyFrame::scale_, scaleTolerance, channels_[2]);
+    
+    keyFrames_.Clear();
+    compressed_ = true;
+}
+
+void AnimationTrack::Sample(float time, float length, bool looped, unsigned& frame, unsigned& rotationFrame,
+    unsigned& scaleFrame, Vector3& position, Quaternion& rotation, Vector3& scale) const
+{
+    if (compressed_)
+    {
+        unsigned* keyIndices[3] = { &frame, &rotationFrame, &scaleFrame };
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            if (!(channelMask_ & (1 << i)))
+                continue;
+            
+            const AnimationChannel& channel = channels_[i];
+            unsigned& key = *keyIndices[i];
+            channel.GetKeyIndex(time, key);
+            
+            // Check if next key to interpolate to is valid, or if wrapping is needed (looping animation only)
+            unsigned nextKey = key + 1;
+            if (nextKey >= channel.GetNumKeys())
+                nextKey = looped ? 0 : key;
+            
+            float t = 0.0f;
+            if (nextKey != key)
+            {
+                float timeInterval = channel.times_[nextKey] - channel.times_[key];
+                if (timeInterval < 0.0f)
+                    timeInterval += length;
+                t = timeInterval > 0.0f ? (time - channel.times_[key]) / timeInterval : 1.0f;
+            }
+            
+            if (i == 1)
+            {
+                const short* src = &channel.rotations_[key * 4];
+                rotation = nextKey != key ? InterpolateRotations(src, &channel.rotations_[nextKey * 4], t) : DecodeRotation(src);
+            }
+            else
+            {
+                Vector3& dest = i ? scale : position;
+                dest = nextKey != key ? channel.vectors_[key].Lerp(channel.vectors_[nextKey], t) : channel.vectors_[key];
+            }
+        }
+        
+        return;
+    }
+    
+    GetKeyFrameIndex(time, frame);
+    
+    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+    unsigned nextFrame = frame + 1;
+    bool interpolate = true;
+    if (nextFrame >= keyFrames_.Size())
+    {
+        if (!looped)
+        {
+            nextFrame = frame;
+            interpolate = false;
+        }
+        else
+            nextFrame = 0;
+    }
+    
+    const AnimationKeyFrame* keyFrame = &keyFrames_[frame];
+    
+    if (!interpolate)
+    {
+        if (channelMask_ & CHANNEL_POSITION)
+            position = keyFrame->position_;
+        if (channelMask_ & CHANNEL_ROTATION)
+            rotation = keyFrame->rotation_;
+        if (channelMask_ & CHANNEL_SCALE)
+            scale = keyFrame->scale_;
+    }
+    else
+    {
+        const AnimationKeyFrame* nextKeyFrame = &keyFrames_[nextFrame];
+        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+        if (timeInterval < 0.0f)
+            timeInterval += length;
+        float t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
+        
+        if (channelMask_ & CHANNEL_POSITION)
+            position = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+        if (channelMask_ & CHANNEL_ROTATION)
+            rotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+        if (channelMask_ & CHANNEL_SCALE)
+            scale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+    }
+}
+
+Vector<AnimationKeyFrame> AnimationTrack::GetKeyFrames() const
+{
+    if (!compressed_)
+        return keyFrames_;
+    
+    // Sample all channels at the key times of each channel
+    PODVector<float> times;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        if (channelMask_ & (1 << i))
+            times.Push(channels_[i].times_);
+    }
+    Sort(times.Begin(), times.End());
+    
+    Vector<AnimationKeyFrame> ret;
+    unsigned keyFrame = 0;
+    unsigned rotationKeyFrame = 0;
+    unsigned scaleKeyFrame = 0;
+    for (unsigned i = 0; i < times.Size(); ++i)
+    {
+        if (i && times[i] == times[i - 1])
+            continue;
+        
+        AnimationKeyFrame newKeyFrame;
+        newKeyFrame.time_ = times[i];
+        Sample(times[i], 0.0f, false, keyFrame, rotationKeyFrame, scaleKeyFrame, newKeyFrame.position_, newKeyFrame.rotation_,
+            newKeyFrame.scale_);
+        ret.Push(newKeyFrame);
+    }
+    
+    return ret;
+}
+
 Animation::Animation(Context* context) :
     Resource(context),
     length_(0.f)
@@ -74,15 +393,16 @@ void Animation::RegisterObject(Context* context)
 
 bool Animation::BeginLoad(Deserializer& source)
 {
-    unsigned memoryUse = sizeof(Animation);
-    
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UANC")
     {
         LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
     }
     
+    bool compressed = fileID == "UANC";
+    
     // Read name and length
     animationName_ = source.ReadString();
     animationNameHash_ = animationName_;
@@ -91,7 +411,6 @@ bool Animation::BeginLoad(Deserializer& source)
     
     unsigned tracks = source.ReadUInt();
     tracks_.Resize(tracks);
-    memoryUse += tracks * sizeof(AnimationTrack);
     
     // Read tracks
     for (unsigned i = 0; i < tracks; ++i)
@@ -101,9 +420,46 @@ bool Animation::BeginLoad(Deserializer& source)
         newTrack.nameHash_ = newTrack.name_;
         newTrack.channelMask_ = source.ReadUByte();
         
+        // A compressed file may also contain tracks stored as keyframes
+        if (compressed && source.ReadBool())
+        {
+            newTrack.compressed_ = true;
+            
+            // Read the keys of each included channel
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                if (!(newTrack.channelMask_ & (1 << j)))
+                    continue;
+                
+                AnimationChannel& channel = newTrack.channels_[j];
+                unsigned keys = source.ReadUInt();
+                if (!keys)
+                {
+                    newTrack.channelMask_ &= ~(1 << j);
+                    continue;
+                }
+                
+                channel.times_.Resize(keys);
+                if (j == 1)
+                    channel.rotations_.Resize(keys * 4);
+                else
+                    channel.vectors_.Resize(keys);
+                
+                for (unsigned k = 0; k < keys; ++k)
+                {
+                    channel.times_[k] = source.ReadFloat();
+                    if (j == 1)
+                        source.Read(&channel.rotations_[k * 4], 4 * sizeof(short));
+                    else
+                        channel.vectors_[k] = source.ReadVector3();
+                }
+            }
+            
+            continue;
+        }
+        
         unsigned keyFrames = source.ReadUInt();
         newTrack.keyFrames_.Resize(keyFrames);
-        memoryUse += keyFrames * sizeof(AnimationKeyFrame);
         
         // Read keyframes of the track
         for (unsigned j = 0; j < keyFrames; ++j)
@@ -137,18 +493,17 @@ bool Animation::BeginLoad(Deserializer& source)
             
             triggerElem = triggerElem.GetNext("trigger");
         }
-
-        memoryUse += triggers_.Size() * sizeof(AnimationTriggerPoint);
     }
     
-    SetMemoryUse(memoryUse);
+    UpdateMemoryUse();
     return true;
 }
 
 bool Animation::Save(Serializer& dest) const
 {
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    bool compressed = IsCompressed();
+    dest.WriteFileID(compressed ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
     
@@ -159,6 +514,34 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = tracks_[i];
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
+        
+        // Tracks that have not been compressed are saved as keyframes also into a compressed file
+        if (compressed)
+            dest.WriteBool(track.IsCompressed());
+        
+        if (track.IsCompressed())
+        {
+            // Write the keys of each included channel
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                if (!(track.channelMask_ & (1 << j)))
+                    continue;
+                
+                const AnimationChannel& channel = track.channels_[j];
+                dest.WriteUInt(channel.GetNumKeys());
+                for (unsigned k = 0; k < channel.GetNumKeys(); ++k)
+                {
+                    dest.WriteFloat(channel.times_[k]);
+                    if (j == 1)
+                        dest.Write(&channel.rotations_[k * 4], 4 * sizeof(short));
+                    else
+                        dest.WriteVector3(channel.vectors_[k]);
+                }
+            }
+            
+            continue;
+        }
+        
         dest.WriteUInt(track.keyFrames_.Size());
         
         // Write keyframes of the track
@@ -245,6 +628,44 @@ void Animation::SetNumTriggers(unsigned num)
     triggers_.Resize(num);
 }
 
+void Animation::Compress(float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    for (unsigned i = 0; i < tracks_.Size(); ++i)
+        tracks_[i].Compress(positionTolerance, rotationTolerance, scaleTolerance);
+    
+    UpdateMemoryUse();
+}
+
+bool Animation::IsCompressed() const
+{
+    for (unsigned i = 0; i < tracks_.Size(); ++i)
+    {
+        if (tracks_[i].IsCompressed())
+            return true;
+    }
+    
+    return false;
+}
+
+void Animation::UpdateMemoryUse()
+{
+    unsigned memoryUse = sizeof(Animation) + tracks_.Size() * sizeof(AnimationTrack) + triggers_.Size() * sizeof(AnimationTriggerPoint);
+    
+    for (unsigned i = 0; i < tracks_.Size(); ++i)
+    {
+        const AnimationTrack& track = tracks_[i];
+        memoryUse += track.keyFrames_.Size() * sizeof(AnimationKeyFrame);
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            const AnimationChannel& channel = track.channels_[j];
+            memoryUse += channel.times_.Size() * sizeof(float) + channel.vectors_.Size() * sizeof(Vector3) +
+                channel.rotations_.Size() * sizeof(short);
+        }
+    }
+    
+    SetMemoryUse(memoryUse);
+}
+
 const AnimationTrack* Animation::GetTrack(unsigned index) const
 {
     return index < tracks_.Size() ? &tracks_[index] : 0;
@@ -43,11 +43,45 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
+/// Compressed keyframes of a single channel (position, rotation or scale) of an animation track.
+struct AnimationChannel
+{
+    /// Return key index based on time and previous index.
+    void GetKeyIndex(float time, unsigned& index) const;
+    /// Return number of keys.
+    unsigned GetNumKeys() const { return times_.Size(); }
+    
+    /// Key times. A constant channel has a single key.
+    PODVector<float> times_;
+    /// Position or scale values.
+    PODVector<Vector3> vectors_;
+    /// Rotation values quantized to 16 bits per component, four components per key in w, x, y, z order.
+    PODVector<short> rotations_;
+};
+
 /// Skeletal animation track, stores keyframes of a single bone.
-struct AnimationTrack
+struct URHO3D_API AnimationTrack
 {
+    /// Construct.
+    AnimationTrack() :
+        channelMask_(0),
+        compressed_(false)
+    {
+    }
+    
     /// Return keyframe index based on time and previous index.
     void GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Compress the keyframes to per-channel keys. Keys that can be interpolated from their neighbours within the tolerances are removed, and constant channels are reduced to a single key. Rotation tolerance is in degrees. The keyframes are cleared.
+    void Compress(float positionTolerance, float rotationTolerance, float scaleTolerance);
+    /// Sample the track. Only the channels included in the channel mask are written. The frame index holds the last keyframe, or the last position key when compressed. The rotation and scale frame indices are only used when compressed. All are updated.
+    void Sample(float time, float length, bool looped, unsigned& frame, unsigned& rotationFrame, unsigned& scaleFrame,
+        Vector3& position, Quaternion& rotation, Vector3& scale) const;
+    /// Return the keyframes. When compressed, they are decompressed by sampling all channels at each key time.
+    Vector<AnimationKeyFrame> GetKeyFrames() const;
+    /// Return whether has no keyframes.
+    bool IsEmpty() const { return compressed_ ? !channelMask_ : keyFrames_.Empty(); }
+    /// Return whether the keyframes have been compressed to per-channel keys.
+    bool IsCompressed() const { return compressed_; }
     
     /// Bone name.
     String name_;
@@ -55,8 +89,12 @@ struct AnimationTrack
     StringHash nameHash_;
     /// Bitmask of included data (position, rotation, scale.)
     unsigned char channelMask_;
-    /// Keyframes.
+    /// Keyframes. Empty when compressed, use GetKeyFrames() instead.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Compressed position, rotation and scale channels.
+    AnimationChannel channels_[3];
+    /// Compressed flag.
+    bool compressed_;
 };
 
 /// %Animation trigger point.
@@ -78,6 +116,10 @@ static const unsigned char CHANNEL_POSITION = 0x1;
 static const unsigned char CHANNEL_ROTATION = 0x2;
 static const unsigned char CHANNEL_SCALE = 0x4;
 
+static const float ANIMATION_DEFAULT_POSITION_TOLERANCE = 0.0001f;
+static const float ANIMATION_DEFAULT_ROTATION_TOLERANCE = 0.05f;
+static const float ANIMATION_DEFAULT_SCALE_TOLERANCE = 0.0001f;
+
 /// Skeletal animation resource.
 class URHO3D_API Animation : public Resource
 {
@@ -110,6 +152,8 @@ public:
     void RemoveAllTriggers();
     /// Resize trigger point vector.
     void SetNumTriggers(unsigned num);
+    /// Compress all tracks to per-channel keys with 16-bit rotations. The animation is then saved in the compressed format.
+    void Compress(float positionTolerance = ANIMATION_DEFAULT_POSITION_TOLERANCE, float rotationTolerance = ANIMATION_DEFAULT_ROTATION_TOLERANCE, float scaleTolerance = ANIMATION_DEFAULT_SCALE_TOLERANCE);
     
     /// Return animation name.
     const String& GetAnimationName() const { return animationName_; }
@@ -131,8 +175,13 @@ public:
     const Vector<AnimationTriggerPoint>& GetTriggers() const { return triggers_; }
     /// Return number of animation trigger points.
     unsigned GetNumTriggers() const {return triggers_.Size(); }
+    /// Return whether any track has been compressed.
+    bool IsCompressed() const;
     
 private:
+    /// Recalculate memory use.
+    void UpdateMemoryUse();
+    
     /// Animation name.
     String animationName_;
     /// Animation name hash.
@@ -37,7 +37,9 @@ AnimationStateTrack::AnimationStateTrack() :
     track_(0),
     bone_(0),
     weight_(1.0f),
-    keyFrame_(0)
+    keyFrame_(0),
+    rotationKeyFrame_(0),
+    scaleKeyFrame_(0)
 {
 }
 
@@ -127,9 +129,14 @@ void AnimationState::SetStartBone(Bone* startBone)
     const Vector<AnimationTrack>& tracks = animation_->GetTracks();
     stateTracks_.Clear();
     
-    if (!startBone->node_)
+    // In flat pose mode the bone hierarchy is followed through the parent indices instead of the bone nodes
+    bool flatPose = model_->GetFlatPose();
+    if (!startBone->node_ && !flatPose)
         return;
     
+    const Vector<Bone>& bones = skeleton.GetBones();
+    unsigned startBoneIndex = (unsigned)(startBone - &bones[0]);
+    
     for (unsigned i = 0; i < tracks.Size(); ++i)
     {
         AnimationStateTrack stateTrack;
@@ -141,6 +148,20 @@ void AnimationState::SetStartBone(Bone* startBone)
         
         if (nameHash == startBone->nameHash_)
             trackBone = startBone;
+        else if (flatPose)
+        {
+            Bone* bone = skeleton.GetBone(nameHash);
+            if (bone)
+            {
+                // Walk up the parents until reaching the start bone or the root
+                unsigned boneIndex = (unsigned)(bone - &bones[0]);
+                while (boneIndex != startBoneIndex && bones[boneIndex].parentIndex_ != boneIndex &&
+                    bones[boneIndex].parentIndex_ < bones.Size())
+                    boneIndex = bones[boneIndex].parentIndex_;
+                if (boneIndex == startBoneIndex)
+                    trackBone = bone;
+            }
+        }
         else
         {
             Node* trackBoneNode = startBone->node_->GetChild(nameHash, true);
@@ -148,7 +169,12 @@ void AnimationState::SetStartBone(Bone* startBone)
                 trackBone = skeleton.GetBone(nameHash);
         }
         
-        if (trackBone && trackBone->node_)
+        if (trackBone && flatPose)
+        {
+            stateTrack.bone_ = trackBone;
+            stateTracks_.Push(stateTrack);
+        }
+        else if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
             stateTrack.node_ = trackBone->node_;
@@ -209,7 +235,19 @@ void AnimationState::SetBoneWeight(unsigned index, float weight, bool recursive)
     if (recursive)
     {
         Node* boneNode = stateTracks_[index].node_;
-        if (boneNode)
+        Bone* bone = stateTracks_[index].bone_;
+        if (!boneNode && bone && model_)
+        {
+            // Without bone nodes, find the child tracks through the parent indices
+            const Vector<Bone>& bones = model_->GetSkeleton().GetBones();
+            unsigned boneIndex = (unsigned)(bone - &bones[0]);
+            for (unsigned i = 0; i < stateTracks_.Size(); ++i)
+            {
+                if (i != index && stateTracks_[i].bone_ && stateTracks_[i].bone_->parentIndex_ == boneIndex)
+                    SetBoneWeight(i, weight, true);
+            }
+        }
+        else if (boneNode)
         {
             const Vector<SharedPtr<Node> >& children = boneNode->GetChildren();
             for (unsigned i = 0; i < children.Size(); ++i)
@@ -354,7 +392,8 @@ unsigned AnimationState::GetTrackIndex(const String& name) const
     for (unsigned i = 0; i < stateTracks_.Size(); ++i)
     {
         Node* node = stateTracks_[i].node_;
-        if (node && node->GetName() == name)
+        Bone* bone = stateTracks_[i].bone_;
+        if (node ? node->GetName() == name : bone && bone->name_ == name)
             return i;
     }
     
@@ -377,7 +416,8 @@ unsigned AnimationState::GetTrackIndex(StringHash nameHash) const
     for (unsigned i = 0; i < stateTracks_.Size(); ++i)
     {
         Node* node = stateTracks_[i].node_;
-        if (node && node->GetNameHash() == nameHash)
+        Bone* bone = stateTracks_[i].bone_;
+        if (node ? node->GetNameHash() == nameHash : bone && bone->nameHash_ == nameHash)
             return i;
     }
 
@@ -411,7 +451,9 @@ void AnimationState::ApplyToModel()
         if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
             continue;
         
-        if (Equals(finalWeight, 1.0f))
+        if (!stateTrack.node_)
+            ApplyTrackToFlatPose(stateTrack, finalWeight);
+        else if (Equals(finalWeight, 1.0f))
             ApplyTrackFullWeightSilent(stateTrack);
         else
             ApplyTrackBlendedSilent(stateTrack, finalWeight);
@@ -430,111 +472,47 @@ void AnimationState::ApplyTrackFullWeight(AnimationStateTrack& stateTrack)
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
     
-    if (track->keyFrames_.Empty() || !node)
+    if (track->IsEmpty() || !node)
         return;
     
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-    
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, stateTrack.rotationKeyFrame_, stateTrack.scaleKeyFrame_,
+        position, rotation, scale);
     
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
+    // Full weight
     unsigned char channelMask = track->channelMask_;
-    
-    if (!interpolate)
-    {
-        // No interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(keyFrame->position_);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(keyFrame->rotation_);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(keyFrame->scale_);
-    }
-    else
-    {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-        
-        // Interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(keyFrame->position_.Lerp(nextKeyFrame->position_, t));
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t));
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(keyFrame->scale_.Lerp(nextKeyFrame->scale_, t));
-    }
+    if (channelMask & CHANNEL_POSITION)
+        node->SetPosition(position);
+    if (channelMask & CHANNEL_ROTATION)
+        node->SetRotation(rotation);
+    if (channelMask & CHANNEL_SCALE)
+        node->SetScale(scale);
 }
 
 void AnimationState::ApplyTrackFullWeightSilent(AnimationStateTrack& stateTrack)
 {
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
-
-    if (track->keyFrames_.Empty() || !node)
+    
+    if (track->IsEmpty() || !node)
         return;
-
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
-
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
+    
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, stateTrack.rotationKeyFrame_, stateTrack.scaleKeyFrame_,
+        position, rotation, scale);
+    
+    // Full weight
     unsigned char channelMask = track->channelMask_;
-
-    if (!interpolate)
-    {
-        // No interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(keyFrame->position_);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(keyFrame->rotation_);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(keyFrame->scale_);
-    }
-    else
-    {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-
-        // Interpolation, full weight
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(keyFrame->position_.Lerp(nextKeyFrame->position_, t));
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t));
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(keyFrame->scale_.Lerp(nextKeyFrame->scale_, t));
-    }
+    if (channelMask & CHANNEL_POSITION)
+        node->SetPositionSilent(position);
+    if (channelMask & CHANNEL_ROTATION)
+        node->SetRotationSilent(rotation);
+    if (channelMask & CHANNEL_SCALE)
+        node->SetScaleSilent(scale);
 }
 
 void AnimationState::ApplyTrackBlendedSilent(AnimationStateTrack& stateTrack, float weight)
@@ -542,63 +520,58 @@ void AnimationState::ApplyTrackBlendedSilent(AnimationStateTrack& stateTrack, fl
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
     
-    if (track->keyFrames_.Empty() || !node)
+    if (track->IsEmpty() || !node)
         return;
     
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, stateTrack.rotationKeyFrame_, stateTrack.scaleKeyFrame_,
+        position, rotation, scale);
     
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
-    
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
+    // Blend between old transform & animation
     unsigned char channelMask = track->channelMask_;
+    if (channelMask & CHANNEL_POSITION)
+        node->SetPositionSilent(node->GetPosition().Lerp(position, weight));
+    if (channelMask & CHANNEL_ROTATION)
+        node->SetRotationSilent(node->GetRotation().Slerp(rotation, weight));
+    if (channelMask & CHANNEL_SCALE)
+        node->SetScaleSilent(node->GetScale().Lerp(scale, weight));
+}
+
+void AnimationState::ApplyTrackToFlatPose(AnimationStateTrack& stateTrack, float weight)
+{
+    const AnimationTrack* track = stateTrack.track_;
+    const Vector<Bone>& bones = model_->GetSkeleton().GetBones();
+    unsigned index = (unsigned)(stateTrack.bone_ - &bones[0]);
+    
+    if (track->IsEmpty() || index >= model_->boneTransforms_.Size())
+        return;
     
-    if (!interpolate)
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+    track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, stateTrack.rotationKeyFrame_, stateTrack.scaleKeyFrame_,
+        position, rotation, scale);
+    
+    unsigned char channelMask = track->channelMask_;
+    if (Equals(weight, 1.0f))
     {
-        // No interpolation, blend between old transform & animation
         if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(node->GetPosition().Lerp(keyFrame->position_, weight));
+            model_->bonePositions_[index] = position;
         if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(node->GetRotation().Slerp(keyFrame->rotation_, weight));
+            model_->boneRotations_[index] = rotation;
         if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(node->GetScale().Lerp(keyFrame->scale_, weight));
+            model_->boneScales_[index] = scale;
     }
     else
     {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-        
-        // Interpolation, blend between old transform & animation
         if (channelMask & CHANNEL_POSITION)
-        {
-            node->SetPositionSilent(node->GetPosition().Lerp(
-                keyFrame->position_.Lerp(nextKeyFrame->position_, t), weight));
-        }
+            model_->bonePositions_[index] = model_->bonePositions_[index].Lerp(position, weight);
         if (channelMask & CHANNEL_ROTATION)
-        {
-            node->SetRotationSilent(node->GetRotation().Slerp(
-                keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t), weight));
-        }
+            model_->boneRotations_[index] = model_->boneRotations_[index].Slerp(rotation, weight);
         if (channelMask & CHANNEL_SCALE)
-        {
-            node->SetScaleSilent(node->GetScale().Lerp(
-                keyFrame->scale_.Lerp(nextKeyFrame->scale_, t), weight));
-        }
+            model_->boneScales_[index] = model_->boneScales_[index].Lerp(scale, weight);
     }
 }
 
@@ -52,8 +52,12 @@ struct AnimationStateTrack
     WeakPtr<Node> node_;
     /// Blending weight.
     float weight_;
-    /// Last key frame.
+    /// Last key frame, or last key of the position channel when the track is compressed.
     unsigned keyFrame_;
+    /// Last key of the rotation channel when the track is compressed.
+    unsigned rotationKeyFrame_;
+    /// Last key of the scale channel when the track is compressed.
+    unsigned scaleKeyFrame_;
 };
 
 /// %Animation instance.
@@ -135,6 +139,8 @@ private:
     void ApplyTrackFullWeightSilent(AnimationStateTrack& stateTrack);
     /// Apply animation track to a scene node, blended with current node transform. Apply transform changes silently without marking the node dirty.
     void ApplyTrackBlendedSilent(AnimationStateTrack& stateTrack, float weight);
+    /// Apply animation track to the model's flat pose arrays, blended with the current pose.
+    void ApplyTrackToFlatPose(AnimationStateTrack& stateTrack, float weight);
 
     /// Animated model (model mode.)
     WeakPtr<AnimatedModel> model_;
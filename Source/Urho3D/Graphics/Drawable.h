@@ -103,6 +103,7 @@ class URHO3D_API Drawable : public Component
     friend class Octant;
     friend class Octree;
     friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void CheckDrawableReinsertionWork(const WorkItem* item, unsigned threadIndex);
     
 public:
     /// Construct.
@@ -292,6 +293,8 @@ protected:
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octant's drawable list.
+    unsigned octantIndex_;
     /// Current zone.
     Zone* zone_;
     /// View mask.
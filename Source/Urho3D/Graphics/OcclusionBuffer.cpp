@@ -23,9 +23,14 @@
 #include "../Graphics/Camera.h"
 #include "../IO/Log.h"
 #include "../Graphics/OcclusionBuffer.h"
+#include "../Core/WorkQueue.h"
 
 #include <cstring>
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -38,6 +43,16 @@ static const unsigned CLIPMASK_Y_NEG = 0x8;
 static const unsigned CLIPMASK_Z_POS = 0x10;
 static const unsigned CLIPMASK_Z_NEG = 0x20;
 
+void RasterizeOcclusionBandsWork(const WorkItem* item, unsigned threadIndex)
+{
+    OcclusionBuffer* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
+    OcclusionBand* start = reinterpret_cast<OcclusionBand*>(item->start_);
+    OcclusionBand* end = reinterpret_cast<OcclusionBand*>(item->end_);
+    
+    while (start != end)
+        buffer->RasterizeBand(*start++);
+}
+
 OcclusionBuffer::OcclusionBuffer(Context* context) :
     Object(context),
     buffer_(0),
@@ -47,6 +62,8 @@ OcclusionBuffer::OcclusionBuffer(Context* context) :
     maxTriangles_(OCCLUSION_DEFAULT_MAX_TRIANGLES),
     cullMode_(CULL_CCW),
     depthHierarchyDirty_(true),
+    threaded_(false),
+    buildFirstMip_(false),
     reverseCulling_(false),
     nearClip_(0.0f),
     farClip_(0.0f)
@@ -99,6 +116,7 @@ bool OcclusionBuffer::SetSize(int width, int height)
         String(mipBuffers_.Size()) + " mip levels");
     
     CalculateViewport();
+    CalculateBands();
     return true;
 }
 
@@ -144,6 +162,7 @@ void OcclusionBuffer::Clear()
         return;
     
     Reset();
+    triangles_.Clear();
     
     int* dest = buffer_;
     int count = width_ * height_;
@@ -246,52 +265,30 @@ bool OcclusionBuffer::Draw(const Matrix3x4& model, const void* vertexData, unsig
     return true;
 }
 
+void OcclusionBuffer::DrawTriangles()
+{
+    if (!triangles_.Empty())
+        RasterizeBands(false);
+}
+
 void OcclusionBuffer::BuildDepthHierarchy()
 {
     if (!buffer_)
         return;
     
-    // Build the first mip level from the pixel-level data
+    // Build the first mip level from the pixel-level data. When threaded, each band builds its own rows after rasterizing
+    // the remaining triangles
     int width = (width_ + 1) / 2;
     int height = (height_ + 1) / 2;
     if (mipBuffers_.Size())
     {
-        for (int y = 0; y < height; ++y)
-        {
-            int* src = buffer_ + (y * 2) * width_;
-            DepthValue* dest = mipBuffers_[0].Get() + y * width;
-            DepthValue* end = dest + width;
-            
-            if (y * 2 + 1 < height_)
-            {
-                int* src2 = src + width_;
-                while (dest < end)
-                {
-                    int minUpper = Min(src[0], src[1]);
-                    int minLower = Min(src2[0], src2[1]);
-                    dest->min_ = Min(minUpper, minLower);
-                    int maxUpper = Max(src[0], src[1]);
-                    int maxLower = Max(src2[0], src2[1]);
-                    dest->max_ = Max(maxUpper, maxLower);
-                    
-                    src += 2;
-                    src2 += 2;
-                    ++dest;
-                }
-            }
-            else
-            {
-                while (dest < end)
-                {
-                    dest->min_ = Min(src[0], src[1]);
-                    dest->max_ = Max(src[0], src[1]);
-                    
-                    src += 2;
-                    ++dest;
-                }
-            }
-        }
+        if (threaded_)
+            RasterizeBands(true);
+        else
+            BuildFirstMipLevel(0, height);
     }
+    else
+        DrawTriangles();
     
     // Build the rest of the mip levels
     for (unsigned i = 1; i < mipBuffers_.Size(); ++i)
@@ -341,6 +338,47 @@ void OcclusionBuffer::BuildDepthHierarchy()
     depthHierarchyDirty_ = false;
 }
 
+void OcclusionBuffer::BuildFirstMipLevel(int startY, int endY)
+{
+    int width = (width_ + 1) / 2;
+    
+    for (int y = startY; y < endY; ++y)
+    {
+        int* src = buffer_ + (y * 2) * width_;
+        DepthValue* dest = mipBuffers_[0].Get() + y * width;
+        DepthValue* end = dest + width;
+        
+        if (y * 2 + 1 < height_)
+        {
+            int* src2 = src + width_;
+            while (dest < end)
+            {
+                int minUpper = Min(src[0], src[1]);
+                int minLower = Min(src2[0], src2[1]);
+                dest->min_ = Min(minUpper, minLower);
+                int maxUpper = Max(src[0], src[1]);
+                int maxLower = Max(src2[0], src2[1]);
+                dest->max_ = Max(maxUpper, maxLower);
+                
+                src += 2;
+                src2 += 2;
+                ++dest;
+            }
+        }
+        else
+        {
+            while (dest < end)
+            {
+                dest->min_ = Min(src[0], src[1]);
+                dest->max_ = Max(src[0], src[1]);
+                
+                src += 2;
+                ++dest;
+            }
+        }
+    }
+}
+
 void OcclusionBuffer::ResetUseTimer()
 {
     useTimer_.Reset();
@@ -522,6 +560,28 @@ void OcclusionBuffer::CalculateViewport()
     projOffsetScaleY_ = projection_.m11_ * scaleY_;
 }
 
+void OcclusionBuffer::CalculateBands()
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue ? queue->GetNumThreads() : 0;
+    threaded_ = numThreads && height_ >= 2 * OCCLUSION_MIN_BAND_HEIGHT;
+    
+    // Use two bands per thread for load balancing. Keep the band height even so that each band can build its own rows
+    // of the first mip level
+    int numBands = threaded_ ? Min((int)(numThreads + 1) * 2, height_ / OCCLUSION_MIN_BAND_HEIGHT) : 1;
+    int bandHeight = (height_ + numBands - 1) / numBands;
+    bandHeight += bandHeight & 1;
+    
+    bands_.Clear();
+    for (int top = 0; top < height_; top += bandHeight)
+    {
+        OcclusionBand band;
+        band.top_ = top;
+        band.bottom_ = Min(top + bandHeight, height_);
+        bands_.Push(band);
+    }
+}
+
 void OcclusionBuffer::DrawTriangle(Vector4* vertices)
 {
     unsigned clipMask = 0;
@@ -569,7 +629,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices)
         bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
         if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
         {
-            DrawTriangle2D(projected, clockwise);
+            AddTriangle2D(projected, clockwise);
             drawOk = true;
         }
     }
@@ -607,7 +667,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices)
                 bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
                 if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
                 {
-                    DrawTriangle2D(projected, clockwise);
+                    AddTriangle2D(projected, clockwise);
                     drawOk = true;
                 }
             }
@@ -688,6 +748,65 @@ void OcclusionBuffer::ClipVertices(const Vector4& plane, Vector4* vertices, bool
     }
 }
 
+void OcclusionBuffer::AddTriangle2D(const Vector3* vertices, bool clockwise)
+{
+    if (!threaded_)
+    {
+        DrawTriangle2D(vertices, clockwise, 0, height_);
+        return;
+    }
+    
+    triangles_.Resize(triangles_.Size() + 1);
+    OcclusionTriangle& triangle = triangles_.Back();
+    triangle.vertices_[0] = vertices[0];
+    triangle.vertices_[1] = vertices[1];
+    triangle.vertices_[2] = vertices[2];
+    triangle.clockwise_ = clockwise;
+    
+    if (triangles_.Size() >= OCCLUSION_BATCH_TRIANGLES)
+        RasterizeBands(false);
+}
+
+void OcclusionBuffer::RasterizeBands(bool buildFirstMip)
+{
+    // Bin the triangles to the bands they overlap
+    for (unsigned i = 0; i < bands_.Size(); ++i)
+        bands_[i].triangles_.Clear();
+    
+    for (unsigned i = 0; i < triangles_.Size(); ++i)
+    {
+        const Vector3* vertices = triangles_[i].vertices_;
+        int topY = (int)Min(Min(vertices[0].y_, vertices[1].y_), vertices[2].y_);
+        int bottomY = (int)Max(Max(vertices[0].y_, vertices[1].y_), vertices[2].y_);
+        
+        for (unsigned j = 0; j < bands_.Size(); ++j)
+        {
+            OcclusionBand& band = bands_[j];
+            if (topY < band.bottom_ && bottomY > band.top_)
+                band.triangles_.Push(i);
+        }
+    }
+    
+    buildFirstMip_ = buildFirstMip;
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    queue->ParallelFor(RasterizeOcclusionBandsWork, bands_.Begin(), bands_.End(), this, 1);
+    queue->Complete(M_MAX_UNSIGNED);
+    
+    triangles_.Clear();
+}
+
+void OcclusionBuffer::RasterizeBand(const OcclusionBand& band)
+{
+    for (PODVector<unsigned>::ConstIterator i = band.triangles_.Begin(); i != band.triangles_.End(); ++i)
+    {
+        const OcclusionTriangle& triangle = triangles_[*i];
+        DrawTriangle2D(triangle.vertices_, triangle.clockwise_, band.top_, band.bottom_);
+    }
+    
+    if (buildFirstMip_)
+        BuildFirstMipLevel(band.top_ / 2, (band.bottom_ + 1) / 2);
+}
+
 // Code based on Chris Hecker's Perspective Texture Mapping series in the Game Developer magazine
 // Also available online at http://chrishecker.com/Miscellaneous_Technical_Articles
 
@@ -736,6 +855,7 @@ struct Edge
         xStep_ = (int)(slope * OCCLUSION_X_SCALE + 0.5f);
         invZ_ = (int)(top.z_ + xPreStep * gradients.dInvZdX_ + yPreStep * gradients.dInvZdY_ + 0.5f);
         invZStep_ = (int)(slope * gradients.dInvZdX_ + gradients.dInvZdY_ + 0.5f);
+        y_ = topY;
     }
     
     /// X coordinate.
@@ -746,9 +866,11 @@ struct Edge
     int invZ_;
     /// Inverse Z step.
     int invZStep_;
+    /// Row of the initial values.
+    int y_;
 };
 
-void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise)
+void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, int clipTop, int clipBottom)
 {
     int top, middle, bottom;
     bool middleIsRight;
@@ -803,8 +925,8 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise)
     int middleY = (int)vertices[middle].y_;
     int bottomY = (int)vertices[bottom].y_;
     
-    // Check for degenerate triangle
-    if (topY == bottomY)
+    // Check for degenerate triangle, or one outside the clipped rows
+    if (topY == bottomY || topY >= clipBottom || bottomY <= clipTop)
         return;
     
     // Reverse middleIsRight test if triangle is counterclockwise
@@ -816,97 +938,83 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise)
     Edge topToBottom(gradients, vertices[top], vertices[bottom], topY);
     Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
     
+    int middleStartY = Max(middleY, clipTop);
+    topY = Max(topY, clipTop);
+    middleY = Min(middleY, clipBottom);
+    bottomY = Min(bottomY, clipBottom);
+    
     if (middleIsRight)
     {
-        // Top half
-        int* row = buffer_ + topY * width_;
-        int* endRow = buffer_ + middleY * width_;
-        while (row < endRow)
-        {
-            int invZ = topToBottom.invZ_;
-            int* dest = row + (topToBottom.x_ >> 16);
-            int* end = row + (topToMiddle.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-            
-            topToBottom.x_ += topToBottom.xStep_;
-            topToBottom.invZ_ += topToBottom.invZStep_;
-            topToMiddle.x_ += topToMiddle.xStep_;
-            row += width_;
-        }
-        
-        // Bottom half
-        row = buffer_ + middleY * width_;
-        endRow = buffer_ + bottomY * width_;
-        while (row < endRow)
-        {
-            int invZ = topToBottom.invZ_;
-            int* dest = row + (topToBottom.x_ >> 16);
-            int* end = row + (middleToBottom.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-            
-            topToBottom.x_ += topToBottom.xStep_;
-            topToBottom.invZ_ += topToBottom.invZStep_;
-            middleToBottom.x_ += middleToBottom.xStep_;
-            row += width_;
-        }
+        DrawSpans(topToBottom, topToMiddle, topY, middleY, gradients.dInvZdXInt_);
+        DrawSpans(topToBottom, middleToBottom, middleStartY, bottomY, gradients.dInvZdXInt_);
     }
     else
     {
-        // Top half
-        int* row = buffer_ + topY * width_;
-        int* endRow = buffer_ + middleY * width_;
-        while (row < endRow)
+        DrawSpans(topToMiddle, topToBottom, topY, middleY, gradients.dInvZdXInt_);
+        DrawSpans(middleToBottom, topToBottom, middleStartY, bottomY, gradients.dInvZdXInt_);
+    }
+}
+
+void OcclusionBuffer::DrawSpans(const Edge& left, const Edge& right, int startY, int endY, int dInvZdX)
+{
+    if (startY >= endY)
+        return;
+    
+    // Step the edges to the first row
+    int leftX = left.x_ + (startY - left.y_) * left.xStep_;
+    int leftInvZ = left.invZ_ + (startY - left.y_) * left.invZStep_;
+    int rightX = right.x_ + (startY - right.y_) * right.xStep_;
+    
+    int* row = buffer_ + startY * width_;
+    int* endRow = buffer_ + endY * width_;
+    
+    #ifdef URHO3D_SSE
+    __m128i zOffsets = _mm_set_epi32(3 * dInvZdX, 2 * dInvZdX, dInvZdX, 0);
+    __m128i zStep = _mm_set1_epi32(4 * dInvZdX);
+    #endif
+    
+    while (row < endRow)
+    {
+        int invZ = leftInvZ;
+        int* dest = row + (leftX >> 16);
+        int* end = row + (rightX >> 16);
+        
+        // Clip to the row so that bands being rasterized in parallel do not overlap
+        if (dest < row)
         {
-            int invZ = topToMiddle.invZ_;
-            int* dest = row + (topToMiddle.x_ >> 16);
-            int* end = row + (topToBottom.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-            
-            topToMiddle.x_ += topToMiddle.xStep_;
-            topToMiddle.invZ_ += topToMiddle.invZStep_;
-            topToBottom.x_ += topToBottom.xStep_;
-            row += width_;
+            invZ += (int)(row - dest) * dInvZdX;
+            dest = row;
         }
+        if (end > row + width_)
+            end = row + width_;
         
-        // Bottom half
-        row = buffer_ + middleY * width_;
-        endRow = buffer_ + bottomY * width_;
-        while (row < endRow)
+        #ifdef URHO3D_SSE
+        // Fill four pixels at a time. SSE2 has no 32-bit integer minimum, so select with a comparison mask
+        __m128i z = _mm_add_epi32(_mm_set1_epi32(invZ), zOffsets);
+        while (dest + 4 <= end)
         {
-            int invZ = middleToBottom.invZ_;
-            int* dest = row + (middleToBottom.x_ >> 16);
-            int* end = row + (topToBottom.x_ >> 16);
-            while (dest < end)
-            {
-                if (invZ < *dest)
-                    *dest = invZ;
-                invZ += gradients.dInvZdXInt_;
-                ++dest;
-            }
-            
-            middleToBottom.x_ += middleToBottom.xStep_;
-            middleToBottom.invZ_ += middleToBottom.invZStep_;
-            topToBottom.x_ += topToBottom.xStep_;
-            row += width_;
+            __m128i depth = _mm_loadu_si128((__m128i*)dest);
+            __m128i closer = _mm_cmplt_epi32(z, depth);
+            depth = _mm_or_si128(_mm_and_si128(closer, z), _mm_andnot_si128(closer, depth));
+            _mm_storeu_si128((__m128i*)dest, depth);
+            z = _mm_add_epi32(z, zStep);
+            invZ += 4 * dInvZdX;
+            dest += 4;
+        }
+        #endif
+        
+        while (dest < end)
+        {
+            if (invZ < *dest)
+                *dest = invZ;
+            invZ += dInvZdX;
+            ++dest;
         }
+        
+        leftX += left.xStep_;
+        leftInvZ += left.invZStep_;
+        rightX += right.xStep_;
+        row += width_;
     }
 }
 
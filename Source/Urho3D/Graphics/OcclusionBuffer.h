@@ -36,8 +36,10 @@ class Camera;
 class IndexBuffer;
 class IntRect;
 class VertexBuffer;
+class WorkQueue;
 struct Edge;
 struct Gradients;
+struct WorkItem;
 
 /// Occlusion hierarchy depth range.
 struct DepthValue
@@ -48,7 +50,29 @@ struct DepthValue
     int max_;
 };
 
+/// Screen-space occluder triangle queued for rasterization.
+struct OcclusionTriangle
+{
+    /// Vertices.
+    Vector3 vertices_[3];
+    /// Clockwise flag.
+    bool clockwise_;
+};
+
+/// Horizontal band of the occlusion buffer, rasterized by one work item.
+struct OcclusionBand
+{
+    /// Top row.
+    int top_;
+    /// Bottom row, exclusive.
+    int bottom_;
+    /// Indices of queued triangles that overlap the band.
+    PODVector<unsigned> triangles_;
+};
+
 static const int OCCLUSION_MIN_SIZE = 8;
+static const int OCCLUSION_MIN_BAND_HEIGHT = 16;
+static const unsigned OCCLUSION_BATCH_TRIANGLES = 256;
 static const int OCCLUSION_DEFAULT_MAX_TRIANGLES = 5000;
 static const float OCCLUSION_RELATIVE_BIAS = 0.00001f;
 static const int OCCLUSION_FIXED_BIAS = 16;
@@ -60,6 +84,8 @@ class URHO3D_API OcclusionBuffer : public Object
 {
     OBJECT(OcclusionBuffer);
     
+    friend void RasterizeOcclusionBandsWork(const WorkItem* item, unsigned threadIndex);
+    
 public:
     /// Construct.
     OcclusionBuffer(Context* context);
@@ -82,7 +108,9 @@ public:
     bool Draw(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, unsigned vertexStart, unsigned vertexCount);
     /// Draw a triangle mesh to the buffer using indexed geometry.
     bool Draw(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, const void* indexData, unsigned indexSize, unsigned indexStart, unsigned indexCount);
-    /// Build reduced size mip levels.
+    /// Rasterize the triangles queued for worker threads. Called automatically when enough triangles have been queued and when building the depth hierarchy.
+    void DrawTriangles();
+    /// Rasterize any queued triangles and build reduced size mip levels.
     void BuildDepthHierarchy();
     /// Reset last used timer.
     void ResetUseTimer();
@@ -103,7 +131,9 @@ public:
     unsigned GetMaxTriangles() const { return maxTriangles_; }
     /// Return culling mode.
     CullMode GetCullMode() const { return cullMode_; }
-    /// Test a bounding box for visibility. For best performance, build depth hierarchy first.
+    /// Return whether triangles are rasterized in worker threads.
+    bool IsThreaded() const { return threaded_; }
+    /// Test a bounding box for visibility against the rasterized triangles. For best performance, build depth hierarchy first.
     bool IsVisible(const BoundingBox& worldSpaceBox) const;
     /// Return time since last use in milliseconds.
     unsigned GetUseTimer();
@@ -119,12 +149,24 @@ private:
     inline float SignedArea(const Vector3& v0, const Vector3& v1, const Vector3& v2) const;
     /// Calculate viewport transform.
     void CalculateViewport();
+    /// Divide the buffer into horizontal bands for the worker threads.
+    void CalculateBands();
     /// Draw a triangle.
     void DrawTriangle(Vector4* vertices);
     /// Clip vertices against a plane.
     void ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles);
-    /// Draw a clipped triangle.
-    void DrawTriangle2D(const Vector3* vertices, bool clockwise);
+    /// Rasterize a clipped triangle immediately, or queue it for the worker threads.
+    void AddTriangle2D(const Vector3* vertices, bool clockwise);
+    /// Bin the queued triangles to bands and rasterize them in worker threads. Optionally build the first mip level of each band afterward.
+    void RasterizeBands(bool buildFirstMip);
+    /// Rasterize the triangles binned to a band, and build its first mip level rows if requested.
+    void RasterizeBand(const OcclusionBand& band);
+    /// Draw a clipped triangle limited to the rows between clipTop and clipBottom.
+    void DrawTriangle2D(const Vector3* vertices, bool clockwise, int clipTop, int clipBottom);
+    /// Draw spans between two triangle edges.
+    void DrawSpans(const Edge& left, const Edge& right, int startY, int endY, int dInvZdX);
+    /// Build rows of the first mip level.
+    void BuildFirstMipLevel(int startY, int endY);
     
     /// Highest level depth buffer.
     int* buffer_;
@@ -140,6 +182,10 @@ private:
     CullMode cullMode_;
     /// Depth hierarchy needs update flag.
     bool depthHierarchyDirty_;
+    /// Worker thread rasterization flag.
+    bool threaded_;
+    /// Build first mip level flag for the band work items.
+    bool buildFirstMip_;
     /// Culling reverse flag.
     bool reverseCulling_;
     /// View transform matrix.
@@ -170,6 +216,10 @@ private:
     SharedArrayPtr<int> fullBuffer_;
     /// Reduced size depth buffers.
     Vector<SharedArrayPtr<DepthValue> > mipBuffers_;
+    /// Triangles queued for worker thread rasterization.
+    PODVector<OcclusionTriangle> triangles_;
+    /// Horizontal bands for worker thread rasterization.
+    Vector<OcclusionBand> bands_;
 };
 
 }
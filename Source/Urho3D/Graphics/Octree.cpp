@@ -79,6 +79,31 @@ void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+void CheckDrawableReinsertionWork(const WorkItem* item, unsigned threadIndex)
+{
+    Octree* octree = reinterpret_cast<Octree*>(item->aux_);
+    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
+    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+    PODVector<Drawable*>& reinsertions = octree->drawableReinsertions_[threadIndex];
+
+    while (start != end)
+    {
+        Drawable* drawable = *start++;
+        drawable->updateQueued_ = false;
+        Octant* octant = drawable->GetOctant();
+        const BoundingBox& box = drawable->GetWorldBoundingBox();
+
+        // Skip if no octant or does not belong to this octree anymore
+        if (!octant || octant->GetRoot() != octree)
+            continue;
+        // Skip reinsertion if still fits the current octant, but refresh the packed bounding box for culling
+        if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            octant->UpdateDrawableBounds(drawable);
+        else
+            reinsertions.Push(drawable);
+    }
+}
+
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -104,11 +129,11 @@ Octant::~Octant()
         // Remove the drawables (if any) from this octant to the root octant
         for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
         {
-            (*i)->SetOctant(root_);
-            root_->drawables_.Push(*i);
+            root_->PushDrawable(*i);
             root_->QueueUpdate(*i);
         }
         drawables_.Clear();
+        drawableBounds_.Clear();
         numDrawables_ = 0;
     }
 
@@ -168,11 +193,14 @@ void Octant::InsertDrawable(Drawable* drawable)
         Octant* oldOctant = drawable->octant_;
         if (oldOctant != this)
         {
+            unsigned oldIndex = drawable->octantIndex_;
             // Add first, then remove, because drawable count going to zero deletes the octree branch in question
             AddDrawable(drawable);
             if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+                oldOctant->RemoveDrawableAt(oldIndex, false);
         }
+        else
+            UpdateDrawableBounds(drawable);
     }
     else
     {
@@ -264,7 +292,7 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         Drawable** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        query.TestPackedDrawables(start, end, drawableBounds_, inside);
     }
 
     for (unsigned i = 0; i < NUM_OCTANTS; ++i)
@@ -340,14 +368,13 @@ Octree::Octree(Context* context) :
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
     if (!GetSubsystem<Graphics>())
-        SubscribeToEvent(E_RENDERUPDATE, HANDLER(Octree, HandleRenderUpdate));
+        SubscribeToEvent(TYPED_HANDLER(Octree, HandleRenderUpdate));
 }
 
 Octree::~Octree()
 {
     // Reset root pointer from all child octants now so that they do not move their drawables to root
     drawableUpdates_.Clear();
-    drawableReinsertions_.Clear();
     ResetRoot();
 }
 
@@ -406,29 +433,8 @@ void Octree::Update(const FrameInfo& frame)
         WorkQueue* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
         
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
-        
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
         // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
+        queue->ParallelFor(UpdateDrawablesWork, drawableUpdates_.Begin(), drawableUpdates_.End(), const_cast<FrameInfo*>(&frame));
         queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
     }
@@ -451,31 +457,41 @@ void Octree::Update(const FrameInfo& frame)
     {
         PROFILE(ReinsertToOctree);
 
-        for (PODVector<Drawable*>::Iterator i = drawableUpdates_.Begin(); i != drawableUpdates_.End(); ++i)
+        // First update the bounding boxes and check which drawables no longer fit their octant in worker threads.
+        // Those that still fit only need their packed bounding box refreshed, which does not modify the octree
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        drawableReinsertions_.Resize(queue->GetNumThreads() + 1);
+        if (scene)
+            scene->BeginThreadedUpdate();
+        
+        queue->ParallelFor(CheckDrawableReinsertionWork, drawableUpdates_.Begin(), drawableUpdates_.End(), this);
+        queue->Complete(M_MAX_UNSIGNED);
+        if (scene)
+            scene->EndThreadedUpdate();
+        
+        // Then reinsert the drawables that moved out. This creates and deletes octants, so it is done in the main thread
+        for (unsigned i = 0; i < drawableReinsertions_.Size(); ++i)
         {
-            Drawable* drawable = *i;
-            drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
-
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetRoot() != this)
-                continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
-                continue;
-
-            InsertDrawable(drawable);
-
-            #ifdef _DEBUG
-            // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
-            if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
+            PODVector<Drawable*>& reinsertions = drawableReinsertions_[i];
+            
+            for (PODVector<Drawable*>::Iterator j = reinsertions.Begin(); j != reinsertions.End(); ++j)
             {
-                LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
-                    " octant box " + octant->GetCullingBox().ToString());
+                Drawable* drawable = *j;
+                InsertDrawable(drawable);
+
+                #ifdef _DEBUG
+                // Verify that the drawable will be culled correctly
+                const BoundingBox& box = drawable->GetWorldBoundingBox();
+                Octant* octant = drawable->GetOctant();
+                if (octant != this && octant->GetCullingBox().IsInside(box) != INSIDE)
+                {
+                    LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
+                        " octant box " + octant->GetCullingBox().ToString());
+                }
+                #endif
             }
-            #endif
+            
+            reinsertions.Clear();
         }
     }
     
@@ -616,6 +632,10 @@ void Octree::QueueUpdate(Drawable* drawable)
         drawableUpdates_.Push(drawable);
     
     drawable->updateQueued_ = true;
+    // The bounding box may change before the update, so it can no longer be trusted for culling
+    Octant* octant = drawable->GetOctant();
+    if (octant)
+        octant->UpdateDrawableBounds(drawable);
 }
 
 void Octree::CancelUpdate(Drawable* drawable)
@@ -630,18 +650,16 @@ void Octree::DrawDebugGeometry(bool depthTest)
     DrawDebugGeometry(debug, depthTest);
 }
 
-void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Octree::HandleRenderUpdate(RenderUpdateEventData& eventData)
 {
     // When running in headless mode, update the Octree manually during the RenderUpdate event
     Scene* scene = GetScene();
     if (!scene || !scene->IsUpdateEnabled())
         return;
     
-    using namespace RenderUpdate;
-    
     FrameInfo frame;
     frame.frameNumber_ = GetSubsystem<Time>()->GetFrameNumber();
-    frame.timeStep_ = eventData[P_TIMESTEP].GetFloat();
+    frame.timeStep_ = eventData.timeStep_;
     frame.camera_ = 0;
     
     Update(frame);
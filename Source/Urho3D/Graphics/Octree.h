@@ -31,6 +31,7 @@ namespace Urho3D
 {
 
 class Octree;
+struct RenderUpdateEventData;
 
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
@@ -56,22 +57,31 @@ public:
     /// Add a drawable object to this octant.
     void AddDrawable(Drawable* drawable)
     {
-        drawable->SetOctant(this);
-        drawables_.Push(drawable);
+        PushDrawable(drawable);
+        UpdateDrawableBounds(drawable);
         IncDrawableCount();
     }
     
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        if (drawables_.Remove(drawable))
-        {
-            if (resetOctant)
-                drawable->SetOctant(0);
-            DecDrawableCount();
-        }
+        unsigned index = drawable->octantIndex_;
+        if (index < drawables_.Size() && drawables_[index] == drawable)
+            RemoveDrawableAt(index, resetOctant);
+    }
+    
+    /// Refresh the packed world bounding box of a drawable object in this octant. If the drawable has an update queued, the bounding box is marked dirty instead.
+    void UpdateDrawableBounds(Drawable* drawable)
+    {
+        if (drawable->updateQueued_)
+            drawableBounds_.SetDirty(drawable->octantIndex_);
+        else
+            drawableBounds_.Set(drawable->octantIndex_, drawable->GetWorldBoundingBox());
     }
     
+    /// Mark the packed world bounding box of a drawable object in this octant dirty, so that culling tests the drawable's own bounding box instead.
+    void MarkDrawableBoundsDirty(Drawable* drawable) { drawableBounds_.SetDirty(drawable->octantIndex_); }
+    
     /// Return world-space bounding box.
     const BoundingBox& GetWorldBoundingBox() const { return worldBoundingBox_; }
     /// Return bounding box used for fitting drawable objects.
@@ -84,6 +94,8 @@ public:
     Octree* GetRoot() const { return root_; }
     /// Return number of drawables.
     unsigned GetNumDrawables() const { return numDrawables_; }
+    /// Return packed world bounding boxes of the drawables in this octant.
+    const DrawableBounds& GetDrawableBounds() const { return drawableBounds_; }
     /// Return true if there are no drawable objects in this octant and child octants.
     bool IsEmpty() { return numDrawables_ == 0; }
     
@@ -102,6 +114,33 @@ protected:
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
     
+    /// Append a drawable object with dirty bounds, without updating the drawable counts.
+    void PushDrawable(Drawable* drawable)
+    {
+        drawable->SetOctant(this);
+        drawable->octantIndex_ = drawables_.Size();
+        drawables_.Push(drawable);
+        drawableBounds_.PushDirty();
+    }
+    
+    /// Remove a drawable object by index by moving the last drawable into its place.
+    void RemoveDrawableAt(unsigned index, bool resetOctant)
+    {
+        Drawable* drawable = drawables_[index];
+        unsigned last = drawables_.Size() - 1;
+        if (index != last)
+        {
+            drawables_[index] = drawables_[last];
+            drawables_[index]->octantIndex_ = index;
+        }
+        drawables_.Pop();
+        drawableBounds_.Remove(index);
+        
+        if (resetOctant)
+            drawable->SetOctant(0);
+        DecDrawableCount();
+    }
+    
     /// Increase drawable object count recursively.
     void IncDrawableCount()
     {
@@ -132,6 +171,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// Packed world bounding boxes of the drawable objects for culling.
+    DrawableBounds drawableBounds_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS];
     /// World bounding box center.
@@ -154,6 +195,7 @@ protected:
 class URHO3D_API Octree : public Component, public Octant
 {
     friend void RaycastDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void CheckDrawableReinsertionWork(const WorkItem* item, unsigned threadIndex);
     
     OBJECT(Octree);
     
@@ -197,12 +239,12 @@ public:
     
 private:
     /// Handle render update in case of headless execution.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(RenderUpdateEventData& eventData);
     
     /// Drawable objects that require update.
     PODVector<Drawable*> drawableUpdates_;
-    /// Drawable objects that require reinsertion.
-    PODVector<Drawable*> drawableReinsertions_;
+    /// Drawable objects that require reinsertion, collected per thread.
+    Vector<PODVector<Drawable*> > drawableReinsertions_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
     /// Current threaded ray query.
@@ -22,11 +22,73 @@
 
 #include "../Graphics/OctreeQuery.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+static const unsigned MAX_PASSED_DRAWABLES = 64;
+
+/// Return a bitmask of the boxes in a packed block that are not outside the frustum.
+static unsigned TestFrustumBlock(const Frustum& frustum, const float* block)
+{
+    #ifdef URHO3D_SSE
+    __m128 centerX = _mm_loadu_ps(block);
+    __m128 centerY = _mm_loadu_ps(block + DrawableBounds::BLOCK_SIZE);
+    __m128 centerZ = _mm_loadu_ps(block + 2 * DrawableBounds::BLOCK_SIZE);
+    __m128 edgeX = _mm_loadu_ps(block + 3 * DrawableBounds::BLOCK_SIZE);
+    __m128 edgeY = _mm_loadu_ps(block + 4 * DrawableBounds::BLOCK_SIZE);
+    __m128 edgeZ = _mm_loadu_ps(block + 5 * DrawableBounds::BLOCK_SIZE);
+    __m128 outside = _mm_setzero_ps();
+    
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = frustum.planes_[i];
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal_.x_), centerX),
+            _mm_mul_ps(_mm_set1_ps(plane.normal_.y_), centerY)), _mm_mul_ps(_mm_set1_ps(plane.normal_.z_), centerZ));
+        dist = _mm_add_ps(dist, _mm_set1_ps(plane.d_));
+        __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.absNormal_.x_), edgeX),
+            _mm_mul_ps(_mm_set1_ps(plane.absNormal_.y_), edgeY)), _mm_mul_ps(_mm_set1_ps(plane.absNormal_.z_), edgeZ));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(_mm_setzero_ps(), absDist)));
+        if (_mm_movemask_ps(outside) == 0xf)
+            return 0;
+    }
+    
+    return (unsigned)~_mm_movemask_ps(outside) & 0xf;
+    #else
+    unsigned mask = 0;
+    
+    for (unsigned j = 0; j < DrawableBounds::BLOCK_SIZE; ++j)
+    {
+        const float* lane = block + j;
+        Vector3 center(lane[0], lane[DrawableBounds::BLOCK_SIZE], lane[2 * DrawableBounds::BLOCK_SIZE]);
+        Vector3 edge(lane[3 * DrawableBounds::BLOCK_SIZE], lane[4 * DrawableBounds::BLOCK_SIZE], lane[5 * DrawableBounds::BLOCK_SIZE]);
+        bool outside = false;
+        
+        for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+        {
+            const Plane& plane = frustum.planes_[i];
+            float dist = plane.normal_.DotProduct(center) + plane.d_;
+            float absDist = plane.absNormal_.DotProduct(edge);
+            if (dist < -absDist)
+            {
+                outside = true;
+                break;
+            }
+        }
+        
+        if (!outside)
+            mask |= 1 << j;
+    }
+    
+    return mask;
+    #endif
+}
+
 Intersection PointOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -115,4 +177,48 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestPackedDrawables(Drawable** start, Drawable** end, const DrawableBounds& bounds, bool inside)
+{
+    if (inside)
+    {
+        TestDrawables(start, end, true);
+        return;
+    }
+    
+    // Test the bounding boxes a block at a time, touching only the drawables that pass. Those with dirty bounds need
+    // an exact test against their current bounding box
+    Drawable* passed[MAX_PASSED_DRAWABLES];
+    unsigned numPassed = 0;
+    unsigned numDrawables = (unsigned)(end - start);
+    
+    for (unsigned i = 0; i < numDrawables; i += DrawableBounds::BLOCK_SIZE)
+    {
+        unsigned mask = TestFrustumBlock(frustum_, bounds.GetBlock(i / DrawableBounds::BLOCK_SIZE));
+        if (numDrawables - i < DrawableBounds::BLOCK_SIZE)
+            mask &= (1 << (numDrawables - i)) - 1;
+        
+        for (unsigned j = 0; mask; ++j, mask >>= 1)
+        {
+            if (!(mask & 1))
+                continue;
+            
+            Drawable** drawable = start + i + j;
+            if (bounds.IsDirty(i + j))
+                TestDrawables(drawable, drawable + 1, false);
+            else
+            {
+                passed[numPassed++] = *drawable;
+                if (numPassed == MAX_PASSED_DRAWABLES)
+                {
+                    TestDrawables(passed, passed + numPassed, true);
+                    numPassed = 0;
+                }
+            }
+        }
+    }
+    
+    if (numPassed)
+        TestDrawables(passed, passed + numPassed, true);
+}
+
 }
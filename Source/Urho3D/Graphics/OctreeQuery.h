@@ -34,6 +34,103 @@ namespace Urho3D
 class Drawable;
 class Node;
 
+/// World bounding boxes of an octant's drawables, packed as center and half size in structure-of-arrays blocks of four.
+class URHO3D_API DrawableBounds
+{
+public:
+    /// Number of bounding boxes in one block.
+    static const unsigned BLOCK_SIZE = 4;
+    /// Number of floats in one block: center X, Y, Z and half size X, Y, Z for each box.
+    static const unsigned BLOCK_FLOATS = 6 * BLOCK_SIZE;
+    
+    /// Construct empty.
+    DrawableBounds() :
+        size_(0)
+    {
+    }
+    
+    /// Add a bounding box to the end.
+    void Push(const BoundingBox& box)
+    {
+        PushDirty();
+        Set(size_ - 1, box);
+    }
+    
+    /// Add a dirty entry to the end.
+    void PushDirty()
+    {
+        if (!(size_ & (BLOCK_SIZE - 1)))
+        {
+            unsigned oldSize = data_.Size();
+            data_.Resize(oldSize + BLOCK_FLOATS);
+            for (unsigned i = oldSize; i < data_.Size(); ++i)
+                data_[i] = 0.0f;
+        }
+        
+        SetDirty(size_++);
+    }
+    
+    /// Remove a bounding box by moving the last box into its place.
+    void Remove(unsigned index)
+    {
+        --size_;
+        if (index != size_)
+        {
+            const float* src = GetLane(size_);
+            float* dest = GetLane(index);
+            for (unsigned i = 0; i < BLOCK_FLOATS; i += BLOCK_SIZE)
+                dest[i] = src[i];
+        }
+        if (!(size_ & (BLOCK_SIZE - 1)))
+            data_.Resize(data_.Size() - BLOCK_FLOATS);
+    }
+    
+    /// Remove all bounding boxes.
+    void Clear()
+    {
+        data_.Clear();
+        size_ = 0;
+    }
+    
+    /// Set the bounding box at index.
+    void Set(unsigned index, const BoundingBox& box)
+    {
+        Vector3 center = box.Center();
+        Vector3 edge = center - box.min_;
+        float* lane = GetLane(index);
+        lane[0] = center.x_;
+        lane[BLOCK_SIZE] = center.y_;
+        lane[2 * BLOCK_SIZE] = center.z_;
+        lane[3 * BLOCK_SIZE] = edge.x_;
+        lane[4 * BLOCK_SIZE] = edge.y_;
+        lane[5 * BLOCK_SIZE] = edge.z_;
+    }
+    
+    /// Mark the bounding box at index dirty. A dirty box has infinite size so that it passes all culling tests, and should be tested exactly by other means.
+    void SetDirty(unsigned index)
+    {
+        float* lane = GetLane(index);
+        lane[0] = lane[BLOCK_SIZE] = lane[2 * BLOCK_SIZE] = 0.0f;
+        lane[3 * BLOCK_SIZE] = lane[4 * BLOCK_SIZE] = lane[5 * BLOCK_SIZE] = M_INFINITY;
+    }
+    
+    /// Return number of bounding boxes.
+    unsigned Size() const { return size_; }
+    /// Return whether the bounding box at index is dirty.
+    bool IsDirty(unsigned index) const { return data_[(index / BLOCK_SIZE) * BLOCK_FLOATS + 3 * BLOCK_SIZE + (index & (BLOCK_SIZE - 1))] == M_INFINITY; }
+    /// Return block data.
+    const float* GetBlock(unsigned blockIndex) const { return &data_[blockIndex * BLOCK_FLOATS]; }
+    
+private:
+    /// Return first float of the box at index.
+    float* GetLane(unsigned index) { return &data_[(index / BLOCK_SIZE) * BLOCK_FLOATS + (index & (BLOCK_SIZE - 1))]; }
+    
+    /// Bounding box data in blocks.
+    PODVector<float> data_;
+    /// Number of bounding boxes.
+    unsigned size_;
+};
+
 /// Base class for octree queries.
 class URHO3D_API OctreeQuery
 {
@@ -55,6 +152,11 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for drawables with their world bounding boxes packed by the octant. Default implementation tests the drawables one at a time.
+    virtual void TestPackedDrawables(Drawable** start, Drawable** end, const DrawableBounds& bounds, bool inside)
+    {
+        TestDrawables(start, end, inside);
+    }
 
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -149,6 +251,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Intersection test for drawables with packed world bounding boxes. Tests four boxes at once and calls TestDrawables() with inside flag set for those that pass.
+    virtual void TestPackedDrawables(Drawable** start, Drawable** end, const DrawableBounds& bounds, bool inside);
 
     /// Frustum.
     Frustum frustum_;
@@ -1451,7 +1451,7 @@ void Renderer::Initialize()
     shadersDirty_ = true;
     initialized_ = true;
     
-    SubscribeToEvent(E_RENDERUPDATE, HANDLER(Renderer, HandleRenderUpdate));
+    SubscribeToEvent(TYPED_HANDLER(Renderer, HandleRenderUpdate));
 
     LOGINFO("Initialized renderer");
 }
@@ -1734,11 +1734,9 @@ void Renderer::HandleScreenMode(StringHash eventType, VariantMap& eventData)
         resetViews_ = true;
 }
 
-void Renderer::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Renderer::HandleRenderUpdate(RenderUpdateEventData& eventData)
 {
-    using namespace RenderUpdate;
-    
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 }
@@ -50,6 +50,7 @@ class Texture2D;
 class TextureCube;
 class View;
 class Zone;
+struct RenderUpdateEventData;
 
 static const int SHADOW_MIN_PIXELS = 64;
 static const int INSTANCING_BUFFER_DEFAULT_SIZE = 1024;
@@ -358,7 +359,7 @@ private:
     /// Handle screen mode event.
     void HandleScreenMode(StringHash eventType, VariantMap& eventData);
     /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(RenderUpdateEventData& eventData);
     
     /// Graphics subsystem.
     WeakPtr<Graphics> graphics_;
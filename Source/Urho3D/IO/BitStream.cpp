@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/BitStream.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Serializer.h"
+
+#include <cstring>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Range of the three smallest components of a normalized quaternion.
+static const float SMALLEST_THREE_RANGE = 0.707107f;
+
+static unsigned GetMaxQuantizedValue(unsigned numBits)
+{
+    return numBits < 32 ? (1U << numBits) - 1 : M_MAX_UNSIGNED;
+}
+
+unsigned short FloatToHalf(float value)
+{
+    unsigned bits;
+    memcpy(&bits, &value, sizeof bits);
+    
+    unsigned sign = (bits >> 16) & 0x8000;
+    unsigned floatExponent = (bits >> 23) & 0xff;
+    unsigned mantissa = bits & 0x7fffff;
+    int exponent = (int)floatExponent - 127 + 15;
+    
+    // Infinity and NaN
+    if (floatExponent == 0xff)
+        return (unsigned short)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    // Overflow to infinity
+    if (exponent >= 31)
+        return (unsigned short)(sign | 0x7c00);
+    // Denormalized half float, or underflow to zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return (unsigned short)sign;
+        mantissa |= 0x800000;
+        unsigned shift = (unsigned)(14 - exponent);
+        unsigned half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            ++half;
+        return (unsigned short)(sign | half);
+    }
+    
+    // Rounding may carry into the exponent, which gives the correct result
+    unsigned half = sign | ((unsigned)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        ++half;
+    return (unsigned short)half;
+}
+
+float HalfToFloat(unsigned short value)
+{
+    unsigned sign = (unsigned)(value & 0x8000) << 16;
+    unsigned exponent = (value >> 10) & 0x1f;
+    unsigned mantissa = value & 0x3ff;
+    unsigned bits;
+    
+    if (!exponent)
+    {
+        if (!mantissa)
+            bits = sign;
+        else
+        {
+            // Normalize a denormalized half float
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else if (exponent == 31)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    
+    float ret;
+    memcpy(&ret, &bits, sizeof ret);
+    return ret;
+}
+
+BitWriter::BitWriter(Serializer& dest) :
+    dest_(&dest),
+    buffer_(0),
+    bufferBits_(0),
+    numBits_(0)
+{
+}
+
+BitWriter::~BitWriter()
+{
+    Flush();
+}
+
+void BitWriter::WriteBits(unsigned value, unsigned numBits)
+{
+    if (!numBits)
+        return;
+    
+    buffer_ |= (unsigned long long)(value & GetMaxQuantizedValue(numBits)) << bufferBits_;
+    bufferBits_ += numBits;
+    numBits_ += numBits;
+    
+    while (bufferBits_ >= 8)
+    {
+        dest_->WriteUByte((unsigned char)buffer_);
+        buffer_ >>= 8;
+        bufferBits_ -= 8;
+    }
+}
+
+void BitWriter::WriteBool(bool value)
+{
+    WriteBits(value ? 1 : 0, 1);
+}
+
+void BitWriter::WriteQuantizedFloat(float value, float min, float max, unsigned numBits)
+{
+    if (max <= min)
+    {
+        WriteBits(0, numBits);
+        return;
+    }
+    
+    // Use double precision so that 32-bit quantization does not overflow
+    double t = ((double)Clamp(value, min, max) - min) / ((double)max - min);
+    WriteBits((unsigned)(t * GetMaxQuantizedValue(numBits) + 0.5), numBits);
+}
+
+void BitWriter::WriteHalfFloat(float value)
+{
+    WriteBits(FloatToHalf(value), 16);
+}
+
+void BitWriter::WriteSmallestThreeQuaternion(const Quaternion& value, unsigned componentBits)
+{
+    Quaternion normalized = value.Normalized();
+    float components[4] = { normalized.w_, normalized.x_, normalized.y_, normalized.z_ };
+    
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+    
+    // q and -q are the same rotation, so flip the sign to make the largest component positive and leave it out
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    WriteBits(largest, 2);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+            WriteQuantizedFloat(components[i] * sign, -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, componentBits);
+    }
+}
+
+void BitWriter::Flush()
+{
+    if (bufferBits_)
+    {
+        dest_->WriteUByte((unsigned char)buffer_);
+        buffer_ = 0;
+        bufferBits_ = 0;
+    }
+}
+
+BitReader::BitReader(Deserializer& source) :
+    source_(&source),
+    buffer_(0),
+    bufferBits_(0)
+{
+}
+
+unsigned BitReader::ReadBits(unsigned numBits)
+{
+    if (!numBits)
+        return 0;
+    
+    while (bufferBits_ < numBits)
+    {
+        buffer_ |= (unsigned long long)source_->ReadUByte() << bufferBits_;
+        bufferBits_ += 8;
+    }
+    
+    unsigned ret = (unsigned)buffer_ & GetMaxQuantizedValue(numBits);
+    buffer_ >>= numBits;
+    bufferBits_ -= numBits;
+    return ret;
+}
+
+bool BitReader::ReadBool()
+{
+    return ReadBits(1) != 0;
+}
+
+float BitReader::ReadQuantizedFloat(float min, float max, unsigned numBits)
+{
+    unsigned value = ReadBits(numBits);
+    if (max <= min)
+        return min;
+    
+    return (float)(min + ((double)max - min) * value / GetMaxQuantizedValue(numBits));
+}
+
+float BitReader::ReadHalfFloat()
+{
+    return HalfToFloat((unsigned short)ReadBits(16));
+}
+
+Quaternion BitReader::ReadSmallestThreeQuaternion(unsigned componentBits)
+{
+    unsigned largest = ReadBits(2);
+    float components[4];
+    float sumSquared = 0.0f;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            components[i] = ReadQuantizedFloat(-SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE, componentBits);
+            sumSquared += components[i] * components[i];
+        }
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquared, 0.0f));
+    
+    return Quaternion(components[0], components[1], components[2], components[3]).Normalized();
+}
+
+}
@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Math/Quaternion.h"
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+
+/// Writer for packing values into a stream at bit granularity. Bits are written least significant first and the last byte is padded with zero bits on Flush().
+class URHO3D_API BitWriter
+{
+public:
+    /// Construct with destination stream.
+    BitWriter(Serializer& dest);
+    /// Destruct. Flush pending bits.
+    ~BitWriter();
+    
+    /// Write up to 32 bits of an unsigned value.
+    void WriteBits(unsigned value, unsigned numBits);
+    /// Write a bool as one bit.
+    void WriteBool(bool value);
+    /// Write a float quantized to a range with the given amount of bits. Values outside the range are clamped.
+    void WriteQuantizedFloat(float value, float min, float max, unsigned numBits);
+    /// Write a float as a 16-bit half float.
+    void WriteHalfFloat(float value);
+    /// Write a normalized quaternion as its three smallest components, quantized with the given amount of bits each, and the index of the largest component.
+    void WriteSmallestThreeQuaternion(const Quaternion& value, unsigned componentBits);
+    /// Write pending bits to the stream, padding to a byte boundary.
+    void Flush();
+    
+    /// Return number of bits written, including bits already flushed.
+    unsigned GetNumBits() const { return numBits_; }
+    
+private:
+    /// Destination stream.
+    Serializer* dest_;
+    /// Bits not yet written to the stream.
+    unsigned long long buffer_;
+    /// Number of bits in the buffer.
+    unsigned bufferBits_;
+    /// Total number of bits written.
+    unsigned numBits_;
+};
+
+/// Reader for values packed with BitWriter. Reads from the source stream only the bytes that are needed, so after reading the same values that were written, the stream is positioned after the padded last byte.
+class URHO3D_API BitReader
+{
+public:
+    /// Construct with source stream.
+    BitReader(Deserializer& source);
+    
+    /// Read up to 32 bits of an unsigned value.
+    unsigned ReadBits(unsigned numBits);
+    /// Read a bool from one bit.
+    bool ReadBool();
+    /// Read a float quantized to a range with the given amount of bits.
+    float ReadQuantizedFloat(float min, float max, unsigned numBits);
+    /// Read a 16-bit half float.
+    float ReadHalfFloat();
+    /// Read a quaternion written as its three smallest components.
+    Quaternion ReadSmallestThreeQuaternion(unsigned componentBits);
+    
+private:
+    /// Source stream.
+    Deserializer* source_;
+    /// Bits read from the stream but not yet consumed.
+    unsigned long long buffer_;
+    /// Number of bits in the buffer.
+    unsigned bufferBits_;
+};
+
+/// Convert a float to a 16-bit half float, rounding to nearest.
+URHO3D_API unsigned short FloatToHalf(float value);
+/// Convert a 16-bit half float to a float.
+URHO3D_API float HalfToFloat(unsigned short value);
+
+}
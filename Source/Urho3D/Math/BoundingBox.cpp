@@ -126,6 +126,39 @@ BoundingBox BoundingBox::Transformed(const Matrix3& transform) const
 
 BoundingBox BoundingBox::Transformed(const Matrix3x4& transform) const
 {
+    #ifdef URHO3D_SSE
+    __m128 minPt = _mm_set_ps(1.0f, min_.z_, min_.y_, min_.x_);
+    __m128 maxPt = _mm_set_ps(1.0f, max_.z_, max_.y_, max_.x_);
+    // The center has w = 1 to apply the translation, while the edge has w = 0
+    __m128 center = _mm_mul_ps(_mm_add_ps(minPt, maxPt), _mm_set1_ps(0.5f));
+    __m128 edge = _mm_sub_ps(center, minPt);
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 zero = _mm_setzero_ps();
+    __m128 m0 = _mm_loadu_ps(&transform.m00_);
+    __m128 m1 = _mm_loadu_ps(&transform.m10_);
+    __m128 m2 = _mm_loadu_ps(&transform.m20_);
+    
+    // Transpose and add to get the sums of the rows into the lanes
+    __m128 r0 = _mm_mul_ps(m0, center);
+    __m128 r1 = _mm_mul_ps(m1, center);
+    __m128 r2 = _mm_mul_ps(m2, center);
+    __m128 t0 = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+    __m128 t2 = _mm_add_ps(_mm_unpacklo_ps(r2, zero), _mm_unpackhi_ps(r2, zero));
+    __m128 newCenter = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+    
+    r0 = _mm_mul_ps(_mm_and_ps(m0, absMask), edge);
+    r1 = _mm_mul_ps(_mm_and_ps(m1, absMask), edge);
+    r2 = _mm_mul_ps(_mm_and_ps(m2, absMask), edge);
+    t0 = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+    t2 = _mm_add_ps(_mm_unpacklo_ps(r2, zero), _mm_unpackhi_ps(r2, zero));
+    __m128 newEdge = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+    
+    BoundingBox ret;
+    _mm_storeu_ps(&ret.min_.x_, _mm_sub_ps(newCenter, newEdge));
+    _mm_storeu_ps(&ret.max_.x_, _mm_add_ps(newCenter, newEdge));
+    ret.defined_ = true;
+    return ret;
+    #else
     Vector3 newCenter = transform * Center();
     Vector3 oldEdge = Size() * 0.5f;
     Vector3 newEdge = Vector3(
@@ -135,6 +168,7 @@ BoundingBox BoundingBox::Transformed(const Matrix3x4& transform) const
     );
     
     return BoundingBox(newCenter - newEdge, newCenter + newEdge);
+    #endif
 }
 
 Rect BoundingBox::Projected(const Matrix4& projection) const
@@ -25,6 +25,10 @@
 #include "../Math/Rect.h"
 #include "../Math/Vector3.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -200,7 +204,12 @@ public:
             defined_ = true;
             return;
         }
-    
+        
+        #ifdef URHO3D_SSE
+        // The padding after the vectors allows to load and store them as whole SSE registers
+        _mm_storeu_ps(&min_.x_, _mm_min_ps(_mm_loadu_ps(&min_.x_), _mm_loadu_ps(&box.min_.x_)));
+        _mm_storeu_ps(&max_.x_, _mm_max_ps(_mm_loadu_ps(&max_.x_), _mm_loadu_ps(&box.max_.x_)));
+        #else
         if (box.min_.x_ < min_.x_)
             min_.x_ = box.min_.x_;
         if (box.min_.y_ < min_.y_)
@@ -213,6 +222,7 @@ public:
             max_.y_ = box.max_.y_;
         if (box.max_.z_ > max_.z_)
             max_.z_ = box.max_.z_;
+        #endif
     }
     
     /// Define from an array of vertices.
@@ -303,8 +313,16 @@ public:
     
     /// Minimum vector.
     Vector3 min_;
+    #ifdef URHO3D_SSE
+    /// Padding for SSE loads and stores of the minimum vector.
+    float dummyMin_;
+    #endif
     /// Maximum vector.
     Vector3 max_;
+    #ifdef URHO3D_SSE
+    /// Padding for SSE loads and stores of the maximum vector.
+    float dummyMax_;
+    #endif
     /// Defined flag.
     bool defined_;
 };
@@ -113,15 +113,27 @@ public:
     /// Test if a bounding box is inside, outside or intersects.
     Intersection IsInside(const BoundingBox& box) const
     {
+        #ifdef URHO3D_SSE
+        __m128 minPt = _mm_set_ps(0.0f, box.min_.z_, box.min_.y_, box.min_.x_);
+        __m128 maxPt = _mm_set_ps(0.0f, box.max_.z_, box.max_.y_, box.max_.x_);
+        __m128 center = _mm_mul_ps(_mm_add_ps(minPt, maxPt), _mm_set1_ps(0.5f));
+        __m128 edge = _mm_sub_ps(center, minPt);
+        #else
         Vector3 center = box.Center();
         Vector3 edge = center - box.min_;
+        #endif
         bool allInside = true;
         
         for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
         {
             const Plane& plane = planes_[i];
+            #ifdef URHO3D_SSE
+            float dist, absDist;
+            PlaneDistancesSSE(plane, center, edge, dist, absDist);
+            #else
             float dist = plane.normal_.DotProduct(center) + plane.d_;
             float absDist = plane.absNormal_.DotProduct(edge);
+            #endif
             
             if (dist < -absDist)
                 return OUTSIDE;
@@ -135,14 +147,26 @@ public:
     /// Test if a bounding box is (partially) inside or outside.
     Intersection IsInsideFast(const BoundingBox& box) const
     {
+        #ifdef URHO3D_SSE
+        __m128 minPt = _mm_set_ps(0.0f, box.min_.z_, box.min_.y_, box.min_.x_);
+        __m128 maxPt = _mm_set_ps(0.0f, box.max_.z_, box.max_.y_, box.max_.x_);
+        __m128 center = _mm_mul_ps(_mm_add_ps(minPt, maxPt), _mm_set1_ps(0.5f));
+        __m128 edge = _mm_sub_ps(center, minPt);
+        #else
         Vector3 center = box.Center();
         Vector3 edge = center - box.min_;
+        #endif
         
         for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
         {
             const Plane& plane = planes_[i];
+            #ifdef URHO3D_SSE
+            float dist, absDist;
+            PlaneDistancesSSE(plane, center, edge, dist, absDist);
+            #else
             float dist = plane.normal_.DotProduct(center) + plane.d_;
             float absDist = plane.absNormal_.DotProduct(edge);
+            #endif
             
             if (dist < -absDist)
                 return OUTSIDE;
@@ -171,6 +195,21 @@ public:
     /// Update the planes. Called internally.
     void UpdatePlanes();
     
+    #ifdef URHO3D_SSE
+    /// Return the signed distance of a box center and the projected half-size of a box edge for a plane. The vectors have w = 0.
+    static void PlaneDistancesSSE(const Plane& plane, __m128 center, __m128 edge, float& dist, float& absDist)
+    {
+        // The normal is followed by the absolute normal and the absolute normal by the plane constant, so both can be loaded
+        // as whole registers. The fourth lanes become zero from the multiply
+        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&plane.normal_.x_), center);
+        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&plane.absNormal_.x_), edge);
+        __m128 t = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+        t = _mm_add_ps(t, _mm_movehl_ps(t, t));
+        dist = _mm_cvtss_f32(t) + plane.d_;
+        absDist = _mm_cvtss_f32(_mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)));
+    }
+    #endif
+    
     /// Frustum planes.
     Plane planes_[NUM_FRUSTUM_PLANES];
     /// Frustum vertices.
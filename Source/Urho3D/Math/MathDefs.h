@@ -27,6 +27,14 @@
 #include <cstdlib>
 #include <cmath>
 
+// Use constexpr where supported, to allow evaluation at compile time
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define URHO3D_HAS_CONSTEXPR
+#define URHO3D_CONSTEXPR constexpr
+#else
+#define URHO3D_CONSTEXPR
+#endif
+
 namespace Urho3D
 {
 
@@ -162,7 +170,7 @@ inline unsigned CountSetBits(unsigned value)
 }
 
 /// Update a hash with the given 8-bit value using the SDBM algorithm.
-inline unsigned SDBMHash(unsigned hash, unsigned char c) { return c + (hash << 6) + (hash << 16) - hash; }
+inline URHO3D_CONSTEXPR unsigned SDBMHash(unsigned hash, unsigned char c) { return c + (hash << 6) + (hash << 16) - hash; }
 /// Return a random float between 0.0 (inclusive) and 1.0 (exclusive.)
 inline float Random() { return Rand() / 32768.0f; }
 /// Return a random float between 0.0 and range, inclusive from both ends.
@@ -215,11 +215,30 @@ public:
     /// Multiply a Vector3 which is assumed to represent position.
     Vector3 operator * (const Vector3& rhs) const
     {
+        #ifdef URHO3D_SSE
+        __m128 vec = _mm_set_ps(1.0f, rhs.z_, rhs.y_, rhs.x_);
+        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00_), vec);
+        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10_), vec);
+        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20_), vec);
+        __m128 zero = _mm_setzero_ps();
+        
+        // Transpose and add to get the sums of the rows into the lanes
+        __m128 t0 = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+        __m128 t2 = _mm_add_ps(_mm_unpacklo_ps(r2, zero), _mm_unpackhi_ps(r2, zero));
+        vec = _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+        
+        return Vector3(
+            _mm_cvtss_f32(vec),
+            _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
+            _mm_cvtss_f32(_mm_movehl_ps(vec, vec))
+        );
+        #else
         return Vector3(
             (m00_ * rhs.x_ + m01_ * rhs.y_ + m02_ * rhs.z_ + m03_),
             (m10_ * rhs.x_ + m11_ * rhs.y_ + m12_ * rhs.z_ + m13_),
             (m20_ * rhs.x_ + m21_ * rhs.y_ + m22_ * rhs.z_ + m23_)
         );
+        #endif
     }
     
     /// Multiply a Vector4.
@@ -292,6 +311,18 @@ public:
     /// Multiply a matrix.
     Matrix3x4 operator * (const Matrix3x4& rhs) const
     {
+        #ifdef URHO3D_SSE
+        __m128 r0 = _mm_loadu_ps(&rhs.m00_);
+        __m128 r1 = _mm_loadu_ps(&rhs.m10_);
+        __m128 r2 = _mm_loadu_ps(&rhs.m20_);
+        __m128 r3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+        
+        Matrix3x4 out;
+        _mm_storeu_ps(&out.m00_, Matrix4::MultiplyRowSSE(_mm_loadu_ps(&m00_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m10_, Matrix4::MultiplyRowSSE(_mm_loadu_ps(&m10_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m20_, Matrix4::MultiplyRowSSE(_mm_loadu_ps(&m20_), r0, r1, r2, r3));
+        return out;
+        #else
         return Matrix3x4(
             m00_ * rhs.m00_ + m01_ * rhs.m10_ + m02_ * rhs.m20_,
             m00_ * rhs.m01_ + m01_ * rhs.m11_ + m02_ * rhs.m21_,
@@ -306,11 +337,25 @@ public:
             m20_ * rhs.m02_ + m21_ * rhs.m12_ + m22_ * rhs.m22_,
             m20_ * rhs.m03_ + m21_ * rhs.m13_ + m22_ * rhs.m23_ + m23_
         );
+        #endif
     }
     
     /// Multiply a 4x4 matrix.
     Matrix4 operator * (const Matrix4& rhs) const
     {
+        #ifdef URHO3D_SSE
+        __m128 r0 = _mm_loadu_ps(&rhs.m00_);
+        __m128 r1 = _mm_loadu_ps(&rhs.m10_);
+        __m128 r2 = _mm_loadu_ps(&rhs.m20_);
+        __m128 r3 = _mm_loadu_ps(&rhs.m30_);
+        
+        Matrix4 out;
+        _mm_storeu_ps(&out.m00_, Matrix4::MultiplyRowSSE(_mm_loadu_ps(&m00_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m10_, Matrix4::MultiplyRowSSE(_mm_loadu_ps(&m10_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m20_, Matrix4::MultiplyRowSSE(_mm_loadu_ps(&m20_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m30_, r3);
+        return out;
+        #else
         return Matrix4(
             m00_ * rhs.m00_ + m01_ * rhs.m10_ + m02_ * rhs.m20_ + m03_ * rhs.m30_,
             m00_ * rhs.m01_ + m01_ * rhs.m11_ + m02_ * rhs.m21_ + m03_ * rhs.m31_,
@@ -329,6 +374,7 @@ public:
             rhs.m32_,
             rhs.m33_
         );
+        #endif
     }
     
     /// Set translation elements.
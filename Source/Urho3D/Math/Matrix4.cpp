@@ -40,6 +40,19 @@ const Matrix4 Matrix4::IDENTITY;
 
 Matrix4 Matrix4::operator * (const Matrix3x4& rhs) const
 {
+    #ifdef URHO3D_SSE
+    __m128 r0 = _mm_loadu_ps(&rhs.m00_);
+    __m128 r1 = _mm_loadu_ps(&rhs.m10_);
+    __m128 r2 = _mm_loadu_ps(&rhs.m20_);
+    __m128 r3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    
+    Matrix4 out;
+    _mm_storeu_ps(&out.m00_, MultiplyRowSSE(_mm_loadu_ps(&m00_), r0, r1, r2, r3));
+    _mm_storeu_ps(&out.m10_, MultiplyRowSSE(_mm_loadu_ps(&m10_), r0, r1, r2, r3));
+    _mm_storeu_ps(&out.m20_, MultiplyRowSSE(_mm_loadu_ps(&m20_), r0, r1, r2, r3));
+    _mm_storeu_ps(&out.m30_, MultiplyRowSSE(_mm_loadu_ps(&m30_), r0, r1, r2, r3));
+    return out;
+    #else
     return Matrix4(
         m00_ * rhs.m00_ + m01_ * rhs.m10_ + m02_ * rhs.m20_,
         m00_ * rhs.m01_ + m01_ * rhs.m11_ + m02_ * rhs.m21_,
@@ -58,6 +71,7 @@ Matrix4 Matrix4::operator * (const Matrix3x4& rhs) const
         m30_ * rhs.m02_ + m31_ * rhs.m12_ + m32_ * rhs.m22_,
         m30_ * rhs.m03_ + m31_ * rhs.m13_ + m32_ * rhs.m23_ + m33_
     );
+    #endif
 }
 
 void Matrix4::Decompose(Vector3& translation, Quaternion& rotation, Vector3& scale) const
@@ -25,6 +25,10 @@
 #include "../Math/Quaternion.h"
 #include "../Math/Vector4.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -207,6 +211,16 @@ public:
     /// Multiply a Vector3 which is assumed to represent position.
     Vector3 operator * (const Vector3& rhs) const
     {
+        #ifdef URHO3D_SSE
+        __m128 vec = TransformSSE(_mm_set_ps(1.0f, rhs.z_, rhs.y_, rhs.x_));
+        vec = _mm_div_ps(vec, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(3, 3, 3, 3)));
+        
+        return Vector3(
+            _mm_cvtss_f32(vec),
+            _mm_cvtss_f32(_mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1))),
+            _mm_cvtss_f32(_mm_movehl_ps(vec, vec))
+        );
+        #else
         float invW = 1.0f / (m30_ * rhs.x_ + m31_ * rhs.y_ + m32_ * rhs.z_ + m33_);
         
         return Vector3(
@@ -214,17 +228,24 @@ public:
             (m10_ * rhs.x_ + m11_ * rhs.y_ + m12_ * rhs.z_ + m13_) * invW,
             (m20_ * rhs.x_ + m21_ * rhs.y_ + m22_ * rhs.z_ + m23_) * invW
         );
+        #endif
     }
     
     /// Multiply a Vector4.
     Vector4 operator * (const Vector4& rhs) const
     {
+        #ifdef URHO3D_SSE
+        Vector4 ret;
+        _mm_storeu_ps(&ret.x_, TransformSSE(_mm_loadu_ps(&rhs.x_)));
+        return ret;
+        #else
         return Vector4(
             m00_ * rhs.x_ + m01_ * rhs.y_ + m02_ * rhs.z_ + m03_ * rhs.w_,
             m10_ * rhs.x_ + m11_ * rhs.y_ + m12_ * rhs.z_ + m13_ * rhs.w_,
             m20_ * rhs.x_ + m21_ * rhs.y_ + m22_ * rhs.z_ + m23_ * rhs.w_,
             m30_ * rhs.x_ + m31_ * rhs.y_ + m32_ * rhs.z_ + m33_ * rhs.w_
         );
+        #endif
     }
     
     /// Add a matrix.
@@ -299,6 +320,19 @@ public:
     /// Multiply a matrix.
     Matrix4 operator * (const Matrix4& rhs) const
     {
+        #ifdef URHO3D_SSE
+        __m128 r0 = _mm_loadu_ps(&rhs.m00_);
+        __m128 r1 = _mm_loadu_ps(&rhs.m10_);
+        __m128 r2 = _mm_loadu_ps(&rhs.m20_);
+        __m128 r3 = _mm_loadu_ps(&rhs.m30_);
+        
+        Matrix4 out;
+        _mm_storeu_ps(&out.m00_, MultiplyRowSSE(_mm_loadu_ps(&m00_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m10_, MultiplyRowSSE(_mm_loadu_ps(&m10_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m20_, MultiplyRowSSE(_mm_loadu_ps(&m20_), r0, r1, r2, r3));
+        _mm_storeu_ps(&out.m30_, MultiplyRowSSE(_mm_loadu_ps(&m30_), r0, r1, r2, r3));
+        return out;
+        #else
         return Matrix4(
             m00_ * rhs.m00_ + m01_ * rhs.m10_ + m02_ * rhs.m20_ + m03_ * rhs.m30_,
             m00_ * rhs.m01_ + m01_ * rhs.m11_ + m02_ * rhs.m21_ + m03_ * rhs.m31_,
@@ -317,6 +351,7 @@ public:
             m30_ * rhs.m02_ + m31_ * rhs.m12_ + m32_ * rhs.m22_ + m33_ * rhs.m32_,
             m30_ * rhs.m03_ + m31_ * rhs.m13_ + m32_ * rhs.m23_ + m33_ * rhs.m33_
         );
+        #endif
     }
     
     /// Multiply with a 3x4 matrix.
@@ -414,6 +449,20 @@ public:
     /// Return transpose
     Matrix4 Transpose() const
     {
+        #ifdef URHO3D_SSE
+        __m128 m0 = _mm_loadu_ps(&m00_);
+        __m128 m1 = _mm_loadu_ps(&m10_);
+        __m128 m2 = _mm_loadu_ps(&m20_);
+        __m128 m3 = _mm_loadu_ps(&m30_);
+        _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+        
+        Matrix4 out;
+        _mm_storeu_ps(&out.m00_, m0);
+        _mm_storeu_ps(&out.m10_, m1);
+        _mm_storeu_ps(&out.m20_, m2);
+        _mm_storeu_ps(&out.m30_, m3);
+        return out;
+        #else
         return Matrix4(
             m00_,
             m10_,
@@ -432,6 +481,7 @@ public:
             m23_,
             m33_
         );
+        #endif
     }
     
     /// Test for equality with another matrix with epsilon.
@@ -503,6 +553,32 @@ public:
         }
     }
     
+    #ifdef URHO3D_SSE
+    /// Multiply a vector held in an SSE register.
+    __m128 TransformSSE(__m128 vec) const
+    {
+        __m128 r0 = _mm_mul_ps(_mm_loadu_ps(&m00_), vec);
+        __m128 r1 = _mm_mul_ps(_mm_loadu_ps(&m10_), vec);
+        __m128 r2 = _mm_mul_ps(_mm_loadu_ps(&m20_), vec);
+        __m128 r3 = _mm_mul_ps(_mm_loadu_ps(&m30_), vec);
+        
+        // Transpose and add to get the sums of the rows into the lanes
+        __m128 t0 = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+        __m128 t2 = _mm_add_ps(_mm_unpacklo_ps(r2, r3), _mm_unpackhi_ps(r2, r3));
+        return _mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0));
+    }
+    
+    /// Multiply a matrix row held in an SSE register by the rows of another matrix.
+    static __m128 MultiplyRowSSE(__m128 row, __m128 r0, __m128 r1, __m128 r2, __m128 r3)
+    {
+        __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+        __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), r1);
+        __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), r2);
+        __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), r3);
+        return _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3));
+    }
+    #endif
+    
     /// Zero matrix.
     static const Matrix4 ZERO;
     /// Identity matrix.
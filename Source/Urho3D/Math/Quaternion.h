@@ -24,6 +24,10 @@
 
 #include "../Math/Matrix3.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -149,12 +153,29 @@ public:
     /// Multiply a quaternion.
     Quaternion operator * (const Quaternion& rhs) const
     {
+        #ifdef URHO3D_SSE
+        // Lanes are in w, x, y, z order. Each element of this quaternion multiplies a shuffled and sign-flipped rhs
+        __m128 q1 = _mm_loadu_ps(&w_);
+        __m128 q2 = _mm_loadu_ps(&rhs.w_);
+        __m128 out = _mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(0, 0, 0, 0)), q2);
+        out = _mm_add_ps(out, _mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(1, 1, 1, 1)),
+            _mm_xor_ps(_mm_shuffle_ps(q2, q2, _MM_SHUFFLE(2, 3, 0, 1)), _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f))));
+        out = _mm_add_ps(out, _mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(2, 2, 2, 2)),
+            _mm_xor_ps(_mm_shuffle_ps(q2, q2, _MM_SHUFFLE(1, 0, 3, 2)), _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f))));
+        out = _mm_add_ps(out, _mm_mul_ps(_mm_shuffle_ps(q1, q1, _MM_SHUFFLE(3, 3, 3, 3)),
+            _mm_xor_ps(_mm_shuffle_ps(q2, q2, _MM_SHUFFLE(0, 1, 2, 3)), _mm_set_ps(0.0f, 0.0f, -0.0f, -0.0f))));
+        
+        Quaternion ret;
+        _mm_storeu_ps(&ret.w_, out);
+        return ret;
+        #else
         return Quaternion(
             w_ * rhs.w_ - x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_,
             w_ * rhs.x_ + x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_,
             w_ * rhs.y_ + y_ * rhs.w_ + z_ * rhs.x_ - x_ * rhs.z_,
             w_ * rhs.z_ + z_ * rhs.w_ + x_ * rhs.y_ - y_ * rhs.x_
         );
+        #endif
     }
     
     /// Multiply a Vector3.
@@ -183,6 +204,15 @@ public:
     /// Normalize to unit length.
     void Normalize()
     {
+        #ifdef URHO3D_SSE
+        __m128 q = _mm_loadu_ps(&w_);
+        __m128 n = _mm_mul_ps(q, q);
+        n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 3, 0, 1)));
+        n = _mm_add_ps(n, _mm_shuffle_ps(n, n, _MM_SHUFFLE(0, 1, 2, 3)));
+        float lenSquared = _mm_cvtss_f32(n);
+        if (!Urho3D::Equals(lenSquared, 1.0f) && lenSquared > 0.0f)
+            _mm_storeu_ps(&w_, _mm_div_ps(q, _mm_sqrt_ps(n)));
+        #else
         float lenSquared = LengthSquared();
         if (!Urho3D::Equals(lenSquared, 1.0f) && lenSquared > 0.0f)
         {
@@ -192,6 +222,7 @@ public:
             y_ *= invLen;
             z_ *= invLen;
         }
+        #endif
     }
     
     /// Return normalized to unit length.
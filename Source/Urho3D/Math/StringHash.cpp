@@ -22,6 +22,11 @@
 
 #include "../Math/MathDefs.h"
 #include "../Math/StringHash.h"
+#ifdef URHO3D_HASH_DEBUG
+#include "../Container/HashMap.h"
+#include "../Core/Mutex.h"
+#include "../Core/ProcessUtils.h"
+#endif
 
 #include <cstdio>
 
@@ -32,17 +37,7 @@ namespace Urho3D
 
 const StringHash StringHash::ZERO;
 
-StringHash::StringHash(const char* str) :
-    value_(Calculate(str))
-{
-}
-
-StringHash::StringHash(const String& str) :
-    value_(Calculate(str.CString()))
-{
-}
-
-unsigned StringHash::Calculate(const char* str)
+static unsigned CalculateHash(const char* str)
 {
     unsigned hash = 0;
     
@@ -52,14 +47,88 @@ unsigned StringHash::Calculate(const char* str)
     while (*str)
     {
         // Perform the actual hashing as case-insensitive
-        char c = *str;
-        hash = SDBMHash(hash, tolower(c));
+        hash = SDBMHash(hash, StringHash::ToLower(*str));
         ++str;
     }
     
     return hash;
 }
 
+#ifdef URHO3D_HASH_DEBUG
+/// Return the mutex for the reverse lookup registry. Hashes may be constructed in static initialization and in worker threads.
+static Mutex& GetRegistryMutex()
+{
+    static Mutex mutex;
+    return mutex;
+}
+
+/// Return the reverse lookup registry.
+static HashMap<unsigned, String>& GetRegistry()
+{
+    static HashMap<unsigned, String> registry;
+    return registry;
+}
+
+/// Register a hashed string for reverse lookup and report a collision with a different string.
+static unsigned RegisterHash(unsigned hash, const char* str)
+{
+    if (!str || !*str)
+        return hash;
+    
+    MutexLock lock(GetRegistryMutex());
+    HashMap<unsigned, String>& registry = GetRegistry();
+    HashMap<unsigned, String>::Iterator i = registry.Find(hash);
+    if (i == registry.End())
+        registry[hash] = str;
+    else if (i->second_.Compare(str, false))
+    {
+        // The log may not exist yet during static initialization, so print directly
+        PrintLine("StringHash collision: \"" + i->second_ + "\" and \"" + String(str) + "\" both hash to " +
+            StringHash(hash).ToString(), true);
+    }
+    
+    return hash;
+}
+
+StringHash::StringHash(const char* str) :
+    value_(RegisterHash(CalculateHash(str), str))
+{
+}
+
+StringHash::StringHash(const String& str) :
+    value_(RegisterHash(CalculateHash(str.CString()), str.CString()))
+{
+}
+
+String StringHash::Reverse() const
+{
+    MutexLock lock(GetRegistryMutex());
+    HashMap<unsigned, String>& registry = GetRegistry();
+    HashMap<unsigned, String>::ConstIterator i = registry.Find(value_);
+    return i != registry.End() ? i->second_ : String::EMPTY;
+}
+#else
+StringHash::StringHash(const char* str) :
+    value_(CalculateHash(str))
+{
+}
+
+StringHash::StringHash(const String& str) :
+    value_(CalculateHash(str.CString()))
+{
+}
+
+String StringHash::Reverse() const
+{
+    return String::EMPTY;
+}
+#endif
+
+unsigned StringHash::Calculate(const char* str)
+{
+    return CalculateHash(str);
+}
+
 String StringHash::ToString() const
 {
     char tempBuffer[CONVERSION_BUFFER_LENGTH];
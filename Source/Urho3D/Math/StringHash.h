@@ -23,6 +23,17 @@
 #pragma once
 
 #include "../Container/Str.h"
+#include "../Math/MathDefs.h"
+
+// Hash string literals at compile time where supported. Registering the strings for reverse lookup needs the hashing to happen at runtime
+#if defined(URHO3D_HAS_CONSTEXPR) && !defined(URHO3D_HASH_DEBUG)
+#define URHO3D_CONSTEXPR_HASH
+/// Construct a StringHash from a string literal, hashed at compile time.
+#define URHO3D_HASH_LITERAL(str) Urho3D::StringHash(Urho3D::StringHash::CalculateLiteral(str))
+#else
+/// Construct a StringHash from a string literal.
+#define URHO3D_HASH_LITERAL(str) Urho3D::StringHash(str)
+#endif
 
 namespace Urho3D
 {
@@ -32,19 +43,19 @@ class URHO3D_API StringHash
 {
 public:
     /// Construct with zero value.
-    StringHash() :
+    URHO3D_CONSTEXPR StringHash() :
         value_(0)
     {
     }
     
     /// Copy-construct from another hash.
-    StringHash(const StringHash& rhs) :
+    URHO3D_CONSTEXPR StringHash(const StringHash& rhs) :
         value_(rhs.value_)
     {
     }
     
     /// Construct with an initial value.
-    explicit StringHash(unsigned value) :
+    URHO3D_CONSTEXPR explicit StringHash(unsigned value) :
         value_(value)
     {
     }
@@ -87,14 +98,25 @@ public:
     /// Return true if nonzero hash value.
     operator bool () const { return value_ != 0; }
     /// Return hash value.
-    unsigned Value() const { return value_; }
+    URHO3D_CONSTEXPR unsigned Value() const { return value_; }
     /// Return as string.
     String ToString() const;
+    /// Return the string the hash was calculated from, or empty if not known. Strings are only registered when built with URHO3D_HASH_DEBUG.
+    String Reverse() const;
     /// Return hash value for HashSet & HashMap.
     unsigned ToHash() const { return value_; }
     
     /// Calculate hash value case-insensitively from a C string.
     static unsigned Calculate(const char* str);
+#ifdef URHO3D_CONSTEXPR_HASH
+    /// Calculate hash value case-insensitively from a string literal at compile time. Recurses once per character, so use Calculate() for other strings.
+    static constexpr unsigned CalculateLiteral(const char* str, unsigned hash = 0)
+    {
+        return *str ? CalculateLiteral(str + 1, SDBMHash(hash, ToLower(*str))) : hash;
+    }
+#endif
+    /// Convert an ASCII character to lowercase for case-insensitive hashing. Unlike tolower(), does not depend on the locale.
+    static URHO3D_CONSTEXPR unsigned char ToLower(char c) { return (unsigned char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c); }
     
     /// Zero hash.
     static const StringHash ZERO;
@@ -63,11 +63,14 @@ Connection::Connection(Context* context, bool isClient, kNet::SharedPtr<kNet::Me
     Object(context),
     timeStamp_(0),
     connection_(connection),
+    interestGrid_(0),
+    relevantNodes_(0),
     sendMode_(OPSM_NONE),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
-    logStatistics_(false)
+    logStatistics_(false),
+    deferMessages_(false)
 {
     sceneState_.connection_ = this;
     
@@ -106,6 +109,18 @@ void Connection::SendMessage(int msgID, bool reliable, bool inOrder, const unsig
         return;
     }
     
+    // kNet messages can only be queued from the main thread, so buffer them when building an update in a worker thread
+    if (deferMessages_)
+    {
+        deferredMessages_.WriteInt(msgID);
+        deferredMessages_.WriteBool(reliable);
+        deferredMessages_.WriteBool(inOrder);
+        deferredMessages_.WriteUInt(contentID);
+        deferredMessages_.WriteUInt(numBytes);
+        deferredMessages_.Write(data, numBytes);
+        return;
+    }
+    
     kNet::NetworkMessage *msg = connection_->StartNewMessage(msgID, numBytes);
     if (!msg)
     {
@@ -245,6 +260,11 @@ void Connection::SendServerUpdate()
     if (!scene_ || !sceneLoaded_)
         return;
     
+    // Look up the nodes whose area of interest reaches the observer position
+    Network* network = GetSubsystem<Network>();
+    interestGrid_ = network ? network->GetInterestGrid(scene_) : 0;
+    relevantNodes_ = interestGrid_ ? interestGrid_->GetRelevantNodes(position_) : 0;
+    
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
@@ -260,6 +280,33 @@ void Connection::SendServerUpdate()
         unsigned nodeID = nodesToProcess_.Front();
         ProcessNode(nodeID);
     }
+    
+    interestGrid_ = 0;
+    relevantNodes_ = 0;
+}
+
+void Connection::PrepareServerUpdate()
+{
+    deferMessages_ = true;
+    SendServerUpdate();
+    deferMessages_ = false;
+}
+
+void Connection::SendDeferredMessages()
+{
+    MemoryBuffer buffer(deferredMessages_.GetData(), deferredMessages_.GetSize());
+    while (!buffer.IsEof())
+    {
+        int msgID = buffer.ReadInt();
+        bool reliable = buffer.ReadBool();
+        bool inOrder = buffer.ReadBool();
+        unsigned contentID = buffer.ReadUInt();
+        unsigned numBytes = buffer.ReadUInt();
+        SendMessage(msgID, reliable, inOrder, buffer.GetData() + buffer.GetPosition(), numBytes, contentID);
+        buffer.Seek(buffer.GetPosition() + numBytes);
+    }
+    
+    deferredMessages_.Clear();
 }
 
 void Connection::SendClientUpdate()
@@ -992,6 +1039,21 @@ String Connection::ToString() const
     return GetAddress() + ":" + String(GetPort());
 }
 
+float Connection::GetRoundTripTime() const
+{
+    return connection_->RoundTripTime();
+}
+
+float Connection::GetBytesInPerSec() const
+{
+    return connection_->BytesInPerSec();
+}
+
+float Connection::GetBytesOutPerSec() const
+{
+    return connection_->BytesOutPerSec();
+}
+
 unsigned Connection::GetNumDownloads() const
 {
     return downloads_.Size();
@@ -1172,11 +1234,24 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             ProcessNode(nodeID);
     }
     
-    // Check from the interest management component, if exists, whether should update
-    /// \todo Searching for the component is a potential CPU hotspot. It should be cached
-    NetworkPriority* priority = node->GetComponent<NetworkPriority>();
+    // Check from the interest management component, if exists, whether should update. On the server the component
+    // is found from the interest grid
+    const InterestEntry* interest = 0;
+    NetworkPriority* priority;
+    if (interestGrid_)
+    {
+        interest = interestGrid_->GetEntry(node->GetID());
+        priority = interest ? interest->priority_ : 0;
+    }
+    else
+        priority = node->GetComponent<NetworkPriority>();
+    
     if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
     {
+        // If the node's area of interest does not reach the observer, its priority is zero: skip the distance check
+        if (interest && !interest->unlimited_ && (!relevantNodes_ || !relevantNodes_->Contains(node->GetID())))
+            return;
+        
         float distance = (node->GetWorldPosition() - position_).Length();
         if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
             return;
@@ -40,6 +40,7 @@ namespace Urho3D
 {
 
 class File;
+class InterestGrid;
 class MemoryBuffer;
 class Node;
 class Scene;
@@ -138,6 +139,10 @@ public:
     void Disconnect(int waitMSec = 0);
     /// Send scene update messages. Called by Network.
     void SendServerUpdate();
+    /// Build scene update messages into a buffer without sending them. Can be called for different connections from worker threads at the same time. Called by Network.
+    void PrepareServerUpdate();
+    /// Send the scene update messages buffered by PrepareServerUpdate(). Called by Network.
+    void SendDeferredMessages();
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
     /// Send queued remote events. Called by Network.
@@ -179,6 +184,12 @@ public:
     unsigned short GetPort() const { return port_; }
     /// Return an address:port string.
     String ToString() const;
+    /// Return round trip time in milliseconds.
+    float GetRoundTripTime() const;
+    /// Return bytes received per second.
+    float GetBytesInPerSec() const;
+    /// Return bytes sent per second.
+    float GetBytesOutPerSec() const;
     /// Return number of package downloads remaining.
     unsigned GetNumDownloads() const;
     /// Return name of current package download, or empty if no downloads.
@@ -256,6 +267,12 @@ private:
     HashSet<unsigned> nodesToProcess_;
     /// Reusable message buffer.
     VectorBuffer msg_;
+    /// Messages built in a worker thread, to be sent from the main thread.
+    VectorBuffer deferredMessages_;
+    /// Interest management grid of the scene during a replication update.
+    const InterestGrid* interestGrid_;
+    /// Nodes whose area of interest may contain the observer during a replication update.
+    const HashSet<unsigned>* relevantNodes_;
     /// Queued remote events.
     Vector<RemoteEvent> remoteEvents_;
     /// Scene file to load once all packages (if any) have been downloaded.
@@ -280,6 +297,8 @@ private:
     bool sceneLoaded_;
     /// Show statistics flag.
     bool logStatistics_;
+    /// Buffer messages instead of sending flag.
+    bool deferMessages_;
 };
 
 }
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Network/InterestGrid.h"
+#include "../Network/NetworkPriority.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const float DEFAULT_CELL_SIZE = 32.0f;
+static const int MAX_CELLS_PER_NODE = 256;
+
+static unsigned long long GetCellKey(int x, int z)
+{
+    return ((unsigned long long)(unsigned)x << 32) | (unsigned)z;
+}
+
+InterestGrid::InterestGrid() :
+    cellSize_(DEFAULT_CELL_SIZE),
+    updateNumber_(0)
+{
+}
+
+void InterestGrid::SetCellSize(float size)
+{
+    size = Max(size, M_EPSILON);
+    if (size != cellSize_)
+    {
+        cellSize_ = size;
+        Clear();
+    }
+}
+
+void InterestGrid::BeginUpdate()
+{
+    ++updateNumber_;
+}
+
+void InterestGrid::UpdateNode(Node* node, NetworkPriority* priority)
+{
+    unsigned nodeID = node->GetID();
+    HashMap<unsigned, InterestEntry>::Iterator i = entries_.Find(nodeID);
+    if (i == entries_.End())
+        i = entries_.Insert(MakePair(nodeID, InterestEntry()));
+    else if (i->second_.updateNumber_ == updateNumber_)
+        return;
+
+    InterestEntry& entry = i->second_;
+    bool wasInCells = entry.priority_ && !entry.unlimited_;
+    IntRect oldCells = entry.cells_;
+
+    entry.priority_ = priority;
+    entry.updateNumber_ = updateNumber_;
+
+    // Past the interest radius the node gets zero priority, so it only needs to be found from the cells the radius reaches.
+    // If the radius covers too many cells, store the node as unlimited instead and rely on the distance check only
+    float radius = priority->GetInterestRadius();
+    entry.unlimited_ = radius >= M_INFINITY || radius / cellSize_ * 2.0f >= (float)MAX_CELLS_PER_NODE;
+    if (!entry.unlimited_)
+    {
+        const Vector3& position = node->GetWorldPosition();
+        entry.cells_ = IntRect(GetCellCoordinate(position.x_ - radius), GetCellCoordinate(position.z_ - radius),
+            GetCellCoordinate(position.x_ + radius), GetCellCoordinate(position.z_ + radius));
+        if ((entry.cells_.Width() + 1) * (entry.cells_.Height() + 1) > MAX_CELLS_PER_NODE)
+            entry.unlimited_ = true;
+    }
+
+    // Move the node in the grid only if its cells changed
+    bool isInCells = !entry.unlimited_;
+    if (wasInCells && (!isInCells || entry.cells_ != oldCells))
+        RemoveFromCells(nodeID, oldCells);
+    if (isInCells && (!wasInCells || entry.cells_ != oldCells))
+        AddToCells(nodeID, entry.cells_);
+}
+
+void InterestGrid::EndUpdate()
+{
+    for (HashMap<unsigned, InterestEntry>::Iterator i = entries_.Begin(); i != entries_.End();)
+    {
+        if (i->second_.updateNumber_ != updateNumber_)
+        {
+            if (!i->second_.unlimited_)
+                RemoveFromCells(i->first_, i->second_.cells_);
+            i = entries_.Erase(i);
+        }
+        else
+            ++i;
+    }
+}
+
+void InterestGrid::Clear()
+{
+    entries_.Clear();
+    cells_.Clear();
+}
+
+const InterestEntry* InterestGrid::GetEntry(unsigned nodeID) const
+{
+    HashMap<unsigned, InterestEntry>::ConstIterator i = entries_.Find(nodeID);
+    return i != entries_.End() ? &i->second_ : 0;
+}
+
+bool InterestGrid::HasNode(unsigned nodeID) const
+{
+    const InterestEntry* entry = GetEntry(nodeID);
+    return entry && entry->updateNumber_ == updateNumber_;
+}
+
+const HashSet<unsigned>* InterestGrid::GetRelevantNodes(const Vector3& position) const
+{
+    HashMap<unsigned long long, HashSet<unsigned> >::ConstIterator i = cells_.Find(GetCellKey(GetCellCoordinate(position.x_),
+        GetCellCoordinate(position.z_)));
+    return i != cells_.End() ? &i->second_ : 0;
+}
+
+void InterestGrid::AddToCells(unsigned nodeID, const IntRect& cells)
+{
+    for (int z = cells.top_; z <= cells.bottom_; ++z)
+    {
+        for (int x = cells.left_; x <= cells.right_; ++x)
+            cells_[GetCellKey(x, z)].Insert(nodeID);
+    }
+}
+
+void InterestGrid::RemoveFromCells(unsigned nodeID, const IntRect& cells)
+{
+    for (int z = cells.top_; z <= cells.bottom_; ++z)
+    {
+        for (int x = cells.left_; x <= cells.right_; ++x)
+        {
+            HashMap<unsigned long long, HashSet<unsigned> >::Iterator i = cells_.Find(GetCellKey(x, z));
+            if (i != cells_.End())
+            {
+                i->second_.Erase(nodeID);
+                if (i->second_.Empty())
+                    cells_.Erase(i);
+            }
+        }
+    }
+}
+
+}
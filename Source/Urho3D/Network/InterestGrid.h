@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/HashSet.h"
+#include "../Math/Rect.h"
+#include "../Math/Vector3.h"
+
+namespace Urho3D
+{
+
+class NetworkPriority;
+class Node;
+
+/// Interest management data of a replicated node.
+struct InterestEntry
+{
+    /// Construct with defaults.
+    InterestEntry() :
+        priority_(0),
+        updateNumber_(0),
+        unlimited_(false)
+    {
+    }
+
+    /// Interest management component.
+    NetworkPriority* priority_;
+    /// Grid cells covered by the area of interest.
+    IntRect cells_;
+    /// Number of the grid update the entry was last seen in.
+    unsigned updateNumber_;
+    /// Area of interest covers the whole scene flag.
+    bool unlimited_;
+};
+
+/// Grid on the XZ plane of the replicated nodes with a NetworkPriority component in one scene. Each node is stored in the cells its area of interest overlaps, so that the server can find the nodes relevant to a connection from its observer position.
+class URHO3D_API InterestGrid
+{
+public:
+    /// Construct.
+    InterestGrid();
+
+    /// Set cell size. Clears the grid.
+    void SetCellSize(float size);
+    /// Begin an update. The nodes which are not updated before EndUpdate() will be removed.
+    void BeginUpdate();
+    /// Update a node's area of interest.
+    void UpdateNode(Node* node, NetworkPriority* priority);
+    /// End an update and remove the nodes no longer seen.
+    void EndUpdate();
+    /// Clear all nodes.
+    void Clear();
+
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+    /// Return the interest management data of a node, or null if the node has no interest management component.
+    const InterestEntry* GetEntry(unsigned nodeID) const;
+    /// Return whether a node has been updated during the current update.
+    bool HasNode(unsigned nodeID) const;
+    /// Return the nodes whose limited area of interest may contain a position, or null if none.
+    const HashSet<unsigned>* GetRelevantNodes(const Vector3& position) const;
+    /// Return number of nodes.
+    unsigned GetNumNodes() const { return entries_.Size(); }
+
+private:
+    /// Return cell coordinate of a position on the X or Z axis.
+    int GetCellCoordinate(float value) const { return (int)floorf(value / cellSize_); }
+    /// Add a node to cells.
+    void AddToCells(unsigned nodeID, const IntRect& cells);
+    /// Remove a node from cells.
+    void RemoveFromCells(unsigned nodeID, const IntRect& cells);
+
+    /// Interest management data by node ID.
+    HashMap<unsigned, InterestEntry> entries_;
+    /// Node IDs by packed cell coordinates.
+    HashMap<unsigned long long, HashSet<unsigned> > cells_;
+    /// Cell size.
+    float cellSize_;
+    /// Current update number.
+    unsigned updateNumber_;
+};
+
+}
@@ -22,6 +22,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Network/HttpRequest.h"
@@ -45,8 +46,21 @@ namespace Urho3D
 
 static const int DEFAULT_UPDATE_FPS = 30;
 
+void PrepareServerUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    Connection** start = reinterpret_cast<Connection**>(item->start_);
+    Connection** end = reinterpret_cast<Connection**>(item->end_);
+
+    while (start != end)
+    {
+        (*start)->PrepareServerUpdate();
+        ++start;
+    }
+}
+
 Network::Network(Context* context) :
     Object(context),
+    interestCellSize_(32.0f),
     updateFps_(DEFAULT_UPDATE_FPS),
     simulatedLatency_(0),
     simulatedPacketLoss_(0.0f),
@@ -377,6 +391,23 @@ void Network::SetPackageCacheDir(const String& path)
     packageCacheDir_ = AddTrailingSlash(path);
 }
 
+void Network::SetInterestCellSize(float size)
+{
+    interestCellSize_ = Max(size, M_EPSILON);
+    for (HashMap<Scene*, InterestGrid>::Iterator i = interestGrids_.Begin(); i != interestGrids_.End(); ++i)
+        i->second_.SetCellSize(interestCellSize_);
+}
+
+void Network::AddNetworkPriority(NetworkPriority* priority)
+{
+    networkPriorities_.Insert(priority);
+}
+
+void Network::RemoveNetworkPriority(NetworkPriority* priority)
+{
+    networkPriorities_.Erase(priority);
+}
+
 void Network::SendPackageToClients(Scene* scene, PackageFile* package)
 {
     if (!scene)
@@ -446,6 +477,12 @@ bool Network::CheckRemoteEvent(StringHash eventType) const
     return allowedRemoteEvents_.Contains(eventType);
 }
 
+const InterestGrid* Network::GetInterestGrid(Scene* scene) const
+{
+    HashMap<Scene*, InterestGrid>::ConstIterator i = interestGrids_.Find(scene);
+    return i != interestGrids_.End() ? &i->second_ : 0;
+}
+
 void Network::Update(float timeStep)
 {
     PROFILE(UpdateNetwork);
@@ -508,8 +545,38 @@ void Network::PostUpdate(float timeStep)
                 
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
                     (*i)->PrepareNetworkUpdate();
+                
+                UpdateInterestGrids();
             }
             
+            WorkQueue* queue = GetSubsystem<WorkQueue>();
+            if (queue && queue->GetNumThreads() && clientConnections_.Size() > 1)
+            {
+                PROFILE(SendServerUpdate);
+                
+                // Build the scene updates of the client connections in worker threads. The scenes are put in threaded
+                // update mode to protect the network state shared between connections
+                updateConnections_.Clear();
+                for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
+                    i != clientConnections_.End(); ++i)
+                    updateConnections_.Push(i->second_);
+                
+                for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+                    (*i)->BeginThreadedUpdate();
+                queue->ParallelFor(PrepareServerUpdateWork, updateConnections_.Begin(), updateConnections_.End(), 0, 1);
+                queue->Complete(M_MAX_UNSIGNED);
+                for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+                    (*i)->EndThreadedUpdate();
+                
+                // Then hand the messages over to kNet in the main thread
+                for (PODVector<Connection*>::Iterator i = updateConnections_.Begin(); i != updateConnections_.End(); ++i)
+                {
+                    (*i)->SendDeferredMessages();
+                    (*i)->SendRemoteEvents();
+                    (*i)->SendPackages();
+                }
+            }
+            else
             {
                 PROFILE(SendServerUpdate);
                 
@@ -592,6 +659,40 @@ void Network::ConfigureNetworkSimulator()
         i->second_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
 }
 
+void Network::UpdateInterestGrids()
+{
+    // Drop the grids of scenes no longer networked and create grids for new scenes
+    for (HashMap<Scene*, InterestGrid>::Iterator i = interestGrids_.Begin(); i != interestGrids_.End();)
+    {
+        if (!networkScenes_.Contains(i->first_))
+            i = interestGrids_.Erase(i);
+        else
+            ++i;
+    }
+    for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+    {
+        if (!interestGrids_.Contains(*i))
+            interestGrids_[*i].SetCellSize(interestCellSize_);
+    }
+    
+    for (HashMap<Scene*, InterestGrid>::Iterator i = interestGrids_.Begin(); i != interestGrids_.End(); ++i)
+        i->second_.BeginUpdate();
+    
+    for (HashSet<NetworkPriority*>::ConstIterator i = networkPriorities_.Begin(); i != networkPriorities_.End(); ++i)
+    {
+        Node* node = (*i)->GetNode();
+        if (!node || node->GetID() >= FIRST_LOCAL_ID)
+            continue;
+        HashMap<Scene*, InterestGrid>::Iterator j = interestGrids_.Find(node->GetScene());
+        // If the node has several interest management components, only the first is used, as before
+        if (j != interestGrids_.End() && !j->second_.HasNode(node->GetID()))
+            j->second_.UpdateNode(node, node->GetComponent<NetworkPriority>());
+    }
+    
+    for (HashMap<Scene*, InterestGrid>::Iterator i = interestGrids_.Begin(); i != interestGrids_.End(); ++i)
+        i->second_.EndUpdate();
+}
+
 void RegisterNetworkLibrary(Context* context)
 {
     NetworkPriority::RegisterObject(context);
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Network/Connection.h"
+#include "../Network/InterestGrid.h"
 #include "../Container/HashSet.h"
 #include "../Core/Object.h"
 #include "../IO/VectorBuffer.h"
@@ -35,6 +36,7 @@ namespace Urho3D
 
 class HttpRequest;
 class MemoryBuffer;
+class NetworkPriority;
 class Scene;
 
 /// MessageConnection hash function.
@@ -95,6 +97,12 @@ public:
     void UnregisterAllRemoteEvents();
     /// Set the package download cache directory.
     void SetPackageCacheDir(const String& path);
+    /// Set the cell size of the interest management grids used by the server. Default 32.
+    void SetInterestCellSize(float size);
+    /// Register an interest management component. Called by NetworkPriority.
+    void AddNetworkPriority(NetworkPriority* priority);
+    /// Unregister an interest management component. Called by NetworkPriority.
+    void RemoveNetworkPriority(NetworkPriority* priority);
     /// Trigger all client connections in the specified scene to download a package file from the server. Can be used to download additional resource packages when clients are already joined in the scene. The package must have been added as a requirement to the scene, or else the eventual download will fail.
     void SendPackageToClients(Scene* scene, PackageFile* package);
     /// Perform an HTTP request to the specified URL. Empty verb defaults to a GET request. Return a request object which can be used to read the response data.
@@ -118,6 +126,10 @@ public:
     bool CheckRemoteEvent(StringHash eventType) const;
     /// Return the package download cache directory.
     const String& GetPackageCacheDir() const { return packageCacheDir_; }
+    /// Return the cell size of the interest management grids.
+    float GetInterestCellSize() const { return interestCellSize_; }
+    /// Return the interest management grid of a networked scene, or null if not found. Updated by the server before sending scene updates.
+    const InterestGrid* GetInterestGrid(Scene* scene) const;
     
     /// Process incoming messages from connections. Called by HandleBeginFrame.
     void Update(float timeStep);
@@ -135,6 +147,8 @@ private:
     void OnServerDisconnected();
     /// Reconfigure network simulator parameters on all existing connections.
     void ConfigureNetworkSimulator();
+    /// Update the interest management grids of the networked scenes.
+    void UpdateInterestGrids();
     
     /// kNet instance.
     kNet::Network* network_;
@@ -148,6 +162,14 @@ private:
     HashSet<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
     HashSet<Scene*> networkScenes_;
+    /// Client connections being updated in worker threads.
+    PODVector<Connection*> updateConnections_;
+    /// Interest management components.
+    HashSet<NetworkPriority*> networkPriorities_;
+    /// Interest management grids of the networked scenes.
+    HashMap<Scene*, InterestGrid> interestGrids_;
+    /// Interest management grid cell size.
+    float interestCellSize_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
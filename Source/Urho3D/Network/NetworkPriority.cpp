@@ -21,6 +21,7 @@
 //
 
 #include "../Core/Context.h"
+#include "../Network/Network.h"
 #include "../Network/NetworkPriority.h"
 
 #include "../DebugNew.h"
@@ -46,6 +47,9 @@ NetworkPriority::NetworkPriority(Context* context) :
 
 NetworkPriority::~NetworkPriority()
 {
+    Network* network = GetSubsystem<Network>();
+    if (network)
+        network->RemoveNetworkPriority(this);
 }
 
 void NetworkPriority::RegisterObject(Context* context)
@@ -82,6 +86,14 @@ void NetworkPriority::SetAlwaysUpdateOwner(bool enable)
     MarkNetworkUpdate();
 }
 
+float NetworkPriority::GetInterestRadius() const
+{
+    if (minPriority_ != 0.0f || distanceFactor_ <= 0.0f)
+        return M_INFINITY;
+    else
+        return basePriority_ / distanceFactor_;
+}
+
 bool NetworkPriority::CheckUpdate(float distance, float& accumulator)
 {
     float currentPriority = Max(basePriority_ - distanceFactor_ * distance, minPriority_);
@@ -95,4 +107,17 @@ bool NetworkPriority::CheckUpdate(float distance, float& accumulator)
         return false;
 }
 
+void NetworkPriority::OnNodeSet(Node* node)
+{
+    // Register to the network subsystem for the server to maintain the interest grids
+    Network* network = GetSubsystem<Network>();
+    if (network)
+    {
+        if (node)
+            network->AddNetworkPriority(this);
+        else
+            network->RemoveNetworkPriority(this);
+    }
+}
+
 }
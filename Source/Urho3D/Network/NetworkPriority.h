@@ -57,10 +57,16 @@ public:
     float GetMinPriority() const { return minPriority_; }
     /// Return whether updates to owner should be sent always at full rate.
     bool GetAlwaysUpdateOwner() const { return alwaysUpdateOwner_; }
+    /// Return the distance at which priority drops to zero and no more updates are sent, or infinity if updates are always sent.
+    float GetInterestRadius() const;
     
     /// Increment and check priority accumulator. Return true if should update. Called by Connection.
     bool CheckUpdate(float distance, float& accumulator);
     
+protected:
+    /// Handle node being assigned.
+    virtual void OnNodeSet(Node* node);
+    
 private:
     /// Base priority.
     float basePriority_;
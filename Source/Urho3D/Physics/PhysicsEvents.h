@@ -27,6 +27,11 @@
 namespace Urho3D
 {
 
+class Node;
+class PhysicsWorld;
+class RigidBody;
+class VectorBuffer;
+
 /// Physics world is about to be stepped.
 EVENT(E_PHYSICSPRESTEP, PhysicsPreStep)
 {
@@ -34,6 +39,27 @@ EVENT(E_PHYSICSPRESTEP, PhysicsPreStep)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the physics pre-step event.
+struct URHO3D_API PhysicsPreStepEventData
+{
+    TYPED_EVENT(E_PHYSICSPRESTEP);
+    
+    /// Construct.
+    PhysicsPreStepEventData(PhysicsWorld* world, float timeStep) :
+        world_(world),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+    
+    /// PhysicsWorld.
+    PhysicsWorld* world_;
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Physics world has been stepped.
 EVENT(E_PHYSICSPOSTSTEP, PhysicsPostStep)
 {
@@ -41,6 +67,27 @@ EVENT(E_PHYSICSPOSTSTEP, PhysicsPostStep)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the physics post-step event.
+struct URHO3D_API PhysicsPostStepEventData
+{
+    TYPED_EVENT(E_PHYSICSPOSTSTEP);
+    
+    /// Construct.
+    PhysicsPostStepEventData(PhysicsWorld* world, float timeStep) :
+        world_(world),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+    
+    /// PhysicsWorld.
+    PhysicsWorld* world_;
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Physics collision started.
 EVENT(E_PHYSICSCOLLISIONSTART, PhysicsCollisionStart)
 {
@@ -65,6 +112,43 @@ EVENT(E_PHYSICSCOLLISION, PhysicsCollision)
     PARAM(P_CONTACTS, Contacts);            // Buffer containing position (Vector3), normal (Vector3), distance (float), impulse (float) for each contact
 }
 
+/// Typed data of the physics collision ongoing event.
+struct URHO3D_API PhysicsCollisionEventData
+{
+    TYPED_EVENT(E_PHYSICSCOLLISION);
+    
+    /// Construct.
+    PhysicsCollisionEventData(PhysicsWorld* world, Node* nodeA, Node* nodeB, RigidBody* bodyA, RigidBody* bodyB, bool trigger,
+        const VectorBuffer* contacts) :
+        world_(world),
+        nodeA_(nodeA),
+        nodeB_(nodeB),
+        bodyA_(bodyA),
+        bodyB_(bodyB),
+        trigger_(trigger),
+        contacts_(contacts)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+    
+    /// PhysicsWorld.
+    PhysicsWorld* world_;
+    /// First node.
+    Node* nodeA_;
+    /// Second node.
+    Node* nodeB_;
+    /// First rigid body.
+    RigidBody* bodyA_;
+    /// Second rigid body.
+    RigidBody* bodyB_;
+    /// Trigger flag.
+    bool trigger_;
+    /// Contact points: position (Vector3), normal (Vector3), distance (float) and impulse (float) for each contact. Can be read through a MemoryBuffer.
+    const VectorBuffer* contacts_;
+};
+
 /// Physics collision ended.
 EVENT(E_PHYSICSCOLLISIONEND, PhysicsCollisionEnd)
 {
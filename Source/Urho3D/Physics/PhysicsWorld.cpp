@@ -63,6 +63,29 @@ static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const Physics
     return lhs.distance_ < rhs.distance_;
 }
 
+void PhysicsPreStepEventData::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[PhysicsPreStep::P_WORLD] = world_;
+    eventData[PhysicsPreStep::P_TIMESTEP] = timeStep_;
+}
+
+void PhysicsPostStepEventData::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[PhysicsPostStep::P_WORLD] = world_;
+    eventData[PhysicsPostStep::P_TIMESTEP] = timeStep_;
+}
+
+void PhysicsCollisionEventData::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[PhysicsCollision::P_WORLD] = world_;
+    eventData[PhysicsCollision::P_NODEA] = nodeA_;
+    eventData[PhysicsCollision::P_NODEB] = nodeB_;
+    eventData[PhysicsCollision::P_BODYA] = bodyA_;
+    eventData[PhysicsCollision::P_BODYB] = bodyB_;
+    eventData[PhysicsCollision::P_TRIGGER] = trigger_;
+    eventData[PhysicsCollision::P_CONTACTS] = contacts_->GetBuffer();
+}
+
 void InternalPreTickCallback(btDynamicsWorld *world, btScalar timeStep)
 {
     static_cast<PhysicsWorld*>(world->getWorldUserInfo())->PreStep(timeStep);
@@ -673,12 +696,12 @@ void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap&
 void PhysicsWorld::PreStep(float timeStep)
 {
     // Send pre-step event
-    using namespace PhysicsPreStep;
+    PhysicsPreStepEventData eventData(this, timeStep);
+    SendTypedEvent(eventData);
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPRESTEP, eventData);
+    // Then update thread-safe logic components' fixed update in worker threads
+    if (scene_)
+        scene_->UpdateThreadedLogic(USE_FIXEDUPDATE, timeStep);
 
     // Start profiling block for the actual simulation step
 #ifdef URHO3D_PROFILING
@@ -699,12 +722,8 @@ void PhysicsWorld::PostStep(float timeStep)
     SendCollisionEvents();
 
     // Send post-step event
-    using namespace PhysicsPostStep;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPOSTSTEP, eventData);
+    PhysicsPostStepEventData eventData(this, timeStep);
+    SendTypedEvent(eventData);
 }
 
 void PhysicsWorld::SendCollisionEvents()
@@ -778,12 +797,6 @@ void PhysicsWorld::SendCollisionEvents()
             bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
             bool newCollision = !previousCollisions_.Contains(i->first_);
 
-            physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
-            physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
-            physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
-            physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
-            physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
-
             contacts_.Clear();
 
             for (int j = 0; j < contactManifold->getNumContacts(); ++j)
@@ -795,19 +808,24 @@ void PhysicsWorld::SendCollisionEvents()
                 contacts_.WriteFloat(point.m_appliedImpulse);
             }
 
-            physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
-
             // Send separate collision start event if collision is new
             if (newCollision)
             {
+                physicsCollisionData_[PhysicsCollisionStart::P_NODEA] = nodeA;
+                physicsCollisionData_[PhysicsCollisionStart::P_NODEB] = nodeB;
+                physicsCollisionData_[PhysicsCollisionStart::P_BODYA] = bodyA;
+                physicsCollisionData_[PhysicsCollisionStart::P_BODYB] = bodyB;
+                physicsCollisionData_[PhysicsCollisionStart::P_TRIGGER] = trigger;
+                physicsCollisionData_[PhysicsCollisionStart::P_CONTACTS] = contacts_.GetBuffer();
                 SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
                 // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
+            // Then send the ongoing collision event. The contacts are copied to a VariantMap only if it has VariantMap receivers
+            PhysicsCollisionEventData collisionData(this, nodeA, nodeB, bodyA, bodyB, trigger, &contacts_);
+            SendTypedEvent(collisionData);
             if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                 continue;
 
@@ -37,8 +37,8 @@ Resource::Resource(Context* context) :
 
 bool Resource::Load(Deserializer& source)
 {
-    // Because BeginLoad() / EndLoad() can be called from worker threads, where profiling would be a no-op,
-    // create a type name -based profile block here
+    // Create a type name -based profile block here, so that loading is profiled per resource type also when done
+    // in worker threads
 #ifdef URHO3D_PROFILING
     String profileBlockName("Load" + GetTypeName());
     
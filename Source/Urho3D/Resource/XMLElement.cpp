@@ -1069,8 +1069,12 @@ String XPathQuery::EvaluateToString(XMLElement element) const
 
     const pugi::xml_node& node = element.GetXPathNode() ? element.GetXPathNode()->node(): pugi::xml_node(element.GetNode());
     String result;
-    result.Reserve((unsigned)query_->evaluate_string(0, 0, node));    // First call get the size
-    query_->evaluate_string(const_cast<pugi::char_t*>(result.CString()), result.Capacity(), node);  // Second call get the actual string
+    unsigned size = (unsigned)query_->evaluate_string(0, 0, node);    // First call get the size, including the null terminator
+    if (size > 1)
+    {
+        result.Resize(size - 1);
+        query_->evaluate_string(const_cast<pugi::char_t*>(result.CString()), size, node);  // Second call get the actual string
+    }
     return result;
 }
 
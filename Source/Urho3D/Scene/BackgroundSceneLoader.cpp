@@ -0,0 +1,316 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Core/Context.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../Scene/BackgroundSceneLoader.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static void DecodeAttributesXML(const Vector<AttributeInfo>& attributes, const XMLElement& source, Vector<Variant>& values)
+{
+    // Attributes not present in the XML data are left empty, so that they will not be set, like in Serializable::LoadXML()
+    PODVector<unsigned> valueIndices(attributes.Size());
+    unsigned numValues = 0;
+    for (unsigned i = 0; i < attributes.Size(); ++i)
+        valueIndices[i] = (attributes[i].mode_ & AM_FILE) ? numValues++ : M_MAX_UNSIGNED;
+    values.Resize(numValues);
+    
+    XMLElement attrElem = source.GetChild("attribute");
+    unsigned startIndex = 0;
+    
+    while (attrElem)
+    {
+        String name = attrElem.GetAttribute("name");
+        unsigned i = startIndex;
+        unsigned attempts = attributes.Size();
+        
+        while (attempts)
+        {
+            const AttributeInfo& attr = attributes[i];
+            if ((attr.mode_ & AM_FILE) && !attr.name_.Compare(name, true))
+            {
+                Variant& varValue = values[valueIndices[i]];
+                
+                // If enums specified, do enum lookup and int assignment. Otherwise assign the variant directly
+                if (attr.enumNames_)
+                {
+                    String value = attrElem.GetAttribute("value");
+                    bool enumFound = false;
+                    int enumValue = 0;
+                    const char** enumPtr = attr.enumNames_;
+                    while (*enumPtr)
+                    {
+                        if (!value.Compare(*enumPtr, false))
+                        {
+                            enumFound = true;
+                            break;
+                        }
+                        ++enumPtr;
+                        ++enumValue;
+                    }
+                    if (enumFound)
+                        varValue = enumValue;
+                    else
+                        LOGWARNING("Unknown enum value " + value + " in attribute " + attr.name_);
+                }
+                else
+                    varValue = attrElem.GetVariantValue(attr.type_);
+                
+                startIndex = (i + 1) % attributes.Size();
+                break;
+            }
+            else
+            {
+                i = (i + 1) % attributes.Size();
+                --attempts;
+            }
+        }
+        
+        if (!attempts)
+            LOGWARNING("Unknown attribute " + name + " in XML data");
+        
+        attrElem = attrElem.GetNext("attribute");
+    }
+}
+
+BackgroundSceneLoader::BackgroundSceneLoader(Context* context, Deserializer* source, unsigned numNodes) :
+    context_(context),
+    source_(source),
+    numNodes_(numNodes),
+    nextNode_(0),
+    finished_(numNodes == 0)
+{
+}
+
+void BackgroundSceneLoader::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        if (!DecodeNextNode())
+            break;
+    }
+}
+
+bool BackgroundSceneLoader::DecodeNextNode()
+{
+    if (IsFinished())
+        return false;
+    
+    StagedNodeTree tree;
+    bool success = tree.DecodeNode(context_, *source_);
+    if (!success)
+        LOGERROR("Failed to decode scene content from " + source_->GetName());
+    
+    // Calculate the checksum while still having exclusive access to the source, before finishing. The main thread then gets
+    // the stored checksum instead of reading the file again
+    bool finished = !success || nextNode_ + 1 >= numNodes_;
+    if (finished)
+        source_->GetChecksum();
+    
+    MutexLock lock(decodedNodesMutex_);
+    if (success)
+    {
+        decodedNodes_.Resize(decodedNodes_.Size() + 1);
+        // Swap instead of copying the decoded data
+        decodedNodes_.Back().nodes_.Swap(tree.nodes_);
+        decodedNodes_.Back().components_.Swap(tree.components_);
+        ++nextNode_;
+    }
+    finished_ = finished;
+    
+    return success;
+}
+
+bool BackgroundSceneLoader::IsFinished() const
+{
+    MutexLock lock(decodedNodesMutex_);
+    return finished_;
+}
+
+void BackgroundSceneLoader::TakeDecodedNodes(Vector<StagedNodeTree>& dest)
+{
+    MutexLock lock(decodedNodesMutex_);
+    
+    if (dest.Empty())
+        dest.Swap(decodedNodes_);
+    else
+    {
+        dest.Push(decodedNodes_);
+        decodedNodes_.Clear();
+    }
+}
+
+bool StagedNodeTree::DecodeNode(Context* context, Deserializer& source)
+{
+    unsigned nodeIndex = nodes_.Size();
+    nodes_.Resize(nodeIndex + 1);
+    nodes_[nodeIndex].id_ = source.ReadUInt();
+    
+    // Decode the attributes the same way as Serializable::Load() would
+    const Vector<AttributeInfo>* attributes = context->GetAttributes(Node::GetTypeStatic());
+    if (attributes)
+    {
+        Vector<Variant>& values = nodes_[nodeIndex].attributes_;
+        for (unsigned i = 0; i < attributes->Size(); ++i)
+        {
+            const AttributeInfo& attr = attributes->At(i);
+            if (!(attr.mode_ & AM_FILE))
+                continue;
+            
+            if (source.IsEof())
+            {
+                LOGERROR("Could not decode node, stream not open or at end");
+                return false;
+            }
+            
+            values.Push(source.ReadVariant(attr.type_));
+        }
+    }
+    
+    unsigned numComponents = source.ReadVLE();
+    nodes_[nodeIndex].numComponents_ = numComponents;
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        if (!DecodeComponent(context, source))
+            return false;
+    }
+    
+    unsigned numChildren = source.ReadVLE();
+    nodes_[nodeIndex].numChildren_ = numChildren;
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if (!DecodeNode(context, source))
+            return false;
+    }
+    
+    return true;
+}
+
+bool StagedNodeTree::DecodeNodeXML(Context* context, const XMLElement& source)
+{
+    unsigned nodeIndex = nodes_.Size();
+    nodes_.Resize(nodeIndex + 1);
+    nodes_[nodeIndex].id_ = source.GetInt("id");
+    
+    const Vector<AttributeInfo>* attributes = context->GetAttributes(Node::GetTypeStatic());
+    if (attributes)
+        DecodeAttributesXML(*attributes, source, nodes_[nodeIndex].attributes_);
+    
+    unsigned numComponents = 0;
+    XMLElement compElem = source.GetChild("component");
+    while (compElem)
+    {
+        if (!DecodeComponentXML(context, compElem))
+            return false;
+        ++numComponents;
+        compElem = compElem.GetNext("component");
+    }
+    nodes_[nodeIndex].numComponents_ = numComponents;
+    
+    unsigned numChildren = 0;
+    XMLElement childElem = source.GetChild("node");
+    while (childElem)
+    {
+        if (!DecodeNodeXML(context, childElem))
+            return false;
+        ++numChildren;
+        childElem = childElem.GetNext("node");
+    }
+    nodes_[nodeIndex].numChildren_ = numChildren;
+    
+    return true;
+}
+
+bool StagedNodeTree::DecodeComponent(Context* context, Deserializer& source)
+{
+    components_.Resize(components_.Size() + 1);
+    StagedComponent& component = components_.Back();
+    
+    unsigned dataSize = source.ReadVLE();
+    component.data_.Resize(dataSize);
+    if (dataSize && source.Read(&component.data_[0], dataSize) != dataSize)
+    {
+        LOGERROR("Could not decode component, stream not open or at end");
+        return false;
+    }
+    
+    MemoryBuffer compBuffer(component.data_);
+    component.type_ = compBuffer.ReadStringHash();
+    component.id_ = compBuffer.ReadUInt();
+    
+    // Decode with the attributes registered for the type. If they do not match the data exactly, for example due to
+    // instance-specific attributes, the component will be loaded from the stored data instead
+    const Vector<AttributeInfo>* attributes = context->GetAttributes(component.type_);
+    if (!attributes)
+        return true;
+    
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+        
+        if (compBuffer.IsEof())
+        {
+            component.attributes_.Clear();
+            return true;
+        }
+        
+        component.attributes_.Push(compBuffer.ReadVariant(attr.type_));
+    }
+    
+    component.decoded_ = compBuffer.IsEof();
+    if (!component.decoded_)
+        component.attributes_.Clear();
+    return true;
+}
+
+bool StagedNodeTree::DecodeComponentXML(Context* context, const XMLElement& source)
+{
+    components_.Resize(components_.Size() + 1);
+    StagedComponent& component = components_.Back();
+    
+    component.typeName_ = source.GetAttribute("type");
+    component.type_ = StringHash(component.typeName_);
+    component.id_ = source.GetInt("id");
+    // The XML file must stay alive for the component to be loaded from the element instead
+    component.element_ = source;
+    
+    const Vector<AttributeInfo>* attributes = context->GetAttributes(component.type_);
+    if (attributes)
+    {
+        DecodeAttributesXML(*attributes, source, component.attributes_);
+        component.decoded_ = true;
+    }
+    
+    return true;
+}
+
+}
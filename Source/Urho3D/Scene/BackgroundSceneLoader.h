@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/RefCounted.h"
+#include "../Core/Mutex.h"
+#include "../Core/Thread.h"
+#include "../Core/Variant.h"
+#include "../Resource/XMLElement.h"
+
+namespace Urho3D
+{
+
+class Context;
+class Deserializer;
+
+/// Component decoded by the background scene loader or a prefab.
+struct StagedComponent
+{
+    /// Construct.
+    StagedComponent() :
+        id_(0),
+        decoded_(false)
+    {
+    }
+    
+    /// Component type.
+    StringHash type_;
+    /// Component type name, if known.
+    String typeName_;
+    /// Component ID in the file.
+    unsigned id_;
+    /// Attribute values decoded with the attributes registered for the type. Empty values are not set.
+    Vector<Variant> attributes_;
+    /// Whether the attribute values were decoded from the whole component data.
+    bool decoded_;
+    /// Component binary data as stored in the file, for components that can not use the decoded attribute values.
+    PODVector<unsigned char> data_;
+    /// Component XML data, for components that can not use the decoded attribute values.
+    XMLElement element_;
+};
+
+/// Node decoded by the background scene loader or a prefab.
+struct StagedNode
+{
+    /// Construct.
+    StagedNode() :
+        id_(0),
+        numComponents_(0),
+        numChildren_(0)
+    {
+    }
+    
+    /// Node ID in the file.
+    unsigned id_;
+    /// Decoded attribute values. Empty values are not set.
+    Vector<Variant> attributes_;
+    /// Number of components.
+    unsigned numComponents_;
+    /// Number of child nodes.
+    unsigned numChildren_;
+};
+
+/// Node with its whole sub-hierarchy, decoded by the background scene loader or a prefab. Nodes are stored in depth-first order and their components in the same order.
+struct StagedNodeTree
+{
+    /// Decode a node and its sub-hierarchy from binary data, starting from the node ID. Only reads attribute registrations, so may be called from a worker thread. Return true if successful.
+    bool DecodeNode(Context* context, Deserializer& source);
+    /// Decode a node and its sub-hierarchy from XML data. Only reads attribute registrations, so may be called from a worker thread. Return true if successful.
+    bool DecodeNodeXML(Context* context, const XMLElement& source);
+    /// Decode a component from binary data.
+    bool DecodeComponent(Context* context, Deserializer& source);
+    /// Decode a component from XML data.
+    bool DecodeComponentXML(Context* context, const XMLElement& source);
+    
+    /// Nodes.
+    Vector<StagedNode> nodes_;
+    /// Components of all nodes.
+    Vector<StagedComponent> components_;
+};
+
+/// Background decoder of binary scene content for asynchronous loading. Owned by the Scene.
+class BackgroundSceneLoader : public RefCounted, public Thread
+{
+public:
+    /// Construct with the source positioned at the first root-level child node. The source must not be accessed by others while decoding.
+    BackgroundSceneLoader(Context* context, Deserializer* source, unsigned numNodes);
+    
+    /// Scene decoding loop.
+    virtual void ThreadFunction();
+    
+    /// Decode the next root-level child node. Called from the decoding thread, or from the main thread if threads are not available. Return false if no nodes left or on error.
+    bool DecodeNextNode();
+    /// Move the decoded root-level child nodes to the destination vector.
+    void TakeDecodedNodes(Vector<StagedNodeTree>& dest);
+    
+    /// Return whether all nodes have been decoded, or decoding has stopped due to an error. After this the source is no longer accessed.
+    bool IsFinished() const;
+    
+private:
+    /// Execution context.
+    Context* context_;
+    /// Source stream.
+    Deserializer* source_;
+    /// Total root-level child nodes.
+    unsigned numNodes_;
+    /// Index of the next root-level child node to decode.
+    unsigned nextNode_;
+    /// Finished flag.
+    bool finished_;
+    /// Mutex for the decoded nodes and the finished flag.
+    mutable Mutex decodedNodesMutex_;
+    /// Decoded root-level child nodes waiting to be taken by the main thread.
+    Vector<StagedNodeTree> decodedNodes_;
+};
+
+}
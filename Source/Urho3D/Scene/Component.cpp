@@ -126,10 +126,21 @@ Scene* Component::GetScene() const
 
 void Component::AddReplicationState(ComponentReplicationState* state)
 {
-    if (!networkState_)
-        AllocateNetworkState();
-
-    networkState_->replicationStates_.Push(state);
+    // Connections may be updated in worker threads, which share the network state
+    Scene* scene = GetScene();
+    if (!scene || !scene->IsThreadedUpdate())
+    {
+        if (!networkState_)
+            AllocateNetworkState();
+        networkState_->replicationStates_.Push(state);
+    }
+    else
+    {
+        MutexLock lock(scene->GetSceneMutex());
+        if (!networkState_)
+            AllocateNetworkState();
+        networkState_->replicationStates_.Push(state);
+    }
 }
 
 void Component::PrepareNetworkUpdate()
@@ -154,6 +165,7 @@ void Component::PrepareNetworkUpdate()
     }
 
     // Check for attribute changes
+    DirtyBits changedAttributes;
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
@@ -166,6 +178,7 @@ void Component::PrepareNetworkUpdate()
         if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            changedAttributes.Set(i);
 
             // Mark the attribute dirty in all replication states that are tracking this component
             for (PODVector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin(); j !=
@@ -185,6 +198,8 @@ void Component::PrepareNetworkUpdate()
         }
     }
 
+    CacheNetworkUpdate(changedAttributes);
+
     networkUpdate_ = false;
 }
 
@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 #include "../Scene/LogicComponent.h"
 #ifdef URHO3D_PHYSICS
@@ -32,11 +33,24 @@
 namespace Urho3D
 {
 
+/// Number of work items to split a batch into per thread, to balance uneven update costs.
+static const unsigned ITEMS_PER_THREAD = 4;
+
+void UpdateLogicComponentsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const LogicComponentBatches* batches = reinterpret_cast<LogicComponentBatches*>(item->aux_);
+    batches->UpdateRange(reinterpret_cast<LogicComponent**>(item->start_), reinterpret_cast<LogicComponent**>(item->end_));
+}
+
 LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
-    delayedStartCalled_(false)
+    threadedUpdateMask_(0),
+    currentThreadedMask_(0),
+    delayedStartCalled_(false),
+    threadedUpdateIndex_(M_MAX_UNSIGNED),
+    threadedFixedUpdateIndex_(M_MAX_UNSIGNED)
 {
 }
 
@@ -74,6 +88,16 @@ void LogicComponent::SetUpdateEventMask(unsigned char mask)
     }
 }
 
+void LogicComponent::SetThreadedUpdateMask(unsigned char mask)
+{
+    mask &= USE_UPDATE | USE_FIXEDUPDATE;
+    if (threadedUpdateMask_ != mask)
+    {
+        threadedUpdateMask_ = mask;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -87,6 +111,8 @@ void LogicComponent::OnNodeSet(Node* node)
     {
         // We are being detached from a node: execute user-defined stop function and prepare for destruction
         Stop();
+        SetThreadedUpdate(0, USE_UPDATE, false);
+        SetThreadedUpdate(0, USE_FIXEDUPDATE, false);
     }
 }
 
@@ -106,24 +132,28 @@ void LogicComponent::UpdateEventSubscription()
     bool enabled = IsEnabledEffective();
     
     bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
+    // Delayed start is always called through the update event. After it a thread-safe update moves to the scene's batches
+    bool threadedUpdate = needUpdate && delayedStartCalled_ && (threadedUpdateMask_ & USE_UPDATE);
+    bool needUpdateEvent = needUpdate && !threadedUpdate;
+    if (needUpdateEvent && !(currentEventMask_ & USE_UPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, HANDLER(LogicComponent, HandleSceneUpdate));
+        SubscribeToEvent(scene, TYPED_HANDLER(LogicComponent, HandleSceneUpdate));
         currentEventMask_ |= USE_UPDATE;
     }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
+    else if (!needUpdateEvent && (currentEventMask_ & USE_UPDATE))
     {
         UnsubscribeFromEvent(scene, E_SCENEUPDATE);
         currentEventMask_ &= ~USE_UPDATE;
     }
+    SetThreadedUpdate(scene, USE_UPDATE, threadedUpdate);
     
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
     if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, HANDLER(LogicComponent, HandleScenePostUpdate));
+        SubscribeToEvent(scene, TYPED_HANDLER(LogicComponent, HandleScenePostUpdate));
         currentEventMask_ |= USE_POSTUPDATE;
     }
-    else if (!needUpdate && (currentEventMask_ & USE_POSTUPDATE))
+    else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
     {
         UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
         currentEventMask_ &= ~USE_POSTUPDATE;
@@ -135,21 +165,24 @@ void LogicComponent::UpdateEventSubscription()
         return;
 
     bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
-    if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
+    bool threadedFixedUpdate = needFixedUpdate && (threadedUpdateMask_ & USE_FIXEDUPDATE);
+    bool needFixedUpdateEvent = needFixedUpdate && !threadedFixedUpdate;
+    if (needFixedUpdateEvent && !(currentEventMask_ & USE_FIXEDUPDATE))
     {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, HANDLER(LogicComponent, HandlePhysicsPreStep));
+        SubscribeToEvent(world, TYPED_HANDLER(LogicComponent, HandlePhysicsPreStep));
         currentEventMask_ |= USE_FIXEDUPDATE;
     }
-    else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
+    else if (!needFixedUpdateEvent && (currentEventMask_ & USE_FIXEDUPDATE))
     {
         UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
         currentEventMask_ &= ~USE_FIXEDUPDATE;
     }
+    SetThreadedUpdate(scene, USE_FIXEDUPDATE, threadedFixedUpdate);
     
     bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
     if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
     {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, HANDLER(LogicComponent, HandlePhysicsPostStep));
+        SubscribeToEvent(world, TYPED_HANDLER(LogicComponent, HandlePhysicsPostStep));
         currentEventMask_ |= USE_FIXEDPOSTUPDATE;
     }
     else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
@@ -160,10 +193,25 @@ void LogicComponent::UpdateEventSubscription()
 #endif 
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::SetThreadedUpdate(Scene* scene, unsigned char updateEvent, bool enable)
+{
+    if (enable && !(currentThreadedMask_ & updateEvent))
+    {
+        scene->AddThreadedLogic(this, updateEvent);
+        threadedScene_ = scene;
+        currentThreadedMask_ |= updateEvent;
+    }
+    else if (!enable && (currentThreadedMask_ & updateEvent))
+    {
+        // The node may already have been removed from the scene, so use the stored scene
+        if (threadedScene_)
+            threadedScene_->RemoveThreadedLogic(this, updateEvent);
+        currentThreadedMask_ &= ~updateEvent;
+    }
+}
+
+void LogicComponent::HandleSceneUpdate(SceneUpdateEventData& eventData)
 {
-    using namespace SceneUpdate;
-    
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
@@ -177,36 +225,190 @@ void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventDa
             currentEventMask_ &= ~USE_UPDATE;
             return;
         }
+        
+        // If the update is thread-safe, move to the scene's threaded update, which runs after this event
+        if (threadedUpdateMask_ & USE_UPDATE)
+        {
+            UpdateEventSubscription();
+            return;
+        }
     }
     
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleScenePostUpdate(ScenePostUpdateEventData& eventData)
 {
-    using namespace ScenePostUpdate;
-    
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(eventData.timeStep_);
 }
 
 #ifdef URHO3D_PHYSICS
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandlePhysicsPreStep(PhysicsPreStepEventData& eventData)
 {
-    using namespace PhysicsPreStep;
-    
     // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
+    FixedUpdate(eventData.timeStep_);
 }
 
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandlePhysicsPostStep(PhysicsPostStepEventData& eventData)
 {
-    using namespace PhysicsPostStep;
-    
     // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
+    FixedPostUpdate(eventData.timeStep_);
 }
 #endif
 
+LogicComponentBatches::LogicComponentBatches(unsigned char updateEvent) :
+    numComponents_(0),
+    timeStep_(0.0f),
+    updateEvent_(updateEvent),
+    updating_(false),
+    removed_(false)
+{
+}
+
+void LogicComponentBatches::Add(LogicComponent* component)
+{
+    // Do not modify the batches while they are being iterated
+    if (updating_)
+    {
+        GetIndex(component) = M_MAX_UNSIGNED;
+        pendingComponents_.Push(component);
+    }
+    else
+    {
+        PODVector<LogicComponent*>& batch = batches_[component->GetType()];
+        GetIndex(component) = batch.Size();
+        batch.Push(component);
+    }
+
+    ++numComponents_;
+}
+
+void LogicComponentBatches::Remove(LogicComponent* component)
+{
+    unsigned& index = GetIndex(component);
+    if (index == M_MAX_UNSIGNED)
+    {
+        if (!pendingComponents_.Remove(component))
+            return;
+    }
+    else
+    {
+        PODVector<LogicComponent*>& batch = batches_[component->GetType()];
+        if (updating_)
+        {
+            // Leave an empty slot to be compacted after the update
+            batch[index] = 0;
+            removed_ = true;
+        }
+        else
+        {
+            // Move the last component into the freed slot
+            LogicComponent* last = batch.Back();
+            batch[index] = last;
+            GetIndex(last) = index;
+            batch.Pop();
+        }
+    }
+
+    index = M_MAX_UNSIGNED;
+    --numComponents_;
+}
+
+void LogicComponentBatches::Update(WorkQueue* queue, float timeStep)
+{
+    timeStep_ = timeStep;
+    updating_ = true;
+
+    if (queue)
+    {
+        // Each batch contains components of one type only, and is split into work items of its own
+        unsigned numItems = (queue->GetNumThreads() + 1) * ITEMS_PER_THREAD;
+        for (HashMap<StringHash, PODVector<LogicComponent*> >::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
+        {
+            PODVector<LogicComponent*>& batch = i->second_;
+            if (!batch.Empty())
+                queue->ParallelFor(UpdateLogicComponentsWork, batch.Begin(), batch.End(), this, (batch.Size() + numItems - 1) / numItems);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        // Without a work queue update serially in the calling thread
+        for (HashMap<StringHash, PODVector<LogicComponent*> >::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
+        {
+            PODVector<LogicComponent*>& batch = i->second_;
+            if (!batch.Empty())
+                UpdateRange(batch.Begin().ptr_, batch.End().ptr_);
+        }
+    }
+
+    updating_ = false;
+    Compact();
+}
+
+void LogicComponentBatches::UpdateRange(LogicComponent** start, LogicComponent** end) const
+{
+    if (updateEvent_ == USE_FIXEDUPDATE)
+    {
+        for (; start != end; ++start)
+        {
+            // Components removed during the update leave empty slots
+            if (*start)
+                (*start)->FixedUpdate(timeStep_);
+        }
+    }
+    else
+    {
+        for (; start != end; ++start)
+        {
+            if (*start)
+                (*start)->Update(timeStep_);
+        }
+    }
+}
+
+unsigned& LogicComponentBatches::GetIndex(LogicComponent* component) const
+{
+    return updateEvent_ == USE_FIXEDUPDATE ? component->threadedFixedUpdateIndex_ : component->threadedUpdateIndex_;
+}
+
+void LogicComponentBatches::Compact()
+{
+    if (removed_)
+    {
+        for (HashMap<StringHash, PODVector<LogicComponent*> >::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
+        {
+            PODVector<LogicComponent*>& batch = i->second_;
+            unsigned dest = 0;
+            for (unsigned j = 0; j < batch.Size(); ++j)
+            {
+                LogicComponent* component = batch[j];
+                if (component)
+                {
+                    batch[dest] = component;
+                    GetIndex(component) = dest++;
+                }
+            }
+            batch.Resize(dest);
+        }
+
+        removed_ = false;
+    }
+
+    if (!pendingComponents_.Empty())
+    {
+        for (unsigned i = 0; i < pendingComponents_.Size(); ++i)
+        {
+            LogicComponent* component = pendingComponents_[i];
+            PODVector<LogicComponent*>& batch = batches_[component->GetType()];
+            GetIndex(component) = batch.Size();
+            batch.Push(component);
+        }
+
+        pendingComponents_.Clear();
+    }
+}
+
 }
@@ -22,11 +22,18 @@
 
 #pragma once
 
+#include "../Container/HashMap.h"
 #include "../Scene/Component.h"
 
 namespace Urho3D
 {
 
+class WorkQueue;
+struct PhysicsPostStepEventData;
+struct PhysicsPreStepEventData;
+struct ScenePostUpdateEventData;
+struct SceneUpdateEventData;
+
 /// Bitmask for using the scene update event.
 static const unsigned char USE_UPDATE = 0x1;
 /// Bitmask for using the scene post-update event.
@@ -41,6 +48,8 @@ class URHO3D_API LogicComponent : public Component
 {
     OBJECT(LogicComponent);
     
+    friend class LogicComponentBatches;
+    
     /// Construct.
     LogicComponent(Context* context);
     /// Destruct.
@@ -65,9 +74,13 @@ class URHO3D_API LogicComponent : public Component
     
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(unsigned char mask);
+    /// Set which of Update() and FixedUpdate() are thread-safe and may be called in worker threads, batched with other components of the same type. Such an update function must only modify the component and its own scene node, must not create or remove nodes and components or change their enabled state, and should send events with Scene::DelayedSendEvent(). Like the update event mask, should be called in the subclass constructor.
+    void SetThreadedUpdateMask(unsigned char mask);
     
     /// Return what update events are subscribed to.
     unsigned char GetUpdateEventMask() const { return updateEventMask_; }
+    /// Return which update functions may be called in worker threads.
+    unsigned char GetThreadedUpdateMask() const { return threadedUpdateMask_; }
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
     
@@ -78,22 +91,75 @@ protected:
 private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
+    /// Add to or remove from the scene's threaded update batches.
+    void SetThreadedUpdate(Scene* scene, unsigned char updateEvent, bool enable);
     /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneUpdate(SceneUpdateEventData& eventData);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(ScenePostUpdateEventData& eventData);
 #ifdef URHO3D_PHYSICS
     /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
+    void HandlePhysicsPreStep(PhysicsPreStepEventData& eventData);
     /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
+    void HandlePhysicsPostStep(PhysicsPostStepEventData& eventData);
 #endif
     /// Requested event subscription mask.
     unsigned char updateEventMask_;
     /// Current event subscription mask.
     unsigned char currentEventMask_;
+    /// Requested threaded update mask.
+    unsigned char threadedUpdateMask_;
+    /// Current threaded update mask.
+    unsigned char currentThreadedMask_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Scene whose threaded update batches the component is in.
+    WeakPtr<Scene> threadedScene_;
+    /// Index in the threaded update batch.
+    unsigned threadedUpdateIndex_;
+    /// Index in the threaded fixed update batch.
+    unsigned threadedFixedUpdateIndex_;
+};
+
+/// Thread-safe logic components batched by type for one update event, to be updated in worker threads.
+class URHO3D_API LogicComponentBatches
+{
+public:
+    /// Construct for either USE_UPDATE or USE_FIXEDUPDATE.
+    LogicComponentBatches(unsigned char updateEvent);
+
+    /// Add a component.
+    void Add(LogicComponent* component);
+    /// Remove a component.
+    void Remove(LogicComponent* component);
+    /// Update all components, in worker threads if the work queue has them. Update serially if the work queue is null.
+    void Update(WorkQueue* queue, float timeStep);
+    /// Update a range of components of one batch. Called by Update(), possibly in a worker thread.
+    void UpdateRange(LogicComponent** start, LogicComponent** end) const;
+
+    /// Return number of components.
+    unsigned GetNumComponents() const { return numComponents_; }
+
+private:
+    /// Return the batch index of a component.
+    unsigned& GetIndex(LogicComponent* component) const;
+    /// Remove the slots of components removed during the update, and add the components added during it.
+    void Compact();
+
+    /// Components by type.
+    HashMap<StringHash, PODVector<LogicComponent*> > batches_;
+    /// Components added during the update.
+    PODVector<LogicComponent*> pendingComponents_;
+    /// Number of components.
+    unsigned numComponents_;
+    /// Timestep of the current update.
+    float timeStep_;
+    /// Update event.
+    unsigned char updateEvent_;
+    /// Update in progress flag.
+    bool updating_;
+    /// Components removed during the update flag.
+    bool removed_;
 };
 
 }
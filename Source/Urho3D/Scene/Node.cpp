@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "../Scene/BackgroundSceneLoader.h"
 #include "../Scene/Component.h"
 #include "../Core/Context.h"
 #include "../IO/Log.h"
@@ -30,6 +31,7 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
+#include "../Scene/TransformHierarchy.h"
 #include "../Scene/UnknownComponent.h"
 #include "../Resource/XMLFile.h"
 
@@ -48,6 +50,7 @@ Node::Node(Context* context) :
     parent_(0),
     scene_(0),
     id_(0),
+    transformIndex_(M_MAX_UNSIGNED),
     position_(Vector3::ZERO),
     rotation_(Quaternion::IDENTITY),
     scale_(Vector3::ONE),
@@ -77,8 +80,11 @@ void Node::RegisterObject(Context* context)
     ACCESSOR_ATTRIBUTE("Scale", GetScale, SetScale, Vector3, Vector3::ONE, AM_DEFAULT);
     ATTRIBUTE("Variables", VariantMap, vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     ACCESSOR_ATTRIBUTE("Network Position", GetNetPositionAttr, SetNetPositionAttr, Vector3, Vector3::ZERO, AM_NET | AM_LATESTDATA | AM_NOEDIT);
-    ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, PODVector<unsigned char>, Variant::emptyBuffer, AM_NET | AM_LATESTDATA | AM_NOEDIT);
+    ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, Quaternion, Quaternion::IDENTITY, AM_NET | AM_LATESTDATA | AM_NOEDIT);
     ACCESSOR_ATTRIBUTE("Network Parent Node", GetNetParentAttr, SetNetParentAttr, PODVector<unsigned char>, Variant::emptyBuffer, AM_NET | AM_NOEDIT);
+
+    // Send the rotation as the three smallest quaternion components
+    context->UpdateAttributeQuantization<Node>("Network Rotation", AttributeQuantization(AQ_SMALLESTTHREE, 15));
 }
 
 bool Node::Load(Deserializer& source, bool setInstanceDefault)
@@ -217,10 +223,20 @@ void Node::MarkNetworkUpdate()
 
 void Node::AddReplicationState(NodeReplicationState* state)
 {
-    if (!networkState_)
-        AllocateNetworkState();
-
-    networkState_->replicationStates_.Push(state);
+    // Connections may be updated in worker threads, which share the network state
+    if (!scene_ || !scene_->IsThreadedUpdate())
+    {
+        if (!networkState_)
+            AllocateNetworkState();
+        networkState_->replicationStates_.Push(state);
+    }
+    else
+    {
+        MutexLock lock(scene_->GetSceneMutex());
+        if (!networkState_)
+            AllocateNetworkState();
+        networkState_->replicationStates_.Push(state);
+    }
 }
 
 bool Node::SaveXML(Serializer& dest, const String& indentation) const
@@ -541,21 +557,23 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
-    dirty_ = true;
+    // If already dirty, the child nodes are dirty as well and the listeners have been notified
+    if (dirty_)
+        return;
 
-    // Notify listener components first, then mark child nodes
-    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    // With flat transform storage the scene marks the subtree without recursion
+    if (scene_)
     {
-        if (*i)
-        {
-            (*i)->OnMarkedDirty(this);
-            ++i;
-        }
-        // If listener has expired, erase from list
-        else
-            i = listeners_.Erase(i);
+        TransformHierarchy* hierarchy = scene_->GetTransformHierarchy();
+        if (hierarchy && hierarchy->MarkDirty(this))
+            return;
     }
 
+    dirty_ = true;
+
+    // Notify listener components first, then mark child nodes
+    NotifyListeners();
+
     for (Vector<SharedPtr<Node> >::Iterator i = children_.Begin(); i != children_.End(); ++i)
         (*i)->MarkDirty();
 }
@@ -614,6 +632,8 @@ void Node::AddChild(Node* node, unsigned index)
         scene_->NodeAdded(node);
 
     node->parent_ = this;
+    if (scene_)
+        scene_->NodeReparented();
     node->MarkDirty();
     node->MarkNetworkUpdate();
 
@@ -1087,14 +1107,13 @@ void Node::SetNetPositionAttr(const Vector3& value)
         SetPosition(value);
 }
 
-void Node::SetNetRotationAttr(const PODVector<unsigned char>& value)
+void Node::SetNetRotationAttr(const Quaternion& value)
 {
-    MemoryBuffer buf(value);
     SmoothedTransform* transform = GetComponent<SmoothedTransform>();
     if (transform)
-        transform->SetTargetRotation(buf.ReadPackedQuaternion());
+        transform->SetTargetRotation(value);
     else
-        SetRotation(buf.ReadPackedQuaternion());
+        SetRotation(value);
 }
 
 void Node::SetNetParentAttr(const PODVector<unsigned char>& value)
@@ -1139,11 +1158,9 @@ const Vector3& Node::GetNetPositionAttr() const
     return position_;
 }
 
-const PODVector<unsigned char>& Node::GetNetRotationAttr() const
+const Quaternion& Node::GetNetRotationAttr() const
 {
-    attrBuffer_.Clear();
-    attrBuffer_.WritePackedQuaternion(rotation_);
-    return attrBuffer_.GetBuffer();
+    return rotation_;
 }
 
 const PODVector<unsigned char>& Node::GetNetParentAttr() const
@@ -1262,6 +1279,41 @@ bool Node::LoadXML(const XMLElement& source, SceneResolver& resolver, bool readC
     return true;
 }
 
+bool Node::LoadStaged(const StagedNodeTree& source, unsigned& nodeIndex, unsigned& componentIndex, SceneResolver& resolver,
+    bool rewriteIDs, CreateMode mode)
+{
+    // ID has been applied at the parent level, which also creates the child nodes
+    const StagedNode& staged = source.nodes_[nodeIndex++];
+    if (!LoadValues(staged.attributes_))
+        return false;
+
+    for (unsigned i = 0; i < staged.numComponents_; ++i)
+    {
+        const StagedComponent& stagedComp = source.components_[componentIndex++];
+        unsigned compID = stagedComp.id_;
+        Component* newComponent = SafeCreateComponent(stagedComp.typeName_, stagedComp.type_,
+            (mode == REPLICATED && compID < FIRST_LOCAL_ID) ? REPLICATED : LOCAL, rewriteIDs ? 0 : compID);
+        if (newComponent)
+        {
+            resolver.AddComponent(compID, newComponent);
+            // The decoded values can only be used if the component uses the attributes they were decoded with
+            if (stagedComp.decoded_ && newComponent->GetAttributes() == context_->GetAttributes(stagedComp.type_))
+                newComponent->LoadValues(stagedComp.attributes_);
+            else if (stagedComp.element_)
+                newComponent->LoadXML(stagedComp.element_);
+            else
+            {
+                MemoryBuffer compBuffer(stagedComp.data_);
+                compBuffer.ReadStringHash();
+                compBuffer.ReadUInt();
+                newComponent->Load(compBuffer);
+            }
+        }
+    }
+
+    return true;
+}
+
 
 void Node::PrepareNetworkUpdate()
 {
@@ -1304,6 +1356,7 @@ void Node::PrepareNetworkUpdate()
     }
 
     // Check for attribute changes
+    DirtyBits changedAttributes;
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
@@ -1316,6 +1369,7 @@ void Node::PrepareNetworkUpdate()
         if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            changedAttributes.Set(i);
 
             // Mark the attribute dirty in all replication states that are tracking this node
             for (PODVector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin(); j !=
@@ -1335,6 +1389,8 @@ void Node::PrepareNetworkUpdate()
         }
     }
 
+    CacheNetworkUpdate(changedAttributes);
+
     // Finally check for user var changes
     for (VariantMap::ConstIterator i = vars_.Begin(); i != vars_.End(); ++i)
     {
@@ -1678,6 +1734,21 @@ void Node::UpdateWorldTransform() const
     dirty_ = false;
 }
 
+void Node::NotifyListeners()
+{
+    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    {
+        if (*i)
+        {
+            (*i)->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list
+        else
+            i = listeners_.Erase(i);
+    }
+}
+
 void Node::RemoveChild(Vector<SharedPtr<Node> >::Iterator i)
 {
     // Send change event. Do not send when already being destroyed
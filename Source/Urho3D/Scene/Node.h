@@ -35,6 +35,7 @@ class Scene;
 class SceneResolver;
 
 struct NodeReplicationState;
+struct StagedNodeTree;
 
 /// Component and child node creation mode for networking.
 enum CreateMode
@@ -58,6 +59,7 @@ class URHO3D_API Node : public Animatable
     BASEOBJECT(Node);
 
     friend class Connection;
+    friend class TransformHierarchy;
 
 public:
     /// Construct.
@@ -426,19 +428,21 @@ public:
     /// Set network position attribute.
     void SetNetPositionAttr(const Vector3& value);
     /// Set network rotation attribute.
-    void SetNetRotationAttr(const PODVector<unsigned char>& value);
+    void SetNetRotationAttr(const Quaternion& value);
     /// Set network parent attribute.
     void SetNetParentAttr(const PODVector<unsigned char>& value);
     /// Return network position attribute.
     const Vector3& GetNetPositionAttr() const;
     /// Return network rotation attribute.
-    const PODVector<unsigned char>& GetNetRotationAttr() const;
+    const Quaternion& GetNetRotationAttr() const;
     /// Return network parent attribute.
     const PODVector<unsigned char>& GetNetParentAttr() const;
     /// Load components and optionally load child nodes.
     bool Load(Deserializer& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false, CreateMode mode = REPLICATED);
     /// Load components from XML data and optionally load child nodes.
     bool LoadXML(const XMLElement& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false, CreateMode mode = REPLICATED);
+    /// Load attributes and components from decoded data. The node and component indices are advanced past the loaded data. Child nodes are not loaded.
+    bool LoadStaged(const StagedNodeTree& source, unsigned& nodeIndex, unsigned& componentIndex, SceneResolver& resolver, bool rewriteIDs = false, CreateMode mode = REPLICATED);
     /// Return the depended on nodes to order network updates.
     const PODVector<Node*>& GetDependencyNodes() const { return dependencyNodes_; }
     /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
@@ -484,6 +488,8 @@ private:
     Component* SafeCreateComponent(const String& typeName, StringHash type, CreateMode mode, unsigned id);
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Notify listener components of the world transform having changed, and erase expired listeners.
+    void NotifyListeners();
     /// Remove child node by iterator.
     void RemoveChild(Vector<SharedPtr<Node> >::Iterator i);
     /// Return child nodes recursively.
@@ -513,6 +519,8 @@ private:
     Scene* scene_;
     /// Unique ID within the scene.
     unsigned id_;
+    /// Index in the scene's flat transform storage.
+    unsigned transformIndex_;
     /// Position.
     Vector3 position_;
     /// Rotation.
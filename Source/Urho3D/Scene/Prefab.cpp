@@ -0,0 +1,204 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../IO/Deserializer.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+#include "../Resource/XMLFile.h"
+#include "../Scene/Component.h"
+#include "../Scene/Prefab.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneResolver.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Properties of a component type in a prefab.
+struct PrefabComponentType
+{
+    /// Whether the component can be loaded from the decoded attribute values.
+    bool useValues_;
+    /// Whether the component has node or component ID attributes.
+    bool hasIDAttributes_;
+};
+
+Prefab::Prefab(Context* context) :
+    Resource(context),
+    hasIDAttributes_(false)
+{
+}
+
+Prefab::~Prefab()
+{
+}
+
+void Prefab::RegisterObject(Context* context)
+{
+    context->RegisterFactory<Prefab>();
+}
+
+bool Prefab::BeginLoad(Deserializer& source)
+{
+    tree_.nodes_.Clear();
+    tree_.components_.Clear();
+    xmlFile_.Reset();
+    hasIDAttributes_ = false;
+    
+    // The data is the same as for Scene::Instantiate() or Scene::InstantiateXML(), depending on the file extension
+    if (GetExtension(source.GetName()) == ".xml")
+    {
+        xmlFile_ = new XMLFile(context_);
+        if (!xmlFile_->Load(source))
+            return false;
+        
+        if (!tree_.DecodeNodeXML(context_, xmlFile_->GetRoot()))
+            return false;
+    }
+    else if (!tree_.DecodeNode(context_, source))
+        return false;
+    
+    SetMemoryUse(source.GetSize());
+    return true;
+}
+
+bool Prefab::EndLoad()
+{
+    // Check each component type once using a temporary instance. Only components using the attributes registered for their
+    // type can be loaded from the decoded values. All decoded values are kept, so that the instances are the same as when
+    // instantiating from the source data
+    HashMap<StringHash, PrefabComponentType> types;
+    
+    for (unsigned i = 0; i < tree_.components_.Size(); ++i)
+    {
+        StagedComponent& component = tree_.components_[i];
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(component.type_);
+        
+        HashMap<StringHash, PrefabComponentType>::Iterator j = types.Find(component.type_);
+        if (j == types.End())
+        {
+            PrefabComponentType type;
+            SharedPtr<Component> instance;
+            instance.DynamicCast(context_->CreateObject(component.type_));
+            type.useValues_ = instance && attributes && instance->GetAttributes() == attributes;
+            // If the attributes are not known, assume that there are ID attributes
+            type.hasIDAttributes_ = !type.useValues_;
+            if (type.useValues_)
+            {
+                for (unsigned k = 0; k < attributes->Size(); ++k)
+                {
+                    if (attributes->At(k).mode_ & (AM_NODEID | AM_COMPONENTID | AM_NODEIDVECTOR))
+                        type.hasIDAttributes_ = true;
+                }
+            }
+            j = types.Insert(MakePair(component.type_, type));
+        }
+        
+        const PrefabComponentType& type = j->second_;
+        if (type.hasIDAttributes_)
+            hasIDAttributes_ = true;
+        
+        if (!type.useValues_ || !component.decoded_)
+        {
+            component.decoded_ = false;
+            component.attributes_.Clear();
+            continue;
+        }
+        
+        // The stored data is not needed for components loaded from the decoded values
+        component.data_.Clear();
+    }
+    
+    // Keep the XML file only if some component needs to be loaded from its XML element
+    bool needXML = false;
+    for (unsigned i = 0; i < tree_.components_.Size(); ++i)
+    {
+        if (!tree_.components_[i].decoded_)
+            needXML = true;
+    }
+    if (!needXML)
+    {
+        for (unsigned i = 0; i < tree_.components_.Size(); ++i)
+            tree_.components_[i].element_ = XMLElement::EMPTY;
+        xmlFile_.Reset();
+    }
+    
+    return true;
+}
+
+Node* Prefab::Instantiate(Node* parent, CreateMode mode) const
+{
+    PROFILE(InstantiatePrefab);
+    
+    if (!parent)
+    {
+        LOGERROR("Null parent node for instantiating prefab " + GetName());
+        return 0;
+    }
+    if (tree_.nodes_.Empty())
+    {
+        LOGERROR("Prefab " + GetName() + " is not loaded");
+        return 0;
+    }
+    
+    SceneResolver resolver;
+    unsigned nodeIndex = 0;
+    unsigned componentIndex = 0;
+    // Rewrite IDs when instantiating
+    Node* node = parent->CreateChild(0, mode);
+    if (LoadNode(node, nodeIndex, componentIndex, resolver, mode))
+    {
+        if (hasIDAttributes_)
+            resolver.Resolve();
+        node->ApplyAttributes();
+        return node;
+    }
+    else
+    {
+        node->Remove();
+        return 0;
+    }
+}
+
+bool Prefab::LoadNode(Node* node, unsigned& nodeIndex, unsigned& componentIndex, SceneResolver& resolver, CreateMode mode) const
+{
+    const StagedNode& staged = tree_.nodes_[nodeIndex];
+    resolver.AddNode(staged.id_, node);
+    if (!node->LoadStaged(tree_, nodeIndex, componentIndex, resolver, true, mode))
+        return false;
+    
+    for (unsigned i = 0; i < staged.numChildren_; ++i)
+    {
+        unsigned childID = tree_.nodes_[nodeIndex].id_;
+        Node* newNode = node->CreateChild(0, (mode == REPLICATED && childID < FIRST_LOCAL_ID) ? REPLICATED : LOCAL);
+        if (!LoadNode(newNode, nodeIndex, componentIndex, resolver, mode))
+            return false;
+    }
+    
+    return true;
+}
+
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Resource/Resource.h"
+#include "../Scene/BackgroundSceneLoader.h"
+#include "../Scene/Node.h"
+
+namespace Urho3D
+{
+
+class SceneResolver;
+class XMLFile;
+
+/// Node hierarchy decoded once from binary or XML data for fast repeated instantiation.
+class URHO3D_API Prefab : public Resource
+{
+    OBJECT(Prefab);
+    
+public:
+    /// Construct.
+    Prefab(Context* context);
+    /// Destruct.
+    virtual ~Prefab();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+    
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    virtual bool BeginLoad(Deserializer& source);
+    /// Finish resource loading. Always called from the main thread. Return true if successful.
+    virtual bool EndLoad();
+    
+    /// Instantiate as a child node with new IDs. Return the new node, or null if failed.
+    Node* Instantiate(Node* parent, CreateMode mode = REPLICATED) const;
+    
+    /// Return number of nodes in the hierarchy.
+    unsigned GetNumNodes() const { return tree_.nodes_.Size(); }
+    /// Return number of components in the hierarchy.
+    unsigned GetNumComponents() const { return tree_.components_.Size(); }
+    
+private:
+    /// Load a node's attributes and components, then instantiate its child nodes.
+    bool LoadNode(Node* node, unsigned& nodeIndex, unsigned& componentIndex, SceneResolver& resolver, CreateMode mode) const;
+    
+    /// Decoded nodes and components.
+    StagedNodeTree tree_;
+    /// XML file for XML mode. Kept for components that need to be loaded from their XML element.
+    SharedPtr<XMLFile> xmlFile_;
+    /// Whether the components may have node or component ID attributes that need to be resolved.
+    bool hasIDAttributes_;
+};
+
+}
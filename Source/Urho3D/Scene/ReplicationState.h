@@ -26,6 +26,7 @@
 #include "../Container/HashMap.h"
 #include "../Container/HashSet.h"
 #include "../Container/Ptr.h"
+#include "../IO/VectorBuffer.h"
 #include "../Math/StringHash.h"
 
 #include <cstring>
@@ -126,7 +127,9 @@ struct URHO3D_API NetworkState
 {
     /// Construct with defaults.
     NetworkState() :
-        interceptMask_(0)
+        interceptMask_(0),
+        deltaCached_(false),
+        latestDataCached_(false)
     {
     }
 
@@ -142,6 +145,16 @@ struct URHO3D_API NetworkState
     VariantMap previousVars_;
     /// Bitmask for intercepting network messages. Used on the client only.
     unsigned long long interceptMask_;
+    /// Attributes encoded in the delta update cache.
+    DirtyBits deltaCacheBits_;
+    /// Delta update attribute data encoded once for all connections on the latest change.
+    VectorBuffer deltaCache_;
+    /// Latest data attribute values encoded once for all connections on the latest change.
+    VectorBuffer latestDataCache_;
+    /// Delta update cache valid flag.
+    bool deltaCached_;
+    /// Latest data cache valid flag.
+    bool latestDataCached_;
 };
 
 /// Base class for per-user network replication states.
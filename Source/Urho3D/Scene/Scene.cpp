@@ -27,6 +27,7 @@
 #include "../IO/Log.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../IO/PackageFile.h"
+#include "../Scene/Prefab.h"
 #include "../Core/Profiler.h"
 #include "../Scene/ReplicationState.h"
 #include "../Resource/ResourceCache.h"
@@ -52,8 +53,23 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
 
+void SceneUpdateEventData::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[SceneUpdate::P_SCENE] = scene_;
+    eventData[SceneUpdate::P_TIMESTEP] = timeStep_;
+}
+
+void ScenePostUpdateEventData::ToVariantMap(VariantMap& eventData) const
+{
+    eventData[ScenePostUpdate::P_SCENE] = scene_;
+    eventData[ScenePostUpdate::P_TIMESTEP] = timeStep_;
+}
+
 Scene::Scene(Context* context) :
     Node(context),
+    threadedUpdates_(USE_UPDATE),
+    threadedFixedUpdates_(USE_FIXEDUPDATE),
+    transformHierarchy_(this),
     replicatedNodeID_(FIRST_REPLICATED_ID),
     replicatedComponentID_(FIRST_REPLICATED_ID),
     localNodeID_(FIRST_LOCAL_ID),
@@ -66,27 +82,34 @@ Scene::Scene(Context* context) :
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    flatTransforms_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, HANDLER(Scene, HandleUpdate));
+    SubscribeToEvent(TYPED_HANDLER(Scene, HandleUpdate));
     SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, HANDLER(Scene, HandleResourceBackgroundLoaded));
 }
 
 Scene::~Scene()
 {
+    // Stop the background decoding thread, if any
+    StopAsyncLoading();
+
+    // Do not maintain the flat transform order while the nodes are being removed
+    flatTransforms_ = false;
+
     // Remove root-level components first, so that scene subsystems such as the octree destroy themselves. This will speed up
     // the removal of child nodes' components
     RemoveAllComponents();
     RemoveAllChildren();
 
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->ResetScene();
-    for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         i->second_->ResetScene();
 }
 
@@ -189,7 +212,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -297,8 +320,11 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
             return false;
         }
 
-        // Then prepare to load child nodes in the async updates
+        // Then decode the child nodes in a background thread, and load them from the decoded data in the async updates
         asyncProgress_.totalNodes_ = file->ReadVLE();
+        asyncProgress_.loader_ = new BackgroundSceneLoader(context_, file, asyncProgress_.totalNodes_);
+        // If threads are not available, the decoding will be done in the async updates instead
+        asyncProgress_.loader_->Run();
     }
     else
     {
@@ -383,6 +409,15 @@ bool Scene::LoadAsyncXML(File* file, LoadMode mode)
 void Scene::StopAsyncLoading()
 {
     asyncLoading_ = false;
+    // Stop decoding before releasing the file
+    if (asyncProgress_.loader_)
+    {
+        asyncProgress_.loader_->Stop();
+        asyncProgress_.loader_.Reset();
+    }
+    asyncProgress_.stagedNodes_.Clear();
+    asyncProgress_.stagedParents_.Clear();
+    asyncProgress_.stagedIndex_ = asyncProgress_.stagedNodeIndex_ = asyncProgress_.stagedComponentIndex_ = 0;
     asyncProgress_.file_.Reset();
     asyncProgress_.xmlFile_.Reset();
     asyncProgress_.xmlElement_ = XMLElement::EMPTY;
@@ -445,6 +480,56 @@ Node* Scene::InstantiateXML(Deserializer& source, const Vector3& position, const
     return InstantiateXML(xml->GetRoot(), position, rotation, mode);
 }
 
+Node* Scene::Instantiate(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode)
+{
+    if (!prefab)
+    {
+        LOGERROR("Null prefab for instantiation");
+        return 0;
+    }
+
+    Node* node = prefab->Instantiate(this, mode);
+    if (node)
+        node->SetTransform(position, rotation);
+    return node;
+}
+
+void Scene::Instantiate(Prefab* prefab, const PODVector<Vector3>& positions, const PODVector<Quaternion>& rotations,
+    PODVector<Node*>& dest, CreateMode mode)
+{
+    PROFILE(InstantiatePrefabs);
+
+    dest.Clear();
+    if (!prefab)
+    {
+        LOGERROR("Null prefab for instantiation");
+        return;
+    }
+
+    // Reserve the ID maps once for all instances to avoid rehashing while instantiating
+    unsigned numNodes = positions.Size() * prefab->GetNumNodes();
+    unsigned numComponents = positions.Size() * prefab->GetNumComponents();
+    if (mode == REPLICATED)
+    {
+        replicatedNodes_.Reserve(replicatedNodes_.Size() + numNodes);
+        replicatedComponents_.Reserve(replicatedComponents_.Size() + numComponents);
+    }
+    else
+    {
+        localNodes_.Reserve(localNodes_.Size() + numNodes);
+        localComponents_.Reserve(localComponents_.Size() + numComponents);
+    }
+
+    dest.Reserve(positions.Size());
+    for (unsigned i = 0; i < positions.Size(); ++i)
+    {
+        Node* node = prefab->Instantiate(this, mode);
+        if (node)
+            node->SetTransform(positions[i], i < rotations.Size() ? rotations[i] : Quaternion::IDENTITY);
+        dest.Push(node);
+    }
+}
+
 void Scene::Clear(bool clearReplicated, bool clearLocal)
 {
     StopAsyncLoading();
@@ -502,6 +587,15 @@ void Scene::SetAsyncLoadingMs(int ms)
     asyncLoadingMs_ = Max(ms, 1);
 }
 
+void Scene::SetFlatTransforms(bool enable)
+{
+    if (enable != flatTransforms_)
+    {
+        flatTransforms_ = enable;
+        transformHierarchy_.MarkOrderDirty();
+    }
+}
+
 void Scene::SetElapsedTime(float time)
 {
     elapsedTime_ = time;
@@ -540,7 +634,7 @@ Node* Scene::GetNode(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End())
             return i->second_;
         else
@@ -548,7 +642,7 @@ Node* Scene::GetNode(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
         if (i != localNodes_.End())
             return i->second_;
         else
@@ -560,7 +654,7 @@ Component* Scene::GetComponent(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End())
             return i->second_;
         else
@@ -568,7 +662,7 @@ Component* Scene::GetComponent(unsigned id) const
     }
     else
     {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
         if (i != localComponents_.End())
             return i->second_;
         else
@@ -607,16 +701,19 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
-    using namespace SceneUpdate;
+    // Update variable timestep logic
+    SceneUpdateEventData updateData(this, timeStep);
+    SendTypedEvent(updateData);
+
+    // Update thread-safe logic components in worker threads
+    UpdateThreadedLogic(USE_UPDATE, timeStep);
+
+    // Update scene attribute animation.
+    using namespace AttributeAnimationUpdate;
 
     VariantMap& eventData = GetEventDataMap();
     eventData[P_SCENE] = this;
     eventData[P_TIMESTEP] = timeStep;
-
-    // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
-
-    // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
@@ -637,7 +734,11 @@ void Scene::Update(float timeStep)
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    ScenePostUpdateEventData postUpdateData(this, timeStep);
+    SendTypedEvent(postUpdateData);
+
+    // Update the world transforms of nodes moved during the update
+    UpdateTransforms();
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -645,10 +746,20 @@ void Scene::Update(float timeStep)
     elapsedTime_ += timeStep;
 }
 
+void Scene::UpdateTransforms()
+{
+    if (flatTransforms_)
+    {
+        PROFILE(UpdateTransforms);
+        transformHierarchy_.Update();
+    }
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
-    if (GetSubsystem<WorkQueue>()->GetNumThreads())
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads())
         threadedUpdate_ = true;
 }
 
@@ -667,6 +778,25 @@ void Scene::EndThreadedUpdate()
             (*i)->OnMarkedDirty((*i)->GetNode());
         delayedDirtyComponents_.Clear();
     }
+
+    if (!delayedEvents_.Empty())
+    {
+        PROFILE(SendDelayedEvents);
+
+        // Event handlers may queue more events or destroy the senders. Take the queue and hold weak references to the
+        // senders, which were all alive at the end of the threaded update
+        Vector<DelayedEvent> events;
+        events.Swap(delayedEvents_);
+        Vector<WeakPtr<Object> > senders(events.Size());
+        for (unsigned i = 0; i < events.Size(); ++i)
+            senders[i] = events[i].sender_;
+
+        for (unsigned i = 0; i < events.Size(); ++i)
+        {
+            if (senders[i])
+                senders[i]->SendEvent(events[i].eventType_, events[i].eventData_);
+        }
+    }
 }
 
 void Scene::DelayedMarkedDirty(Component* component)
@@ -675,6 +805,52 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::DelayedSendEvent(Object* sender, StringHash eventType, VariantMap& eventData)
+{
+    if (!threadedUpdate_)
+    {
+        sender->SendEvent(eventType, eventData);
+        return;
+    }
+
+    MutexLock lock(sceneMutex_);
+    delayedEvents_.Resize(delayedEvents_.Size() + 1);
+    DelayedEvent& event = delayedEvents_.Back();
+    event.sender_ = sender;
+    event.eventType_ = eventType;
+    event.eventData_ = eventData;
+}
+
+void Scene::AddThreadedLogic(LogicComponent* component, unsigned char updateEvent)
+{
+    if (updateEvent == USE_FIXEDUPDATE)
+        threadedFixedUpdates_.Add(component);
+    else
+        threadedUpdates_.Add(component);
+}
+
+void Scene::RemoveThreadedLogic(LogicComponent* component, unsigned char updateEvent)
+{
+    if (updateEvent == USE_FIXEDUPDATE)
+        threadedFixedUpdates_.Remove(component);
+    else
+        threadedUpdates_.Remove(component);
+}
+
+void Scene::UpdateThreadedLogic(unsigned char updateEvent, float timeStep)
+{
+    LogicComponentBatches& batches = updateEvent == USE_FIXEDUPDATE ? threadedFixedUpdates_ : threadedUpdates_;
+    if (!batches.GetNumComponents())
+        return;
+
+    PROFILE(UpdateThreadedLogic);
+
+    // Components marked dirty by the updates delay their non-threadsafe work to the end of the threaded update
+    BeginThreadedUpdate();
+    batches.Update(GetSubsystem<WorkQueue>(), timeStep);
+    EndThreadedUpdate();
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -754,6 +930,8 @@ void Scene::NodeAdded(Node* node)
     }
 
     node->SetScene(this);
+    if (flatTransforms_)
+        transformHierarchy_.MarkOrderDirty();
 
     // If the new node has an ID of zero (default), assign a replicated ID now
     unsigned id = node->GetID();
@@ -766,7 +944,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -780,7 +958,7 @@ void Scene::NodeAdded(Node* node)
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
         if (i != localNodes_.End() && i->second_ != node)
         {
             LOGWARNING("Overwriting node with ID " + String(id));
@@ -807,6 +985,8 @@ void Scene::NodeRemoved(Node* node)
 
     node->SetID(0);
     node->SetScene(0);
+    if (flatTransforms_)
+        transformHierarchy_.MarkOrderDirty();
     // Remove components and child nodes as well
     const Vector<SharedPtr<Component> >& components = node->GetComponents();
     for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
@@ -816,6 +996,12 @@ void Scene::NodeRemoved(Node* node)
         NodeRemoved(*i);
 }
 
+void Scene::NodeReparented()
+{
+    if (flatTransforms_)
+        transformHierarchy_.MarkOrderDirty();
+}
+
 void Scene::ComponentAdded(Component* component)
 {
     if (!component)
@@ -824,7 +1010,7 @@ void Scene::ComponentAdded(Component* component)
     unsigned id = component->GetID();
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -835,7 +1021,7 @@ void Scene::ComponentAdded(Component* component)
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
         if (i != localComponents_.End() && i->second_ != component)
         {
             LOGWARNING("Overwriting component with ID " + String(id));
@@ -902,16 +1088,20 @@ void Scene::PrepareNetworkUpdate()
 
     networkUpdateNodes_.Clear();
     networkUpdateComponents_.Clear();
+
+    // Update dirty world transforms now, so that connections building their updates in worker threads only read them
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+        i->second_->GetWorldTransform();
 }
 
 void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
         i->second_->CleanupConnection(connection);
 }
 
@@ -958,12 +1148,10 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void Scene::HandleUpdate(UpdateEventData& eventData)
 {
-    using namespace Update;
-
     if (updateEnabled_)
-        Update(eventData[P_TIMESTEP].GetFloat());
+        Update(eventData.timeStep_);
 }
 
 void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
@@ -999,14 +1187,67 @@ void Scene::UpdateAsyncLoading()
             return;
         }
 
-        // Read one child node with its full sub-hierarchy either from binary or XML
-        /// \todo Works poorly in scenes where one root-level child node contains all content
+        // Load one node from the decoded binary data, so that also large root-level child nodes are spread over several frames
         if (!asyncProgress_.xmlFile_)
         {
-            unsigned nodeID = asyncProgress_.file_->ReadUInt();
-            Node* newNode = CreateChild(nodeID, nodeID < FIRST_LOCAL_ID ? REPLICATED : LOCAL);
-            resolver_.AddNode(nodeID, newNode);
-            newNode->Load(*asyncProgress_.file_, resolver_);
+            BackgroundSceneLoader* loader = asyncProgress_.loader_;
+            if (asyncProgress_.stagedIndex_ >= asyncProgress_.stagedNodes_.Size())
+            {
+                // Check for finish before taking the decoded nodes, so that no nodes decoded in between are missed
+                bool decodingFinished = loader->IsFinished();
+                asyncProgress_.stagedNodes_.Clear();
+                asyncProgress_.stagedIndex_ = 0;
+                if (!loader->IsStarted())
+                    loader->DecodeNextNode();
+                loader->TakeDecodedNodes(asyncProgress_.stagedNodes_);
+
+                if (asyncProgress_.stagedNodes_.Empty())
+                {
+                    // Finish early if decoding failed, else wait for the decoding thread
+                    if (decodingFinished)
+                    {
+                        FinishAsyncLoading();
+                        return;
+                    }
+                    else
+                        break;
+                }
+            }
+
+            const StagedNodeTree& tree = asyncProgress_.stagedNodes_[asyncProgress_.stagedIndex_];
+            Vector<Pair<WeakPtr<Node>, unsigned> >& parents = asyncProgress_.stagedParents_;
+            Node* parent = this;
+            if (!parents.Empty())
+            {
+                parent = parents.Back().first_;
+                --parents.Back().second_;
+            }
+
+            // If the parent has been removed during loading, skip the rest of the root-level child node
+            bool success = false;
+            if (parent)
+            {
+                const StagedNode& staged = tree.nodes_[asyncProgress_.stagedNodeIndex_];
+                Node* newNode = parent->CreateChild(staged.id_, staged.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL);
+                resolver_.AddNode(staged.id_, newNode);
+                success = newNode->LoadStaged(tree, asyncProgress_.stagedNodeIndex_, asyncProgress_.stagedComponentIndex_,
+                    resolver_);
+                if (success && staged.numChildren_)
+                    parents.Push(MakePair(WeakPtr<Node>(newNode), staged.numChildren_));
+            }
+
+            while (!parents.Empty() && !parents.Back().second_)
+                parents.Pop();
+
+            if (!success || parents.Empty())
+            {
+                // Move on to the next root-level child node
+                parents.Clear();
+                ++asyncProgress_.stagedIndex_;
+                asyncProgress_.stagedNodeIndex_ = 0;
+                asyncProgress_.stagedComponentIndex_ = 0;
+                ++asyncProgress_.loadedNodes_;
+            }
         }
         else
         {
@@ -1015,10 +1256,9 @@ void Scene::UpdateAsyncLoading()
             resolver_.AddNode(nodeID, newNode);
             newNode->LoadXML(asyncProgress_.xmlElement_, resolver_);
             asyncProgress_.xmlElement_ = asyncProgress_.xmlElement_.GetNext("node");
+            ++asyncProgress_.loadedNodes_;
         }
 
-        ++asyncProgress_.loadedNodes_;
-
         // Break if time limit exceeded, so that we keep sufficient FPS
         if (asyncLoadTimer.GetUSec(false) >= asyncLoadingMs_ * 1000)
             break;
@@ -1040,6 +1280,10 @@ void Scene::FinishAsyncLoading()
 {
     if (asyncProgress_.mode_ > LOAD_RESOURCES_ONLY)
     {
+        // Make sure the decoding thread no longer accesses the file
+        if (asyncProgress_.loader_)
+            asyncProgress_.loader_->Stop();
+
         resolver_.Resolve();
         ApplyAttributes();
         FinishLoading(asyncProgress_.file_);
@@ -1227,6 +1471,7 @@ void RegisterSceneLibrary(Context* context)
 {
     ValueAnimation::RegisterObject(context);
     ObjectAnimation::RegisterObject(context);
+    Prefab::RegisterObject(context);
     Node::RegisterObject(context);
     Scene::RegisterObject(context);
     SmoothedTransform::RegisterObject(context);
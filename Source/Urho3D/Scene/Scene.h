@@ -22,10 +22,14 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashSet.h"
 #include "../Core/Mutex.h"
+#include "../Scene/BackgroundSceneLoader.h"
+#include "../Scene/LogicComponent.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
+#include "../Scene/TransformHierarchy.h"
 #include "../Resource/XMLElement.h"
 
 namespace Urho3D
@@ -33,6 +37,8 @@ namespace Urho3D
 
 class File;
 class PackageFile;
+class Prefab;
+struct UpdateEventData;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -55,6 +61,18 @@ struct AsyncProgress
 {
     /// File for binary mode.
     SharedPtr<File> file_;
+    /// Background decoder of the root-level child nodes for binary mode. Must be destroyed before the file.
+    SharedPtr<BackgroundSceneLoader> loader_;
+    /// Decoded root-level child nodes for binary mode.
+    Vector<StagedNodeTree> stagedNodes_;
+    /// Index of the next decoded root-level child node to load.
+    unsigned stagedIndex_;
+    /// Index of the next node to load within the current decoded root-level child node.
+    unsigned stagedNodeIndex_;
+    /// Index of the next component to load within the current decoded root-level child node.
+    unsigned stagedComponentIndex_;
+    /// Loaded nodes of the current decoded root-level child node with the number of child nodes they have left to load.
+    Vector<Pair<WeakPtr<Node>, unsigned> > stagedParents_;
     /// XML file for XML mode.
     SharedPtr<XMLFile> xmlFile_;
     /// Current XML element for XML mode.
@@ -73,6 +91,17 @@ struct AsyncProgress
     unsigned totalNodes_;
 };
 
+/// Event queued during a threaded update.
+struct DelayedEvent
+{
+    /// Sender.
+    Object* sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Event parameters.
+    VariantMap eventData_;
+};
+
 /// Root scene node, represents the whole scene.
 class URHO3D_API Scene : public Node
 {
@@ -116,6 +145,11 @@ public:
     Node* InstantiateXML(const XMLElement& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
     /// Instantiate scene content from XML data. Return root node if successful.
     Node* InstantiateXML(Deserializer& source, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate a prefab. Return root node if successful.
+    Node* Instantiate(Prefab* prefab, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+    /// Instantiate a prefab at several positions, reserving the ID maps for all instances at once. Missing rotations default to identity. Null pointers are returned for failed instances.
+    void Instantiate(Prefab* prefab, const PODVector<Vector3>& positions, const PODVector<Quaternion>& rotations, PODVector<Node*>& dest,
+        CreateMode mode = REPLICATED);
     /// Clear scene completely of either replicated, local or all nodes and components.
     void Clear(bool clearReplicated = true, bool clearLocal = true);
     /// Enable or disable scene update.
@@ -130,6 +164,8 @@ public:
     void SetSnapThreshold(float threshold);
     /// Set maximum milliseconds per frame to spend on async scene loading.
     void SetAsyncLoadingMs(int ms);
+    /// Set whether to keep node world transforms in flat storage, updated in one pass at the end of the scene update. Speeds up dirty marking and transform calculation in scenes with many moving or deeply parented nodes.
+    void SetFlatTransforms(bool enable);
     /// Add a required package file for networking. To be called on the server.
     void AddRequiredPackageFile(PackageFile* package);
     /// Clear required package files.
@@ -167,6 +203,10 @@ public:
     float GetSnapThreshold() const { return snapThreshold_; }
     /// Return maximum milliseconds per frame to spend on async loading.
     int GetAsyncLoadingMs() const { return asyncLoadingMs_; }
+    /// Return whether node world transforms are kept in flat storage.
+    bool GetFlatTransforms() const { return flatTransforms_; }
+    /// Return the flat transform storage, or null if not in use.
+    TransformHierarchy* GetTransformHierarchy() { return flatTransforms_ ? &transformHierarchy_ : 0; }
     /// Return required package files.
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
     /// Return a node user variable name, or empty if not registered.
@@ -174,14 +214,26 @@ public:
 
     /// Update scene. Called by HandleUpdate.
     void Update(float timeStep);
+    /// Update the world transforms of dirty nodes if using flat transform storage. Called by Update, can also be called manually after moving nodes outside the scene update.
+    void UpdateTransforms();
     /// Begin a threaded update. During threaded update components can choose to delay dirty processing.
     void BeginThreadedUpdate();
     /// End a threaded update. Notify components that marked themselves for delayed dirty processing.
     void EndThreadedUpdate();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Queue an event to be sent from the main thread when the threaded update ends. Is thread-safe. Outside a threaded update the event is sent immediately.
+    void DelayedSendEvent(Object* sender, StringHash eventType, VariantMap& eventData);
+    /// Add a thread-safe logic component to the threaded update batches of an update event (USE_UPDATE or USE_FIXEDUPDATE.)
+    void AddThreadedLogic(LogicComponent* component, unsigned char updateEvent);
+    /// Remove a logic component from the threaded update batches of an update event.
+    void RemoveThreadedLogic(LogicComponent* component, unsigned char updateEvent);
+    /// Update the thread-safe logic components of an update event in worker threads. Called by Update() for USE_UPDATE and by the physics world for USE_FIXEDUPDATE.
+    void UpdateThreadedLogic(unsigned char updateEvent, float timeStep);
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
+    /// Return the mutex for modifying shared scene data during a threaded update.
+    Mutex& GetSceneMutex() { return sceneMutex_; }
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -190,6 +242,8 @@ public:
     void NodeAdded(Node* node);
     /// Node removed. Remove from ID map.
     void NodeRemoved(Node* node);
+    /// Node parent changed. Invalidate the flat transform order.
+    void NodeReparented();
     /// Component added. Add to ID map.
     void ComponentAdded(Component* component);
     /// Component removed. Remove from ID map.
@@ -211,7 +265,7 @@ public:
 
 private:
     /// Handle the logic update event to update the scene, if active.
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleUpdate(UpdateEventData& eventData);
     /// Handle a background loaded resource completing.
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
@@ -228,13 +282,13 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    FlatHashMap<unsigned, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    FlatHashMap<unsigned, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    FlatHashMap<unsigned, Component*> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
+    FlatHashMap<unsigned, Component*> localComponents_;
     /// Asynchronous loading progress.
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
@@ -251,10 +305,18 @@ private:
     HashSet<unsigned> networkUpdateComponents_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
-    /// Mutex for the delayed dirty notification queue.
+    /// Events queued during threaded update.
+    Vector<DelayedEvent> delayedEvents_;
+    /// Thread-safe logic components for the scene update.
+    LogicComponentBatches threadedUpdates_;
+    /// Thread-safe logic components for the physics update.
+    LogicComponentBatches threadedFixedUpdates_;
+    /// Mutex for the delayed dirty notification queue and other shared data during threaded update.
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
+    /// Flat storage of node world transforms.
+    TransformHierarchy transformHierarchy_;
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
@@ -281,6 +343,8 @@ private:
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Flat transform storage in use flag.
+    bool flatTransforms_;
 };
 
 /// Register Scene library objects.
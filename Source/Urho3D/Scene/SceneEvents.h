@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -34,6 +36,27 @@ EVENT(E_SCENEUPDATE, SceneUpdate)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the variable timestep scene update event.
+struct URHO3D_API SceneUpdateEventData
+{
+    TYPED_EVENT(E_SCENEUPDATE);
+    
+    /// Construct.
+    SceneUpdateEventData(Scene* scene, float timeStep) :
+        scene_(scene),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+    
+    /// Scene.
+    Scene* scene_;
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Scene subsystem update.
 EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
@@ -93,6 +116,27 @@ EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed data of the variable timestep scene post-update event.
+struct URHO3D_API ScenePostUpdateEventData
+{
+    TYPED_EVENT(E_SCENEPOSTUPDATE);
+    
+    /// Construct.
+    ScenePostUpdateEventData(Scene* scene, float timeStep) :
+        scene_(scene),
+        timeStep_(timeStep)
+    {
+    }
+    
+    /// Fill the event parameters for VariantMap event handlers.
+    void ToVariantMap(VariantMap& eventData) const;
+    
+    /// Scene.
+    Scene* scene_;
+    /// Timestep.
+    float timeStep_;
+};
+
 /// Asynchronous scene loading progress.
 EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
@@ -21,6 +21,7 @@
 //
 
 #include "../Core/Context.h"
+#include "../IO/BitStream.h"
 #include "../IO/Deserializer.h"
 #include "../IO/Log.h"
 #include "../Scene/ReplicationState.h"
@@ -52,6 +53,130 @@ static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, con
     return netAttrIndex; // Could not remap
 }
 
+static unsigned GetNumQuantizedComponents(VariantType type)
+{
+    switch (type)
+    {
+    case VAR_FLOAT:
+        return 1;
+
+    case VAR_VECTOR2:
+        return 2;
+
+    case VAR_VECTOR3:
+        return 3;
+
+    case VAR_VECTOR4:
+    case VAR_QUATERNION:
+        return 4;
+
+    default:
+        return 0;
+    }
+}
+
+static bool IsQuantized(const AttributeInfo& attr)
+{
+    const AttributeQuantization& quantization = attr.quantization_;
+    if (quantization.mode_ == AQ_NONE || !GetNumQuantizedComponents(attr.type_))
+        return false;
+
+    return quantization.mode_ != AQ_SMALLESTTHREE || attr.type_ == VAR_QUATERNION;
+}
+
+static void WriteQuantizedValue(BitWriter& writer, VariantType type, const Variant& value, const AttributeQuantization& quantization)
+{
+    if (quantization.mode_ == AQ_SMALLESTTHREE)
+    {
+        writer.WriteSmallestThreeQuaternion(value.GetQuaternion(), quantization.bits_);
+        return;
+    }
+
+    float floatValue;
+    const float* data;
+    switch (type)
+    {
+    case VAR_FLOAT:
+        floatValue = value.GetFloat();
+        data = &floatValue;
+        break;
+
+    case VAR_VECTOR2:
+        data = value.GetVector2().Data();
+        break;
+
+    case VAR_VECTOR3:
+        data = value.GetVector3().Data();
+        break;
+
+    case VAR_VECTOR4:
+        data = value.GetVector4().Data();
+        break;
+
+    case VAR_QUATERNION:
+        data = value.GetQuaternion().Data();
+        break;
+
+    default:
+        return;
+    }
+
+    unsigned numComponents = GetNumQuantizedComponents(type);
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        if (quantization.mode_ == AQ_RANGE)
+            writer.WriteQuantizedFloat(data[i], quantization.min_, quantization.max_, quantization.bits_);
+        else
+            writer.WriteHalfFloat(data[i]);
+    }
+}
+
+static void ReadQuantizedValue(BitReader& reader, VariantType type, const AttributeQuantization& quantization, float* dest)
+{
+    if (quantization.mode_ == AQ_SMALLESTTHREE)
+    {
+        Quaternion value = reader.ReadSmallestThreeQuaternion(quantization.bits_);
+        dest[0] = value.w_;
+        dest[1] = value.x_;
+        dest[2] = value.y_;
+        dest[3] = value.z_;
+        return;
+    }
+
+    unsigned numComponents = GetNumQuantizedComponents(type);
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        if (quantization.mode_ == AQ_RANGE)
+            dest[i] = reader.ReadQuantizedFloat(quantization.min_, quantization.max_, quantization.bits_);
+        else
+            dest[i] = reader.ReadHalfFloat();
+    }
+}
+
+static Variant MakeQuantizedValue(VariantType type, const float* data)
+{
+    switch (type)
+    {
+    case VAR_FLOAT:
+        return Variant(data[0]);
+
+    case VAR_VECTOR2:
+        return Variant(Vector2(data));
+
+    case VAR_VECTOR3:
+        return Variant(Vector3(data));
+
+    case VAR_VECTOR4:
+        return Variant(Vector4(data));
+
+    case VAR_QUATERNION:
+        return Variant(Quaternion(data));
+
+    default:
+        return Variant::EMPTY;
+    }
+}
+
 Serializable::Serializable(Context* context) :
     Object(context),
     networkState_(0),
@@ -286,6 +411,33 @@ bool Serializable::Load(Deserializer& source, bool setInstanceDefault)
     return true;
 }
 
+bool Serializable::LoadValues(const Vector<Variant>& values)
+{
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return true;
+
+    unsigned index = 0;
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+
+        if (index >= values.Size())
+        {
+            LOGERROR("Could not load " + GetTypeName() + ", not enough attribute values");
+            return false;
+        }
+
+        const Variant& value = values[index++];
+        if (!value.IsEmpty())
+            OnSetAttribute(attr, value);
+    }
+
+    return true;
+}
+
 bool Serializable::Save(Serializer& dest) const
 {
     const Vector<AttributeInfo>* attributes = GetAttributes();
@@ -569,6 +721,58 @@ void Serializable::AllocateNetworkState()
     }
 }
 
+void Serializable::CacheNetworkUpdate(const DirtyBits& changedAttributes)
+{
+    if (!networkState_ || !networkState_->attributes_ || !changedAttributes.Count())
+        return;
+
+    // If no connection is tracking the object, just invalidate the caches as the values have changed
+    if (networkState_->replicationStates_.Empty())
+    {
+        networkState_->deltaCached_ = false;
+        networkState_->latestDataCached_ = false;
+        return;
+    }
+
+    const Vector<AttributeInfo>* attributes = networkState_->attributes_;
+    unsigned numAttributes = attributes->Size();
+
+    // Separate the latest data attributes, as they are always sent all at once
+    DirtyBits deltaBits(changedAttributes);
+    bool latestDataChanged = false;
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (deltaBits.IsSet(i) && (attributes->At(i).mode_ & AM_LATESTDATA))
+        {
+            deltaBits.Clear(i);
+            latestDataChanged = true;
+        }
+    }
+
+    // Encode the same data as WriteDeltaUpdate() and WriteLatestDataUpdate() without the timestamp, which is per connection
+    if (deltaBits.Count())
+    {
+        VectorBuffer& cache = networkState_->deltaCache_;
+        cache.Clear();
+        cache.Write(deltaBits.data_, (numAttributes + 7) >> 3);
+        for (unsigned i = 0; i < numAttributes; ++i)
+        {
+            if (deltaBits.IsSet(i))
+                cache.WriteVariantData(networkState_->currentValues_[i]);
+        }
+
+        networkState_->deltaCacheBits_ = deltaBits;
+        networkState_->deltaCached_ = true;
+    }
+
+    if (latestDataChanged)
+    {
+        networkState_->latestDataCache_.Clear();
+        WriteLatestData(networkState_->latestDataCache_);
+        networkState_->latestDataCached_ = true;
+    }
+}
+
 void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeStamp)
 {
     if (!networkState_)
@@ -620,6 +824,15 @@ void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attribute
     // First write the change bitfield, then attribute data for changed attributes
     // Note: the attribute bits should not contain LATESTDATA attributes
     dest.WriteUByte(timeStamp);
+
+    // Usually all connections have the same attributes dirty, in which case copy the data encoded for them
+    const NetworkState* state = networkState_;
+    if (state->deltaCached_ && !memcmp(attributeBits.data_, state->deltaCacheBits_.data_, MAX_NETWORK_ATTRIBUTES / 8))
+    {
+        dest.Write(state->deltaCache_.GetData(), state->deltaCache_.GetSize());
+        return;
+    }
+
     dest.Write(attributeBits.data_, (numAttributes + 7) >> 3);
 
     for (unsigned i = 0; i < numAttributes; ++i)
@@ -641,14 +854,41 @@ void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeSta
     if (!attributes)
         return;
 
-    unsigned numAttributes = attributes->Size();
-
     dest.WriteUByte(timeStamp);
 
+    if (networkState_->latestDataCached_)
+        dest.Write(networkState_->latestDataCache_.GetData(), networkState_->latestDataCache_.GetSize());
+    else
+        WriteLatestData(dest);
+}
+
+void Serializable::WriteLatestData(Serializer& dest) const
+{
+    const Vector<AttributeInfo>* attributes = networkState_->attributes_;
+    unsigned numAttributes = attributes->Size();
+    bool quantizedWritten = false;
+
     for (unsigned i = 0; i < numAttributes; ++i)
     {
-        if (attributes->At(i).mode_ & AM_LATESTDATA)
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_LATESTDATA))
+            continue;
+
+        if (!IsQuantized(attr))
             dest.WriteVariantData(networkState_->currentValues_[i]);
+        else if (!quantizedWritten)
+        {
+            // Pack all quantized attributes into one bit stream at the position of the first
+            BitWriter writer(dest);
+            for (unsigned j = i; j < numAttributes; ++j)
+            {
+                const AttributeInfo& quantizedAttr = attributes->At(j);
+                if ((quantizedAttr.mode_ & AM_LATESTDATA) && IsQuantized(quantizedAttr))
+                    WriteQuantizedValue(writer, quantizedAttr.type_, networkState_->currentValues_[j], quantizedAttr.quantization_);
+            }
+            writer.Flush();
+            quantizedWritten = true;
+        }
     }
 }
 
@@ -706,14 +946,48 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
     unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
     unsigned char timeStamp = source.ReadUByte();
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    // Components of the quantized attributes, which are all read at once
+    float quantizedData[MAX_NETWORK_ATTRIBUTES * 4];
+    unsigned quantizedOffset = 0;
+    bool quantizedRead = false;
+
+    for (unsigned i = 0; i < numAttributes; ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
         if (attr.mode_ & AM_LATESTDATA)
         {
+            // At the end of the data only the quantized values, which have already been read, can still be applied
+            if (source.IsEof() && !(quantizedRead && IsQuantized(attr)))
+                break;
+
+            Variant value;
+            if (!IsQuantized(attr))
+                value = source.ReadVariant(attr.type_);
+            else
+            {
+                if (!quantizedRead)
+                {
+                    BitReader reader(source);
+                    unsigned offset = 0;
+                    for (unsigned j = i; j < numAttributes; ++j)
+                    {
+                        const AttributeInfo& quantizedAttr = attributes->At(j);
+                        if ((quantizedAttr.mode_ & AM_LATESTDATA) && IsQuantized(quantizedAttr))
+                        {
+                            ReadQuantizedValue(reader, quantizedAttr.type_, quantizedAttr.quantization_, quantizedData + offset);
+                            offset += GetNumQuantizedComponents(quantizedAttr.type_);
+                        }
+                    }
+                    quantizedRead = true;
+                }
+
+                value = MakeQuantizedValue(attr.type_, quantizedData + quantizedOffset);
+                quantizedOffset += GetNumQuantizedComponents(attr.type_);
+            }
+
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, value);
                 changed = true;
             }
             else
@@ -725,7 +999,7 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = value;
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
@@ -66,6 +66,8 @@ public:
     virtual bool LoadXML(const XMLElement& source, bool setInstanceDefault = false);
     /// Save as XML data. Return true if successful.
     virtual bool SaveXML(XMLElement& dest) const;
+    /// Load from already decoded attribute values, in the order of the file attributes. Empty values are skipped. Return true if successful.
+    virtual bool LoadValues(const Vector<Variant>& values);
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     virtual void ApplyAttributes() {}
     /// Return whether should save default-valued attributes into XML. Default false.
@@ -87,6 +89,8 @@ public:
     void SetInterceptNetworkUpdate(const String& attributeName, bool enable);
     /// Allocate network attribute state.
     void AllocateNetworkState();
+    /// Encode the changed network attributes once to be copied by all connections. Called after checking for attribute changes.
+    void CacheNetworkUpdate(const DirtyBits& changedAttributes);
     /// Write initial delta network update.
     void WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeStamp);
     /// Write a delta network update according to dirty attribute bits.
@@ -122,6 +126,8 @@ protected:
     NetworkState* networkState_;
 
 private:
+    /// Write the latest data attributes of the network state, bit-packing the quantized attributes.
+    void WriteLatestData(Serializer& dest) const;
     /// Set instance-level default value. Allocate the internal data structure as necessary.
     void SetInstanceDefault(const String& name, const Variant& defaultValue);
     /// Get instance-level default value.
@@ -21,6 +21,7 @@
 //
 
 #include "../Core/Context.h"
+#include "../Core/Timer.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
@@ -30,10 +31,16 @@
 namespace Urho3D
 {
 
+static const float DEFAULT_EXTRAPOLATION_LIMIT = 0.25f;
+static const unsigned MAX_SNAPSHOTS = 32;
+
 SmoothedTransform::SmoothedTransform(Context* context) :
     Component(context),
     targetPosition_(Vector3::ZERO),
     targetRotation_(Quaternion::IDENTITY),
+    interpolationDelay_(0.0f),
+    extrapolationLimit_(DEFAULT_EXTRAPOLATION_LIMIT),
+    snapshotFrame_(0),
     smoothingMask_(SMOOTH_NONE),
     subscribed_(false)
 {
@@ -46,11 +53,16 @@ SmoothedTransform::~SmoothedTransform()
 void SmoothedTransform::RegisterObject(Context* context)
 {
     context->RegisterFactory<SmoothedTransform>();
+
+    ACCESSOR_ATTRIBUTE("Interpolation Delay", GetInterpolationDelay, SetInterpolationDelay, float, 0.0f, AM_DEFAULT);
+    ACCESSOR_ATTRIBUTE("Extrapolation Limit", GetExtrapolationLimit, SetExtrapolationLimit, float, DEFAULT_EXTRAPOLATION_LIMIT, AM_DEFAULT);
 }
 
 void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
 {
-    if (smoothingMask_ && node_)
+    if (interpolationDelay_ > 0.0f)
+        UpdateSnapshots();
+    else if (smoothingMask_ && node_)
     {
         Vector3 position = node_->GetPosition();
         Quaternion rotation = node_->GetRotation();
@@ -100,14 +112,10 @@ void SmoothedTransform::SetTargetPosition(const Vector3& position)
 {
     targetPosition_ = position;
     smoothingMask_ |= SMOOTH_POSITION;
+    if (interpolationDelay_ > 0.0f)
+        AddSnapshot();
 
-    // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
-    {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
-    }
-
+    SubscribeToSmoothing();
     SendEvent(E_TARGETPOSITION);
 }
 
@@ -115,14 +123,26 @@ void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
 {
     targetRotation_ = rotation;
     smoothingMask_ |= SMOOTH_ROTATION;
+    if (interpolationDelay_ > 0.0f)
+        AddSnapshot();
 
-    if (!subscribed_)
+    SubscribeToSmoothing();
+    SendEvent(E_TARGETROTATION);
+}
+
+void SmoothedTransform::SetInterpolationDelay(float delay)
+{
+    delay = Max(delay, 0.0f);
+    if (delay != interpolationDelay_)
     {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
+        interpolationDelay_ = delay;
+        snapshots_.Clear();
     }
+}
 
-    SendEvent(E_TARGETROTATION);
+void SmoothedTransform::SetExtrapolationLimit(float limit)
+{
+    extrapolationLimit_ = Max(limit, 0.0f);
 }
 
 void SmoothedTransform::SetTargetWorldPosition(const Vector3& position)
@@ -176,4 +196,119 @@ void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap&
     Update(constant, squaredSnapThreshold);
 }
 
+void SmoothedTransform::AddSnapshot()
+{
+    Time* time = GetSubsystem<Time>();
+    if (!time)
+        return;
+
+    float now = time->GetElapsedTime();
+    float playbackTime = now - interpolationDelay_;
+    unsigned frameNumber = time->GetFrameNumber();
+
+    // Position and rotation of a network update are set separately, and updates received in the same frame are combined
+    if (snapshots_.Size() && snapshotFrame_ == frameNumber)
+    {
+        snapshots_.Back().position_ = targetPosition_;
+        snapshots_.Back().rotation_ = targetRotation_;
+        return;
+    }
+
+    TransformSnapshot snapshot;
+    snapshot.time_ = now;
+    snapshot.position_ = targetPosition_;
+    snapshot.rotation_ = targetRotation_;
+
+    Scene* scene = GetScene();
+    float snapThreshold = scene ? scene->GetSnapThreshold() : M_INFINITY;
+    Vector3 previousPosition = snapshots_.Size() ? snapshots_.Back().position_ : (node_ ? node_->GetPosition() : targetPosition_);
+
+    if ((targetPosition_ - previousPosition).LengthSquared() > snapThreshold * snapThreshold)
+    {
+        // Snap by playing back the new snapshot immediately
+        snapshots_.Clear();
+        snapshot.time_ = playbackTime;
+    }
+    else if (node_ && (snapshots_.Empty() || snapshots_.Back().time_ < playbackTime))
+    {
+        // Playback has caught up with the buffer, so start from the current transform to reach the new snapshot after the
+        // interpolation delay
+        snapshots_.Clear();
+        TransformSnapshot current;
+        current.time_ = playbackTime;
+        current.position_ = node_->GetPosition();
+        current.rotation_ = node_->GetRotation();
+        snapshots_.Push(current);
+    }
+
+    if (snapshots_.Size() >= MAX_SNAPSHOTS)
+        snapshots_.Erase(0, 1);
+    snapshots_.Push(snapshot);
+    snapshotFrame_ = frameNumber;
+}
+
+void SmoothedTransform::UpdateSnapshots()
+{
+    Time* time = GetSubsystem<Time>();
+    if (!node_ || !time || snapshots_.Empty())
+    {
+        smoothingMask_ = SMOOTH_NONE;
+        return;
+    }
+
+    float playbackTime = time->GetElapsedTime() - interpolationDelay_;
+
+    // Drop the snapshots older than the interval being played back, but keep two for extrapolation
+    unsigned numOld = 0;
+    while (numOld + 2 < snapshots_.Size() && snapshots_[numOld + 1].time_ <= playbackTime)
+        ++numOld;
+    if (numOld)
+        snapshots_.Erase(0, numOld);
+
+    Vector3 position;
+    Quaternion rotation;
+    bool finished = false;
+
+    if (snapshots_.Size() == 1 || playbackTime <= snapshots_[0].time_)
+    {
+        position = snapshots_[0].position_;
+        rotation = snapshots_[0].rotation_;
+        finished = snapshots_.Size() == 1 && playbackTime >= snapshots_[0].time_;
+    }
+    else
+    {
+        const TransformSnapshot& from = snapshots_[0];
+        const TransformSnapshot& to = snapshots_[1];
+
+        // If the next snapshot is late, extrapolate from the last two up to the limit
+        float time = playbackTime;
+        if (time >= to.time_)
+        {
+            time = Min(time, to.time_ + extrapolationLimit_);
+            finished = playbackTime >= to.time_ + extrapolationLimit_;
+        }
+
+        float t = to.time_ > from.time_ ? (time - from.time_) / (to.time_ - from.time_) : 1.0f;
+        position = from.position_.Lerp(to.position_, t);
+        rotation = from.rotation_.Slerp(to.rotation_, t);
+    }
+
+    if (smoothingMask_ & SMOOTH_POSITION)
+        node_->SetPosition(position);
+    if (smoothingMask_ & SMOOTH_ROTATION)
+        node_->SetRotation(rotation);
+
+    if (finished)
+        smoothingMask_ = SMOOTH_NONE;
+}
+
+void SmoothedTransform::SubscribeToSmoothing()
+{
+    if (!subscribed_)
+    {
+        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+        subscribed_ = true;
+    }
+}
+
 }
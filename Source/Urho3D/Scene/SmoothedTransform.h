@@ -34,7 +34,18 @@ static const unsigned SMOOTH_POSITION = 1;
 /// Ongoing rotation smoothing.
 static const unsigned SMOOTH_ROTATION = 2;
 
-/// Transform smoothing component for network updates.
+/// Received transform for snapshot interpolation.
+struct TransformSnapshot
+{
+    /// Receive time in seconds.
+    float time_;
+    /// Position in parent space.
+    Vector3 position_;
+    /// Rotation in parent space.
+    Quaternion rotation_;
+};
+
+/// Transform smoothing component for network updates. By default chases the latest target exponentially. With a nonzero interpolation delay, buffers the received targets and plays them back interpolated, delayed by that amount.
 class URHO3D_API SmoothedTransform : public Component
 {
     OBJECT(SmoothedTransform);
@@ -57,6 +68,10 @@ public:
     void SetTargetWorldPosition(const Vector3& position);
     /// Set target rotation in world space.
     void SetTargetWorldRotation(const Quaternion& rotation);
+    /// Set interpolation delay in seconds. Zero (default) disables the snapshot buffer. Should be at least the network update interval, more to tolerate jitter and lost updates.
+    void SetInterpolationDelay(float delay);
+    /// Set how long in seconds to extrapolate past the newest snapshot when updates are late.
+    void SetExtrapolationLimit(float limit);
     
     /// Return target position in parent space.
     const Vector3& GetTargetPosition() const { return targetPosition_; }
@@ -68,6 +83,12 @@ public:
     Quaternion GetTargetWorldRotation() const;
     /// Return whether smoothing is in progress.
     bool IsInProgress() const { return smoothingMask_ != 0; }
+    /// Return interpolation delay.
+    float GetInterpolationDelay() const { return interpolationDelay_; }
+    /// Return extrapolation limit.
+    float GetExtrapolationLimit() const { return extrapolationLimit_; }
+    /// Return number of buffered snapshots.
+    unsigned GetNumSnapshots() const { return snapshots_.Size(); }
     
 protected:
     /// Handle scene node being assigned at creation.
@@ -76,11 +97,25 @@ protected:
 private:
     /// Handle smoothing update event.
     void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    /// Add the current targets to the snapshot buffer.
+    void AddSnapshot();
+    /// Apply the snapshot buffer at the current playback time.
+    void UpdateSnapshots();
+    /// Subscribe to the smoothing update event if not yet subscribed.
+    void SubscribeToSmoothing();
     
     /// Target position.
     Vector3 targetPosition_;
     /// Target rotation.
     Quaternion targetRotation_;
+    /// Received snapshots, oldest first.
+    PODVector<TransformSnapshot> snapshots_;
+    /// Interpolation delay.
+    float interpolationDelay_;
+    /// Extrapolation limit.
+    float extrapolationLimit_;
+    /// Frame number of the newest snapshot.
+    unsigned snapshotFrame_;
     /// Active smoothing operations bitmask.
     unsigned char smoothingMask_;
     /// Subscribed to smoothing update event flag.
@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Container/Sort.h"
+#include "../Core/WorkQueue.h"
+#include "../Scene/Scene.h"
+#include "../Scene/TransformHierarchy.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Minimum number of dirty nodes to update in worker threads.
+static const unsigned MIN_THREADED_NODES = 1024;
+
+void UpdateTransformRangesWork(const WorkItem* item, unsigned threadIndex)
+{
+    TransformHierarchy* hierarchy = reinterpret_cast<TransformHierarchy*>(item->aux_);
+    TransformRange* start = reinterpret_cast<TransformRange*>(item->start_);
+    TransformRange* end = reinterpret_cast<TransformRange*>(item->end_);
+
+    while (start != end)
+        hierarchy->UpdateRange(*start++);
+}
+
+TransformHierarchy::TransformHierarchy(Scene* scene) :
+    scene_(scene),
+    orderDirty_(true)
+{
+}
+
+bool TransformHierarchy::MarkDirty(Node* node)
+{
+    unsigned index = node->transformIndex_;
+    if (orderDirty_ || index >= nodes_.Size() || nodes_[index] != node)
+        return false;
+
+    if (scene_->IsThreadedUpdate())
+    {
+        MutexLock lock(scene_->GetSceneMutex());
+        dirtyIndices_.Push(index);
+    }
+    else
+        dirtyIndices_.Push(index);
+
+    // The subtree is contiguous. A node that is already dirty has its whole subtree dirty, so it can be skipped
+    unsigned end = subtreeEnds_[index];
+    for (unsigned i = index; i < end;)
+    {
+        Node* current = nodes_[i];
+        if (current->dirty_)
+        {
+            i = subtreeEnds_[i];
+            continue;
+        }
+
+        current->dirty_ = true;
+        current->NotifyListeners();
+        ++i;
+    }
+
+    return true;
+}
+
+void TransformHierarchy::Update()
+{
+    if (orderDirty_)
+    {
+        RebuildOrder();
+        // The dirty indices refer to the old order. Check all nodes instead
+        dirtyIndices_.Clear();
+        dirtyRanges_.Clear();
+        if (nodes_.Size())
+        {
+            TransformRange range;
+            range.start_ = 0;
+            range.end_ = nodes_.Size();
+            dirtyRanges_.Push(range);
+        }
+    }
+    else
+        CollectDirtyRanges();
+
+    if (dirtyRanges_.Empty())
+        return;
+
+    unsigned numNodes = 0;
+    for (unsigned i = 0; i < dirtyRanges_.Size(); ++i)
+        numNodes += dirtyRanges_[i].end_ - dirtyRanges_[i].start_;
+
+    // The ranges are disjoint subtrees, so they can be updated in parallel
+    WorkQueue* queue = scene_->GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads() && dirtyRanges_.Size() > 1 && numNodes >= MIN_THREADED_NODES)
+    {
+        queue->ParallelFor(UpdateTransformRangesWork, dirtyRanges_.Begin(), dirtyRanges_.End(), this);
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < dirtyRanges_.Size(); ++i)
+            UpdateRange(dirtyRanges_[i]);
+    }
+
+    dirtyRanges_.Clear();
+}
+
+void TransformHierarchy::UpdateRange(const TransformRange& range)
+{
+    Node** nodes = &nodes_[0];
+    const unsigned* parents = &parents_[0];
+    Matrix3x4* worldTransforms = &worldTransforms_[0];
+    Quaternion* worldRotations = &worldRotations_[0];
+
+    for (unsigned i = range.start_; i < range.end_; ++i)
+    {
+        Node* node = nodes[i];
+
+        // A node cleaned by an on-demand world transform query is up to date, but its descendants may not be
+        if (!node->dirty_)
+        {
+            worldTransforms[i] = node->worldTransform_;
+            worldRotations[i] = node->worldRotation_;
+            continue;
+        }
+
+        unsigned parent = parents[i];
+        if (parent == M_MAX_UNSIGNED)
+        {
+            worldTransforms[i] = node->GetTransform();
+            worldRotations[i] = node->rotation_;
+        }
+        else if (parent >= range.start_)
+        {
+            worldTransforms[i] = worldTransforms[parent] * node->GetTransform();
+            worldRotations[i] = worldRotations[parent] * node->rotation_;
+        }
+        else
+        {
+            // Parent of the range root, which is outside all dirty ranges and therefore up to date
+            const Node* parentNode = node->parent_;
+            worldTransforms[i] = parentNode->worldTransform_ * node->GetTransform();
+            worldRotations[i] = parentNode->worldRotation_ * node->rotation_;
+        }
+
+        node->worldTransform_ = worldTransforms[i];
+        node->worldRotation_ = worldRotations[i];
+        node->dirty_ = false;
+    }
+}
+
+void TransformHierarchy::RebuildOrder()
+{
+    nodes_.Clear();
+    parents_.Clear();
+    subtreeEnds_.Clear();
+
+    // Depth-first traversal without recursion. The stack holds the nodes whose children still need to be added
+    PODVector<unsigned> stack;
+    const Vector<SharedPtr<Node> >& children = scene_->children_;
+    for (unsigned i = 0; i < children.Size(); ++i)
+    {
+        Node* root = children[i];
+        nodes_.Push(root);
+        parents_.Push(M_MAX_UNSIGNED);
+        subtreeEnds_.Push(0);
+        stack.Push(nodes_.Size() - 1);
+
+        while (stack.Size())
+        {
+            unsigned index = stack.Back();
+            Node* node = nodes_[index];
+            // Use the subtree end as the position in the child list until the node is finished
+            unsigned childIndex = subtreeEnds_[index];
+            if (childIndex < node->children_.Size())
+            {
+                subtreeEnds_[index] = childIndex + 1;
+                nodes_.Push(node->children_[childIndex]);
+                parents_.Push(index);
+                subtreeEnds_.Push(0);
+                stack.Push(nodes_.Size() - 1);
+            }
+            else
+            {
+                subtreeEnds_[index] = nodes_.Size();
+                stack.Pop();
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+        nodes_[i]->transformIndex_ = i;
+
+    worldTransforms_.Resize(nodes_.Size());
+    worldRotations_.Resize(nodes_.Size());
+    orderDirty_ = false;
+}
+
+void TransformHierarchy::CollectDirtyRanges()
+{
+    dirtyRanges_.Clear();
+    if (dirtyIndices_.Empty())
+        return;
+
+    // Sort the dirty roots into flat order, then skip those inside an already collected subtree
+    Sort(dirtyIndices_.Begin(), dirtyIndices_.End());
+
+    unsigned end = 0;
+    for (unsigned i = 0; i < dirtyIndices_.Size(); ++i)
+    {
+        unsigned index = dirtyIndices_[i];
+        if (index < end)
+            continue;
+
+        TransformRange range;
+        range.start_ = index;
+        range.end_ = end = subtreeEnds_[index];
+        dirtyRanges_.Push(range);
+    }
+
+    dirtyIndices_.Clear();
+}
+
+}
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2008-2015 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/Matrix3x4.h"
+#include "../Math/Quaternion.h"
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Range of nodes in the flat transform storage, consisting of complete subtrees.
+struct TransformRange
+{
+    /// Index of the first node.
+    unsigned start_;
+    /// Index one past the last node.
+    unsigned end_;
+};
+
+/// Flat storage of a scene's node world transforms in parent-before-child order. Each subtree occupies a contiguous index range, so a subtree can be marked dirty without recursion and the dirty nodes can be updated in one linear pass per frame, independent subtrees in parallel.
+class URHO3D_API TransformHierarchy
+{
+public:
+    /// Construct.
+    TransformHierarchy(Scene* scene);
+
+    /// Mark the node order dirty after the scene hierarchy has changed. The next update rebuilds the order and checks all nodes.
+    void MarkOrderDirty() { orderDirty_ = true; }
+    /// Mark a node and its subtree dirty. Return false if the node is not in the current order, in which case the caller should mark the subtree itself.
+    bool MarkDirty(Node* node);
+    /// Update the world transforms of the dirty nodes.
+    void Update();
+    /// Update a range of nodes. Called by Update(), possibly in a worker thread.
+    void UpdateRange(const TransformRange& range);
+
+    /// Return number of nodes in the current order.
+    unsigned GetNumNodes() const { return nodes_.Size(); }
+    /// Return number of pending dirty subtrees.
+    unsigned GetNumDirtySubtrees() const { return dirtyIndices_.Size(); }
+    /// Return whether the node order needs to be rebuilt.
+    bool IsOrderDirty() const { return orderDirty_; }
+
+private:
+    /// Rebuild the node order.
+    void RebuildOrder();
+    /// Collect the disjoint dirty subtree ranges.
+    void CollectDirtyRanges();
+
+    /// Scene.
+    Scene* scene_;
+    /// Nodes in parent-before-child order.
+    PODVector<Node*> nodes_;
+    /// Parent node indices, M_MAX_UNSIGNED for the scene's direct children.
+    PODVector<unsigned> parents_;
+    /// Indices one past the last node of each node's subtree.
+    PODVector<unsigned> subtreeEnds_;
+    /// World transforms.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// World rotations.
+    PODVector<Quaternion> worldRotations_;
+    /// Indices of the subtree roots marked dirty since the last update.
+    PODVector<unsigned> dirtyIndices_;
+    /// Dirty subtree ranges for the current update.
+    PODVector<TransformRange> dirtyRanges_;
+    /// Node order needs rebuild flag.
+    bool orderDirty_;
+};
+
+}
@@ -26,6 +26,7 @@
 #include "../Graphics/Geometry.h"
 #include "../IO/Log.h"
 #include "../Graphics/Material.h"
+#include "../Graphics/Octree.h"
 #include "../Scene/Node.h"
 #include "../Resource/ResourceCache.h"
 #include "../Graphics/Technique.h"
@@ -109,6 +110,9 @@ void Text3D::UpdateBatches(const FrameInfo& frame)
         customWorldTransform_ = Matrix3x4(worldPosition, frame.camera_->GetFaceCameraRotation(
             worldPosition, node_->GetWorldRotation(), faceCameraMode_), node_->GetWorldScale());
         worldBoundingBoxDirty_ = true;
+        // The bounding box depends on the camera, so the octant's packed copy can not be used for culling
+        if (octant_)
+            octant_->MarkDrawableBoundsDirty(this);
     }
 
     for (unsigned i = 0; i < batches_.Size(); ++i)